@@ -49,19 +49,37 @@ void libcdvsbflog_is_present(void) {}
 
 using namespace mpeg7cdvs;
 
+// number of existing clients: the first one opens the FFTW library, the last one closes it
+static int numClients = 0;
+
 CdvsClientBflog::CdvsClientBflog(const CdvsConfiguration * config, int mode):CdvsClientImpl(config, mode)
-{}
+{
+	#pragma omp critical (cdvs_bflog_clients)
+	if (numClients++ == 0)
+		FrequencyFilter::open_lib((params.fftwWisdom[0] != 0) ? params.fftwWisdom : NULL);
+}
 
 CdvsClientBflog::~CdvsClientBflog() {
+	#pragma omp critical (cdvs_bflog_clients)
+	if (--numClients == 0)
+		FrequencyFilter::close_lib();
 }
 
 
-unsigned int CdvsClientBflog::encode(CdvsDescriptor & cdvsDescriptor, int width, int height, const unsigned char * input) const
+unsigned int CdvsClientBflog::encode(CdvsDescriptor & cdvsDescriptor, int width, int height, const unsigned char * input, int originalWidth, int originalHeight) const
 {
 	cdvsDescriptor.clear();		// erase old data
 
 	AlpDetectorBF imagebuffer;
-	imagebuffer.read(width, height, input);
+	imagebuffer.read(width, height, input, originalWidth, originalHeight);
 	imagebuffer.resampleIfGreater(params.resizeMaxSize);
 	return cdvsDescriptor.encode(params, imagebuffer, g_factory);		// encode global and local descriptors
 }
+
+void CdvsClientBflog::describe(FeatureList & featurelist, const Parameters & detection, int width, int height, const unsigned char * input, int originalWidth, int originalHeight) const
+{
+	AlpDetectorBF imagebuffer;
+	imagebuffer.read(width, height, input, originalWidth, originalHeight);
+	imagebuffer.resampleIfGreater(detection.resizeMaxSize);
+	CdvsDescriptor::extractFeatures(featurelist, detection, imagebuffer);
+}
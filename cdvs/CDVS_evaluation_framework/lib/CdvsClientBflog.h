@@ -58,7 +58,12 @@ public:
 	CdvsClientBflog(const CdvsConfiguration * config, int mode);
 	virtual ~CdvsClientBflog();
 
-	virtual unsigned int encode(CdvsDescriptor & output, int width, int height, const unsigned char * input)  const;
+	using CdvsClientImpl::encode;
+
+	virtual unsigned int encode(CdvsDescriptor & output, int width, int height, const unsigned char * input, int originalWidth, int originalHeight)  const;
+
+protected:
+	virtual void describe(FeatureList & featurelist, const Parameters & detection, int width, int height, const unsigned char * input, int originalWidth, int originalHeight) const;
 };
 
 } // end namespace
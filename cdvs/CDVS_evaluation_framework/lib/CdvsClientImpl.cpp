@@ -45,6 +45,7 @@
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 
 using namespace mpeg7cdvs;
 
@@ -57,6 +58,8 @@ CdvsClientImpl::CdvsClientImpl(const CdvsConfiguration * config, int mode) {
 
 	params = config->getParameters(mode);
 	modeId = mode;
+	for (int m = 0; m <= 6; ++m)
+		modeParams.push_back(config->getParameters(m));
 	g_factory.init(params);					// initialize the global descriptor factory
 }
 
@@ -64,12 +67,115 @@ CdvsClientImpl::~CdvsClientImpl() {
 }
 
 unsigned int CdvsClientImpl::encode(CdvsDescriptor & cdvsDescriptor, int width, int height, const unsigned char * buffer) const
+{
+	return encode(cdvsDescriptor, width, height, buffer, width, height);
+}
+
+unsigned int CdvsClientImpl::encode(CdvsDescriptor & cdvsDescriptor, int width, int height, const unsigned char * buffer, int originalWidth, int originalHeight) const
 {
 	cdvsDescriptor.clear();		// erase old data
 
 	AlpDetector imagebuffer;
-	imagebuffer.read(width, height, buffer);
+	imagebuffer.read(width, height, buffer, originalWidth, originalHeight);
 	imagebuffer.resampleIfGreater(params.resizeMaxSize);
 	return cdvsDescriptor.encode(params, imagebuffer, g_factory);		// encode global and local descriptors
 }
 
+namespace {
+
+/*
+ * The settings determining a global descriptor signature, given the first features of an image.
+ */
+struct SignatureKey {
+	bool hasVariance;
+	bool hasBitSelection;
+	float threshold;
+	size_t numFeatures;
+
+	bool operator==(const SignatureKey & other) const {
+		return (hasVariance == other.hasVariance) && (hasBitSelection == other.hasBitSelection)
+				&& (threshold == other.threshold) && (numFeatures == other.numFeatures);
+	}
+};
+
+}  // end namespace
+
+void CdvsClientImpl::describe(FeatureList & featurelist, const Parameters & detection, int width, int height, const unsigned char * buffer, int originalWidth, int originalHeight) const
+{
+	AlpDetector imagebuffer;
+	imagebuffer.read(width, height, buffer, originalWidth, originalHeight);
+	imagebuffer.resampleIfGreater(detection.resizeMaxSize);
+	CdvsDescriptor::extractFeatures(featurelist, detection, imagebuffer);
+}
+
+unsigned int CdvsClientImpl::encodeMulti(std::vector<CdvsDescriptor> & outputs, const std::vector<int> & modes, int width, int height, const unsigned char * buffer, int originalWidth, int originalHeight) const
+{
+	for (size_t i = 0; i < modes.size(); ++i)
+		if ((modes[i] < 0) || (modes[i] > 6))
+			throw CdvsException("Mode ID out of range! must be in the range [0..6]");
+
+	outputs.clear();
+	outputs.resize(modes.size());
+	std::vector<bool> done(modes.size(), false);
+	unsigned int total = 0;
+
+	for (size_t i = 0; i < modes.size(); ++i)
+	{
+		if (done[i])
+			continue;
+
+		// group all the modes that produce the same key points; detect them once using the largest selectMaxPoints of the group
+
+		const Parameters & first = modeParams[modes[i]];
+		std::vector<size_t> group;
+		Parameters detection = first;
+		for (size_t j = i; j < modes.size(); ++j)
+		{
+			const Parameters & p = modeParams[modes[j]];
+			if ((!done[j]) && (p.resizeMaxSize == first.resizeMaxSize) && (p.lowMemStrips == first.lowMemStrips) && (p.lazyGradients == first.lazyGradients))
+			{
+				group.push_back(j);
+				done[j] = true;
+				detection.selectMaxPoints = std::max(detection.selectMaxPoints, p.selectMaxPoints);
+			}
+		}
+
+		FeatureList features;
+		describe(features, detection, width, height, buffer, originalWidth, originalHeight);
+
+		// encode each mode of the group, reusing the global signatures computed for the same settings
+
+		std::vector<SignatureKey> keys;			// settings of the global signatures computed so far
+		std::vector<size_t> owners;				// descriptors holding these signatures
+		for (size_t k = 0; k < group.size(); ++k)
+		{
+			const Parameters & p = modeParams[modes[group[k]]];
+			CdvsDescriptor & output = outputs[group[k]];
+			output.featurelist = features;
+			output.featurelist.selectFirst(p.selectMaxPoints);
+
+			SCFVFactory factory;
+			factory.init(p);
+
+			SignatureKey key;
+			key.hasVariance = factory.hasVariance();
+			key.hasBitSelection = factory.hasBitSelection();
+			key.threshold = p.scfvThreshold;
+			key.numFeatures = CdvsDescriptor::numGlobalFeatures(output.featurelist);
+
+			const SCFVSignature * signature = NULL;
+			for (size_t s = 0; (s < keys.size()) && (signature == NULL); ++s)
+				if (keys[s] == key)
+					signature = &outputs[owners[s]].scfvSignature;
+
+			total += output.encodeFeatures(p, factory, signature);
+			if (signature == NULL)
+			{
+				keys.push_back(key);
+				owners.push_back(group[k]);
+			}
+		}
+	}
+
+	return total;
+}
@@ -41,6 +41,7 @@
 #include "Parameters.h"
 #include "SCFVIndex.h"
 #include "CdvsDescriptor.h"
+#include <vector>
 
 namespace mpeg7cdvs
 {
@@ -56,12 +57,29 @@ protected:
 	SCFVFactory g_factory;	///< global descriptor factory for the query
 	Parameters params;		///< parameters used by this client
 	int modeId;				///< the mode ID used by this client
+	std::vector<Parameters> modeParams;	///< parameters of all modes, used by encodeMulti()
+
+	/**
+	 * Detect and describe the key points of an image using the detector of this client.
+	 * @param featurelist the output features (up to detection.selectMaxPoints)
+	 * @param detection the parameters used to resample the image and to detect the key points
+	 * @param width width of the decoded image
+	 * @param height height of the decoded image
+	 * @param input the buffer containing the luminance component of the decoded image
+	 * @param originalWidth width of the original image
+	 * @param originalHeight height of the original image
+	 */
+	virtual void describe(FeatureList & featurelist, const Parameters & detection, int width, int height, const unsigned char * input, int originalWidth, int originalHeight) const;
 
 public:
 	CdvsClientImpl(const CdvsConfiguration * config, int mode);
 	virtual ~CdvsClientImpl();
 
 	virtual unsigned int encode(CdvsDescriptor & output, int width, int height, const unsigned char * buffer) const;
+
+	virtual unsigned int encode(CdvsDescriptor & output, int width, int height, const unsigned char * buffer, int originalWidth, int originalHeight) const;
+
+	virtual unsigned int encodeMulti(std::vector<CdvsDescriptor> & outputs, const std::vector<int> & modes, int width, int height, const unsigned char * buffer, int originalWidth, int originalHeight) const;
 };
 
 
@@ -47,12 +47,20 @@ CdvsClientLowMem::~CdvsClientLowMem() {
 }
 
 
-unsigned int CdvsClientLowMem::encode(CdvsDescriptor & cdvsDescriptor, int width, int height, const unsigned char * input) const
+unsigned int CdvsClientLowMem::encode(CdvsDescriptor & cdvsDescriptor, int width, int height, const unsigned char * input, int originalWidth, int originalHeight) const
 {
 	cdvsDescriptor.clear();		// erase old data
 
 	AlpDetectorLowMem imagebuffer;
-	imagebuffer.read(width, height, input);
+	imagebuffer.read(width, height, input, originalWidth, originalHeight);
 	imagebuffer.resampleIfGreater(params.resizeMaxSize);
 	return cdvsDescriptor.encode(params, imagebuffer, g_factory);		// encode global and local descriptors
 }
+
+void CdvsClientLowMem::describe(FeatureList & featurelist, const Parameters & detection, int width, int height, const unsigned char * input, int originalWidth, int originalHeight) const
+{
+	AlpDetectorLowMem imagebuffer;
+	imagebuffer.read(width, height, input, originalWidth, originalHeight);
+	imagebuffer.resampleIfGreater(detection.resizeMaxSize);
+	CdvsDescriptor::extractFeatures(featurelist, detection, imagebuffer);
+}
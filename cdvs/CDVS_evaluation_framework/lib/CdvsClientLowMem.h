@@ -55,7 +55,12 @@ public:
 	CdvsClientLowMem(const CdvsConfiguration * config, int mode);
 	virtual ~CdvsClientLowMem();
 
-	virtual unsigned int encode(CdvsDescriptor & output, int width, int height, const unsigned char * input)  const;
+	using CdvsClientImpl::encode;
+
+	virtual unsigned int encode(CdvsDescriptor & output, int width, int height, const unsigned char * input, int originalWidth, int originalHeight)  const;
+
+protected:
+	virtual void describe(FeatureList & featurelist, const Parameters & detection, int width, int height, const unsigned char * input, int originalWidth, int originalHeight) const;
 };
 
 } // end namespace
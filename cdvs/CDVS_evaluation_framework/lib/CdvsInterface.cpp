@@ -41,6 +41,8 @@
 #include "CdvsClientLowMem.h"
 #elif defined BFLOG
 #include "CdvsClientBflog.h"
+#elif defined FIXEDPOINT
+#include "CdvsClientFixed.h"
 #endif
 
 
@@ -79,6 +81,8 @@ CdvsClient * CdvsClient::cdvsClientFactory(const CdvsConfiguration * config, int
 		return new CdvsClientLowMem(config, mode);
 #elif defined BFLOG
 		return new CdvsClientBflog(config, mode);
+#elif defined FIXEDPOINT
+		return new CdvsClientFixed(config, mode);
 #endif
 }
 
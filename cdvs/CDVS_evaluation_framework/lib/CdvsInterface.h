@@ -123,6 +123,38 @@ namespace mpeg7cdvs
 		 */
 		virtual unsigned int encode(CdvsDescriptor & output, int width, int height, const unsigned char * input)  const = 0;
 
+		/**
+		 * Encode the luminance component of an image that has been decoded at a reduced resolution (e.g. by a JPEG decoder
+		 * scaling the image in the DCT domain), producing a CDVS descriptor.
+		 * The image is resampled and its keypoints are scaled as if it had been decoded at the original resolution,
+		 * so the decoded image should not be smaller than the resizeMaxSize parameter of the mode.
+		 * @param output the output CDVS descriptor
+		 * @param width width of the decoded image
+		 * @param height height of the decoded image
+		 * @param input the buffer containing the luminance component of the decoded image (Y component, 8 bit per pixel)
+		 * @param originalWidth width of the original image
+		 * @param originalHeight height of the original image
+		 * @return the actual size of the encoded CDVS descriptor
+		 */
+		virtual unsigned int encode(CdvsDescriptor & output, int width, int height, const unsigned char * input, int originalWidth, int originalHeight)  const = 0;
+
+		/**
+		 * Encode the luminance component of an image producing one CDVS descriptor for each of the requested modes.
+		 * The key points are detected and described only once for all the modes sharing the same detection parameters
+		 * (e.g. resizeMaxSize), and the global descriptor signature is computed only once for all the modes sharing the same
+		 * global descriptor settings; each output descriptor is identical to the one produced by a client of that mode.
+		 * The client mode is not used: the parameters of each mode are taken from the configuration given to the factory.
+		 * @param outputs the output CDVS descriptors (one for each mode, in the same order)
+		 * @param modes the modes of the descriptors to produce (each one in the range [0..6])
+		 * @param width width of the decoded image
+		 * @param height height of the decoded image
+		 * @param input the buffer containing the luminance component of the decoded image (Y component, 8 bit per pixel)
+		 * @param originalWidth width of the original image
+		 * @param originalHeight height of the original image
+		 * @return the total size of the encoded CDVS descriptors
+		 */
+		virtual unsigned int encodeMulti(std::vector<CdvsDescriptor> & outputs, const std::vector<int> & modes, int width, int height, const unsigned char * input, int originalWidth, int originalHeight)  const = 0;
+
 	};
 
 
@@ -187,6 +219,30 @@ namespace mpeg7cdvs
 		 */
 		virtual PointPairs match(const CdvsDescriptor & queryDescriptor, unsigned int index, const CDVSPOINT *r_bbox=NULL, CDVSPOINT *proj_bbox=NULL, int matchType = MATCH_TYPE_LOCAL) const = 0;
 
+		/**
+		 * Pair-wise descriptor matching & localization function, storing the result in the given PointPairs instance.
+		 * The buffers of pairs are reused, so calling this method repeatedly with the same instance does not allocate memory.
+		 * @param pairs the output matching points, plus local and global scores.
+		 * @param queryDescriptor the query descriptor
+		 * @param refDescriptor the reference descriptor
+		 * @param r_bbox bounding box of object of interest in the second (reference) image;  replaced by the full image coordinates if NULL.
+		 * @param proj_bbox buffer to contain parameters of bounding box for a match projected in the coordinate system of the first (query) image; ignored if NULL.
+		 * @param matchType type of matching; may be MATCH_TYPE_DEFAULT, MATCH_TYPE_BOTH, MATCH_TYPE_LOCAL, MATCH_TYPE_GLOBAL. Default is MATCH_TYPE_DEFAULT in this case.
+		 */
+		virtual void match(PointPairs & pairs, const CdvsDescriptor & queryDescriptor, const CdvsDescriptor & refDescriptor, const CDVSPOINT *r_bbox=NULL, CDVSPOINT *proj_bbox=NULL, int matchType = MATCH_TYPE_DEFAULT) const = 0;
+
+		/**
+		 * Pair-wise descriptor matching & localization using a DB image as reference, storing the result in the given PointPairs instance.
+		 * The buffers of pairs are reused, so calling this method repeatedly with the same instance does not allocate memory.
+		 * @param pairs the output matching points, plus local and global scores.
+		 * @param queryDescriptor the query descriptor
+		 * @param index index of the reference descriptor in the DB
+		 * @param r_bbox bounding box of object of interest in the DB image; replaced by the full image coordinates if NULL.
+		 * @param proj_bbox buffer to contain parameters of bounding box for a match projected in the coordinate system of the query image; ignored if NULL.
+		 * @param matchType type of matching; may be MATCH_TYPE_DEFAULT, MATCH_TYPE_BOTH, MATCH_TYPE_LOCAL, MATCH_TYPE_GLOBAL. Default is MATCH_TYPE_LOCAL in this case.
+		 */
+		virtual void match(PointPairs & pairs, const CdvsDescriptor & queryDescriptor, unsigned int index, const CDVSPOINT *r_bbox=NULL, CDVSPOINT *proj_bbox=NULL, int matchType = MATCH_TYPE_LOCAL) const = 0;
+
 		/**
 		 * Create a Database of CDVS Descriptors for retrieval.
 		 * @param mode the mode identifier of all descriptors that will be stored in the DB;
@@ -258,9 +314,64 @@ namespace mpeg7cdvs
 		 * @param results vector of information data about matching images (in order of relevance)
 		 * @param queryDescriptor the query descriptor to be used as input query data of the retrieval operation
 		 * @param max_matches - maximum number of matches to include in the list of results
+		 * @param stats if not NULL, receives the counters of the work done and pruned by this retrieval operation
 		 * @return number of matches found
 		 */
-		virtual int retrieve(std::vector<RetrievalData> & results, const CdvsDescriptor & queryDescriptor, unsigned int max_matches) const = 0;
+		virtual int retrieve(std::vector<RetrievalData> & results, const CdvsDescriptor & queryDescriptor, unsigned int max_matches, RetrievalStats * stats = NULL) const = 0;
+
+		/**
+		 * Build the recall graph of the DB, replacing any existing one.
+		 * For each DB image, the most similar DB images according to the global descriptors are selected as candidates;
+		 * each candidate is verified using local descriptor matching and DISTRAT, and the best verified candidates become the neighbors of the image.
+		 * The recall graph is used by retrieve() to rerank the global results if the queryExpansionLoops parameter of the DB mode is greater than zero;
+		 * it is stored in the local descriptors file by storeDB().
+		 * @param numNeighbors maximum number of neighbors of each image in the graph
+		 * @param numCandidates number of global descriptor candidates verified for each image
+		 */
+		virtual void buildRecallGraph(unsigned int numNeighbors, unsigned int numCandidates) = 0;
+
+		/**
+		 * Build the vocabulary tree index of the DB local descriptors, replacing any existing one.
+		 * The vocabulary tree is trained on the features of the DB images, then all DB images are indexed;
+		 * once the vocabulary is available, images added to the DB are indexed too (commitDB() updates their tf-idf weights).
+		 * The index is used by retrieve() as a second source of candidates if the vocabularyTreeCandidates parameter of the query mode is greater than zero.
+		 * @param branching number of children of each node of the tree
+		 * @param depth number of levels of the tree (the vocabulary contains up to branching^depth visual words)
+		 * @param maxTrainingFeatures max number of features used for training, evenly sampled from all DB images
+		 */
+		virtual void buildVocabularyTree(unsigned int branching, unsigned int depth, unsigned int maxTrainingFeatures) = 0;
+
+		/**
+		 * Store the vocabulary tree index in a file.
+		 * @param filename the name of the vocabulary tree index file
+		 */
+		virtual void storeVocabularyTree(const char * filename) const = 0;
+
+		/**
+		 * Load the vocabulary tree index from a file. If the file does not index the same number of images as the DB,
+		 * only its vocabulary is kept and the DB images are indexed again (so a vocabulary can be reused for other DBs).
+		 * @param filename the name of the vocabulary tree index file
+		 */
+		virtual void loadVocabularyTree(const char * filename) = 0;
+
+		/**
+		 * Build the multi-index hash of the DB local descriptors, replacing any existing one.
+		 * The index must be built again after the DB is modified.
+		 * It is used by retrieve() as a source of candidates if the multiIndexHashCandidates parameter of the query mode is greater than zero.
+		 */
+		virtual void buildMultiIndexHash() = 0;
+
+		/**
+		 * Store the multi-index hash of the DB local descriptors in a file.
+		 * @param filename the name of the multi-index hash file
+		 */
+		virtual void storeMultiIndexHash(const char * filename) const = 0;
+
+		/**
+		 * Load the multi-index hash of the DB local descriptors from a file.
+		 * @param filename the name of the multi-index hash file
+		 */
+		virtual void loadMultiIndexHash(const char * filename) = 0;
 
 		/**
 		 * Get the id corresponding to the given image index in the DB.
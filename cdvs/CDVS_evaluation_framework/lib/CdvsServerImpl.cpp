@@ -40,8 +40,13 @@
 #include "CdvsServerImpl.h"
 #include "CdvsException.h"
 #include "DistratEigen.h"
+#include "MatchContext.h"
 #include "Projective2D.h"
 #include "Buffer.h"
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cfloat>
 
 using namespace std;
 using namespace Eigen;
@@ -70,7 +75,10 @@ void CdvsServerImpl::createDB(int mode, int reserve)
 unsigned int CdvsServerImpl::addDescriptorToDB(const CdvsDescriptor & refDescriptor, const char * referenceImageId)
 {
 	 scfvIdx.append(refDescriptor.scfvSignature);						// Add to global database index
-	 return (unsigned int) db.addImage(refDescriptor.featurelist, referenceImageId);	// Add to local database index
+	 size_t index = db.addImage(refDescriptor.featurelist, referenceImageId);	// Add to local database index
+	 if (vtIdx.isTrained())
+		 vtIdx.addImage(db.images[index]);								// Add to vocabulary tree index
+	 return (unsigned int) index;
 }
 
 bool CdvsServerImpl::isDescriptorInDB(const char * referenceImageId) const
@@ -90,6 +98,8 @@ bool CdvsServerImpl::replaceDescriptorInDB(const CdvsDescriptor & refDescriptor,
 	{
 		scfvIdx.replace(index, refDescriptor.scfvSignature);						// replace global
 		db.replaceImage(index, refDescriptor.featurelist, referenceImageId);		// replace local
+		if (vtIdx.isTrained())
+			vtIdx.replaceImage(index, db.images[index]);							// replace in the vocabulary tree index
 	}
 	return (index != NOT_FOUND);
 }
@@ -98,6 +108,8 @@ void CdvsServerImpl::clearDB()
 {
 	db.clear();
 	scfvIdx.clear();
+	vtIdx.clear();		// the vocabulary is kept
+	mihIdx.clear();
 }
 
 void CdvsServerImpl::storeDB(const char * localname, const char * globalname) const
@@ -140,10 +152,12 @@ size_t CdvsServerImpl::decode(CdvsDescriptor & output, const unsigned char * bit
 }
 
 
-PointPairs CdvsServerImpl::matchCompressed(const CompressedFeatureList & compressedQuery, const CompressedFeatureList & compressedReference, const CDVSPOINT *r_bbox, CDVSPOINT *proj_bbox, int matchType,
+void CdvsServerImpl::matchCompressed(PointPairs & pairs, const CompressedFeatureList & compressedQuery, const CompressedFeatureList & compressedReference, const CDVSPOINT *r_bbox, CDVSPOINT *proj_bbox, int matchType,
 		unsigned int queryMode, unsigned int refMode,
 		const SCFVSignature & querySignature, const SCFVSignature & refSignature) const
 {
+	MatchContext & context = MatchContext::threadLocal();		// reusable working memory
+
 	const Parameters & query_params = parset[queryMode];
 	const Parameters & ref_params = parset[refMode];
 
@@ -162,7 +176,10 @@ PointPairs CdvsServerImpl::matchCompressed(const CompressedFeatureList & compres
 	// determine the chi-square percentile
 	unsigned int chiSquarePercentile = max(query_params.chiSquarePercentile,ref_params.chiSquarePercentile);
 
-	PointPairs pairs(compressedQuery.nFeatures() + compressedReference.nFeatures());
+	pairs.reset(compressedQuery.nFeatures() + compressedReference.nFeatures());
+
+	// weight of the matches agreeing on scale and rotation required by the geometric pre-filter (0 = disabled)
+	double minConsistentWeight = query_params.prefilterThreshold * wmThreshold;
 
 	pairs.local_threshold = wmThreshold;		// set current local thresholds
 	pairs.global_threshold = globalThreshold;	// set current global thresholds
@@ -170,13 +187,15 @@ PointPairs CdvsServerImpl::matchCompressed(const CompressedFeatureList & compres
 	if(matchType != MATCH_TYPE_GLOBAL)		// if not global-only...
 	{
 		if (useTwoWayMatch)
-			pairs.nMatched = compressedQuery.matchDescriptors_twoWay(pairs, compressedReference, ratioThreshold);		// Compare descriptors
+			pairs.nMatched = compressedQuery.matchDescriptors_twoWay(pairs, compressedReference, ratioThreshold, context.scratch);		// Compare descriptors
 		else
-			pairs.nMatched = compressedQuery.matchDescriptors_oneWay(pairs, compressedReference, ratioThreshold);		// Compare descriptors
+			pairs.nMatched = compressedQuery.matchDescriptors_oneWay(pairs, compressedReference, ratioThreshold, context.scratch);		// Compare descriptors
 
-		if ((pairs.nMatched >= 5) && (pairs.getTotalWeight() >= wmThreshold))			// 5 is the minimum number of points needed by DISTRAT
+		if ((pairs.nMatched >= 5) && (pairs.getTotalWeight() >= wmThreshold)			// 5 is the minimum number of points needed by DISTRAT
+				&& ((minConsistentWeight <= 0) || (pairs.getConsistentWeight(minConsistentWeight) >= minConsistentWeight)))
 		{
-			DistratEigen distrat(pairs.x1, pairs.x2, pairs.y1, pairs.y2, pairs.nMatched);
+			DistratEigen & distrat = context.distrat;
+			distrat.setPoints(pairs.x1, pairs.x2, pairs.y1, pairs.y2, pairs.nMatched);
 			pairs.nInliers = distrat.estimateInliers(false, true, chiSquarePercentile, pairs.inlierIndexes);
 			pairs.local_score = pairs.getInlierWeight();
 			pairs.score = pairs.local_score / (pairs.local_score + wmThreshold);		// return a value between 0 and 1
@@ -263,6 +282,7 @@ PointPairs CdvsServerImpl::matchCompressed(const CompressedFeatureList & compres
 				}
 				Point2DArray refPoints(num_inliers_bidir,2);
 				Point2DArray queryPoints(num_inliers_bidir,2);
+				std::vector<float> weights(num_inliers_bidir);
 				int l = 0;
 				for (int k=0; k<pairs.nInliers; k++)
 				{
@@ -272,14 +292,17 @@ PointPairs CdvsServerImpl::matchCompressed(const CompressedFeatureList & compres
 					queryPoints(l,1)	= pairs.x2[kinlier];
 					refPoints(l,0)		= pairs.y1[kinlier];
 					refPoints(l,1)		= pairs.y2[kinlier];
+					weights[l]			= (float) pairs.weights[kinlier];
 					l++;
 				}
-				pp.ransac(refPoints,  queryPoints, query_params.ransacNumTests, zoom * query_params.ransacThreshold);
+				pp.setSeed(query_params.ransacSeed);
+				pp.ransac(refPoints,  queryPoints, query_params.ransacNumTests, zoom * query_params.ransacThreshold, weights.data());
 			}
 			else		// one way match
 			{
 				Point2DArray refPoints(pairs.nInliers,2);
 				Point2DArray queryPoints(pairs.nInliers,2);
+				std::vector<float> weights(pairs.nInliers);
 
 				for (int k=0; k<pairs.nInliers; k++)
 				{
@@ -288,8 +311,10 @@ PointPairs CdvsServerImpl::matchCompressed(const CompressedFeatureList & compres
 					queryPoints(k,1)	= pairs.x2[kinlier];
 					refPoints(k,0)		= pairs.y1[kinlier];
 					refPoints(k,1)		= pairs.y2[kinlier];
+					weights[k]			= (float) pairs.weights[kinlier];
 				}
-				pp.ransac(refPoints,  queryPoints, query_params.ransacNumTests, zoom * query_params.ransacThreshold);
+				pp.setSeed(query_params.ransacSeed);
+				pp.ransac(refPoints,  queryPoints, query_params.ransacNumTests, zoom * query_params.ransacThreshold, weights.data());
 			}
 			// end one way or two way match
 
@@ -326,27 +351,33 @@ PointPairs CdvsServerImpl::matchCompressed(const CompressedFeatureList & compres
 
 		}
 	}
-
-	return pairs;	// return the result
 }
 
 /*
  * Pair-wise descriptor matching & localization function.
  */
 PointPairs CdvsServerImpl::match(const CdvsDescriptor & queryDescriptor, const CdvsDescriptor & refDescriptor, const CDVSPOINT *r_bbox, CDVSPOINT *proj_bbox, int matchType) const
+{
+	PointPairs pairs;
+	match(pairs, queryDescriptor, refDescriptor, r_bbox, proj_bbox, matchType);
+	return pairs;
+}
+
+void CdvsServerImpl::match(PointPairs & pairs, const CdvsDescriptor & queryDescriptor, const CdvsDescriptor & refDescriptor, const CDVSPOINT *r_bbox, CDVSPOINT *proj_bbox, int matchType) const
 {
 	// check descriptor size
 
 	if ((queryDescriptor.getNumberOfLocalDescriptors() == 0) || (refDescriptor.getNumberOfLocalDescriptors() == 0))
 	{
-		PointPairs emptypairs;
-		return emptypairs;			// no match possible with an empty descriptor
+		pairs.reset(0);
+		return;			// no match possible with an empty descriptor
 	}
 
-	CompressedFeatureList compressedQuery(queryDescriptor.featurelist);
-	CompressedFeatureList compressedReference(refDescriptor.featurelist);
+	MatchContext & context = MatchContext::threadLocal();
+	context.query.assign(queryDescriptor.featurelist);
+	context.reference.assign(refDescriptor.featurelist);
 
-	return matchCompressed(compressedQuery, compressedReference, r_bbox, proj_bbox, matchType,
+	matchCompressed(pairs, context.query, context.reference, r_bbox, proj_bbox, matchType,
 			queryDescriptor.getModeID(), refDescriptor.getModeID(),
 			queryDescriptor.scfvSignature, refDescriptor.scfvSignature);
 }
@@ -355,18 +386,26 @@ PointPairs CdvsServerImpl::match(const CdvsDescriptor & queryDescriptor, const C
  * This method matches a query descriptor with a reference stored in the DB; it is supposed to be called after a retrieval operation, even though this is not essential.
  */
 PointPairs CdvsServerImpl::match(const CdvsDescriptor & queryDescriptor, unsigned int index, const CDVSPOINT *r_bbox, CDVSPOINT *proj_bbox, int matchType) const
+{
+	PointPairs pairs;
+	match(pairs, queryDescriptor, index, r_bbox, proj_bbox, matchType);
+	return pairs;
+}
+
+void CdvsServerImpl::match(PointPairs & pairs, const CdvsDescriptor & queryDescriptor, unsigned int index, const CDVSPOINT *r_bbox, CDVSPOINT *proj_bbox, int matchType) const
 {
 	// check descriptor size
 
 	if ((queryDescriptor.getNumberOfLocalDescriptors() == 0) || (index >= db.images.size()))
 	{
-		PointPairs emptypairs;
-		return emptypairs;			// no match possible with an empty descriptor or an index out of range
+		pairs.reset(0);
+		return;			// no match possible with an empty descriptor or an index out of range
 	}
 
-	CompressedFeatureList compressedQuery(queryDescriptor.featurelist);
+	MatchContext & context = MatchContext::threadLocal();
+	context.query.assign(queryDescriptor.featurelist);
 
-	return matchCompressed(compressedQuery, db.images[index], r_bbox, proj_bbox, matchType,
+	matchCompressed(pairs, context.query, db.images[index], r_bbox, proj_bbox, matchType,
 		queryDescriptor.getModeID(), db.modeId,
 		queryDescriptor.scfvSignature, scfvIdx.getImage(index));
 }
@@ -381,16 +420,185 @@ bool cmpDoubleUintAscend(const std::pair<double,unsigned int> & pair1, const std
 }
 
 
-int CdvsServerImpl::retrieve(vector<RetrievalData> & results, const CdvsDescriptor & cdvsDescriptor, unsigned int max_matches) const
+void CdvsServerImpl::appendCandidates(vector< pair<double,unsigned int> > & candidates, unsigned int & nCandidates, const vector< pair<double,unsigned int> > & others) const
 {
+	candidates.resize(nCandidates);
+	vector<bool> selected(db.size(), false);
+	for (unsigned int i = 0; i < nCandidates; ++i)
+		selected[candidates[i].second] = true;
+
+	for (size_t i = 0; i < others.size(); ++i)
+	{
+		if (!selected[others[i].second])
+			candidates.push_back(make_pair(0.0, others[i].second));		// no global score
+	}
+
+	nCandidates = candidates.size();
+}
+
+namespace {
+
+const double roundingMargin = 1e-9;		// the inlier weight is summed in a different order than the total weight
+
+/*
+ * Verification of the candidates of a retrieval query by means of euclidean matching and geometric verification (DISTRAT).
+ * A single instance is shared by the threads verifying the candidates of the query. The working memory of each thread
+ * (the coordinates of the features matched by the method matchCompressedDescriptors, the matching buffers and DISTRAT)
+ * is reused for all images and queries.
+ *
+ * Early termination cascade: every pair weight is <= 1, so the weight of a candidate is bounded by its number of features
+ * (twice that number in two way matching), and during the matching by the number of features still to be matched.
+ * A candidate cannot change the results if its weight cannot reach the local threshold (its score would be zero anyway)
+ * or if maxMatches candidates verified so far have a better score (it would be placed after them and truncated).
+ * Such candidates are not matched, their matching is abandoned, or their DISTRAT check is skipped.
+ */
+class CandidateVerifier
+{
+public:
+	const Database & db;
+	const CompressedFeatureList & query;
+	const vector< pair<double,unsigned int> > & candidates;	// the candidates, as (global score, image index)
+	vector<RetrievalData> & results;
+	vector<float> & bestScores;				// min-heap of the best maxMatches scores found so far
+	RetrievalStats & counters;
+	std::string & errorMessage;				// the first exception thrown by a thread (exceptions cannot leave the parallel region)
+
+	size_t firstResult;						// the slot of the first candidate in results
+	bool useTwoWayMatch;
+	int maxPairs;
+	float ratioThreshold;
+	unsigned int chiSquarePercentile;
+	bool cascade;							// true if the candidates that cannot change the results are pruned
+	unsigned int maxMatches;
+	double localThreshold;
+	double minConsistentWeight;				// geometric pre-filter (0 = disabled)
+	double boundFactor;						// max weight of a matched feature
+	float rankThreshold;					// weights below this value cannot enter the results (0 until bestScores is full)
+
+	CandidateVerifier(const Database & database, const CompressedFeatureList & queryFeatures, const vector< pair<double,unsigned int> > & imageCandidates,
+			vector<RetrievalData> & retrievalResults, vector<float> & scores, RetrievalStats & stats, std::string & error):
+		db(database), query(queryFeatures), candidates(imageCandidates), results(retrievalResults), bestScores(scores), counters(stats), errorMessage(error)
+	{}
+
+	void verify(int i);		// verify the i-th candidate
+};
+
+void CandidateVerifier::verify(int i)
+{
+	RetrievalData & vip = results[firstResult + i];		// very important pictures
+	vip.index = candidates[i].second;
+	vip.gScore = candidates[i].first;
+	vip.nMatched = 0;
+	vip.nInliers = 0;
+	vip.fScore = 0;
+
+	try {
+		MatchContext & threadContext = MatchContext::threadLocal();
+		PointPairs & pairs = threadContext.pairs;
+		pairs.reset(maxPairs);
+		pairs.local_threshold = localThreshold;		// set current local thresholds
+		MatchScratch & scratch = threadContext.scratch;
+		DistratEigen & distrat = threadContext.distrat;
+
+		double minWeight = 0.0;		// no pruning
+		if (cascade)
+		{
+			#pragma omp critical (retrieve_rank)
+			minWeight = std::max(localThreshold, (double) rankThreshold) - roundingMargin;
+		}
+
+		double maxWeight = boundFactor * std::min(db.images[vip.index].nFeatures(), query.nFeatures());
+		if (maxWeight < minWeight)
+		{
+			#pragma omp atomic
+			counters.nSkipped++;
+		}
+		else
+		{
+			vip.nMatched = useTwoWayMatch?db.matchCompressedDescriptors_twoWay(pairs, query, vip.index, ratioThreshold, scratch, minWeight):
+					db.matchCompressedDescriptors_oneWay(pairs, query, vip.index, ratioThreshold, scratch, minWeight);
+
+			if (scratch.abandoned)
+			{
+				#pragma omp atomic
+				counters.nAbandoned++;
+			}
+			else if (vip.nMatched >= 5)			// 5 is the minimum number of points needed by DISTRAT
+			{
+				// The inlier weight cannot exceed the total weight of the matched pairs
+				if (pairs.getTotalWeight() < minWeight)
+				{
+					#pragma omp atomic
+					counters.nDistratSkipped++;
+				}
+				else if ((minConsistentWeight > 0) && (pairs.getConsistentWeight(minConsistentWeight) < minConsistentWeight))
+				{
+					#pragma omp atomic
+					counters.nPrefiltered++;
+				}
+				else
+				{
+					// Geometric consistency check using DISTRAT
+					distrat.setPoints(pairs.x1, pairs.x2, pairs.y1, pairs.y2, vip.nMatched);
+					vip.nInliers = pairs.nInliers = distrat.estimateInliers(false, true, chiSquarePercentile, pairs.inlierIndexes);
+					double weight = pairs.getInlierWeight();
+
+					if (weight >= pairs.local_threshold)
+						vip.fScore = (float) weight;
+
+					#pragma omp atomic
+					counters.nVerified++;
+				}
+			}
+		}
+
+		if (cascade && (vip.fScore > 0))
+		{
+			#pragma omp critical (retrieve_rank)
+			{
+				bestScores.push_back(vip.fScore);
+				push_heap(bestScores.begin(), bestScores.end(), std::greater<float>());
+				if (bestScores.size() > maxMatches)
+				{
+					pop_heap(bestScores.begin(), bestScores.end(), std::greater<float>());
+					bestScores.pop_back();
+				}
+
+				// a weight below the worst best score reduced by one epsilon (at least one float below it) is rounded to a lower score
+				// (an equal score could still precede it in the results, as candidates may be verified out of order)
+				if (bestScores.size() == maxMatches)
+					rankThreshold = bestScores.front() * (1.0f - FLT_EPSILON);
+			}
+		}
+	}
+	catch(exception & ex)
+	{
+		#pragma omp critical (retrieve_error)
+		{
+			if (errorMessage.empty())
+				errorMessage = ex.what();
+		}
+	}
+}
+
+}	// end of anonymous namespace
+
+int CdvsServerImpl::retrieve(vector<RetrievalData> & results, const CdvsDescriptor & cdvsDescriptor, unsigned int max_matches, RetrievalStats * stats) const
+{
+	RetrievalStats counters = {0, 0, 0, 0, 0, 0};
+	if (stats != NULL)
+		*stats = counters;
+
 	if (cdvsDescriptor.getNumberOfLocalDescriptors() == 0)			// this special case happens when no features are extracted from the image by vlfeat
 		return 0;
 
 	const Parameters & query_params = parset[cdvsDescriptor.getModeID()];
 	const Parameters & param_db = parset[db.getMode()];
 
+	MatchContext & context = MatchContext::threadLocal();		// reusable working memory of this query
+
 	// Compute scores with global signature
-	vector< pair<double,unsigned int> > imageScoresNumbersTop;
+	vector< pair<double,unsigned int> > & imageScoresNumbersTop = context.candidates;
 
 	if(query_params.hasBitSelection)
 	{
@@ -442,44 +650,93 @@ int CdvsServerImpl::retrieve(vector<RetrievalData> & results, const CdvsDescript
 	// Reduction of the number of keypoints contained in the query (only if the relevance bit is present)
 	// use a special copy constructor of CompressedFeatureList to sort by relevance the keypoints.
 
-	CompressedFeatureList query_db(cdvsDescriptor.featurelist, cdvsDescriptor.getRelevanceBitsPresent());
+	CompressedFeatureList & query_db = context.query;
+	query_db.assign(cdvsDescriptor.featurelist, cdvsDescriptor.getRelevanceBitsPresent());
 
-	// Reranking by means of euclidean matching and geometric verification of the top matches
+	// Append the candidates selected by the local descriptor indices (if required and available) that were not selected yet
 
-	results.reserve(nLoops);
+	vector< pair<double,unsigned int> > & localCandidates = context.localCandidates;
+	if ((query_params.vocabularyTreeCandidates > 0) && vtIdx.isTrained() && (vtIdx.numberImages() == db.size()))
+	{
+		vtIdx.query(query_db, localCandidates, query_params.vocabularyTreeCandidates);
+		appendCandidates(imageScoresNumbersTop, nLoops, localCandidates);
+	}
 
-	// Vectors that contain the coordinates of the features matched by the method matchCompressedDescriptors
+	if ((query_params.multiIndexHashCandidates > 0) && (mihIdx.numberImages() == db.size()) && (mihIdx.numberImages() > 0))
+	{
+		// descriptors of different modes are compared on their common prefix, so the radius is scaled to its size
+		int maxDistance = (int) (query_params.multiIndexHashRadius * 8 * mihIdx.searchBytes(query_db.descrBytes()));
+		mihIdx.vote(query_db, query_params.multiIndexHashNeighbors, maxDistance, localCandidates, query_params.multiIndexHashCandidates);
+		appendCandidates(imageScoresNumbersTop, nLoops, localCandidates);
+	}
 
-	PointPairs pairs(query_params.selectMaxPoints + param_db.selectMaxPoints);
-	pairs.local_threshold = useTwoWayMatch? query_params.wmRetrieval2Way: query_params.wmRetrieval;		// set current local thresholds
+	counters.nCandidates = nLoops;
 
-	for(unsigned int i=0; i<nLoops; ++i)		// first loop - get only images passing the DISTRAT check
+	// Reranking by means of euclidean matching and geometric verification of the top matches
+	// Candidates may be verified in parallel; each one writes its own slot, so the order of the results is the same as in the serial case
+
+	size_t firstResult = results.size();
+	results.resize(firstResult + nLoops);
+
+	int nThreads = 1;
+#ifdef _OPENMP
+	nThreads = std::max(1, std::min(query_params.retrievalThreads, (int) nLoops));
+#endif
+
+	std::string errorMessage;		// exceptions cannot leave the parallel region
+
+	CandidateVerifier verifier(db, query_db, imageScoresNumbersTop, results, context.bestScores, counters, errorMessage);
+	verifier.firstResult = firstResult;
+	verifier.useTwoWayMatch = useTwoWayMatch;
+	verifier.maxPairs = query_params.selectMaxPoints + param_db.selectMaxPoints;
+	verifier.ratioThreshold = param_db.ratioThreshold;
+	verifier.chiSquarePercentile = query_params.chiSquarePercentile;
+	verifier.cascade = query_params.retrievalCascade && (max_matches > 0);
+	verifier.maxMatches = max_matches;
+	verifier.localThreshold = useTwoWayMatch? query_params.wmRetrieval2Way: query_params.wmRetrieval;
+	verifier.minConsistentWeight = query_params.prefilterThreshold * verifier.localThreshold;
+	verifier.boundFactor = useTwoWayMatch? 2.0: 1.0;
+	verifier.rankThreshold = 0.0f;
+
+	context.bestScores.clear();
+	if (verifier.cascade)
+		context.bestScores.reserve(std::min((size_t) max_matches, (size_t) nLoops) + 1);
+
+	// A single thread does not enter a parallel region at all, because the OpenMP runtime would allocate a team at every query
+
+	if (nThreads > 1)
 	{
-		RetrievalData vip;		// very important pictures
-		vip.index = imageScoresNumbersTop[i].second;
-		vip.gScore = imageScoresNumbersTop[i].first;
-
-		vip.nMatched = useTwoWayMatch?db.matchCompressedDescriptors_twoWay(pairs, query_db, vip.index, param_db.ratioThreshold):
-				db.matchCompressedDescriptors_oneWay(pairs, query_db, vip.index, param_db.ratioThreshold);
-
-		// Geometric consistency check using DISTRAT
-		double weight = 0.0;
-		vip.nInliers = 0;
-		vip.fScore = 0;
-		if (vip.nMatched >= 5)			// 5 is the minimum number of points needed by DISTRAT
-		{
-			DistratEigen distrat(pairs.x1, pairs.x2, pairs.y1, pairs.y2, vip.nMatched);
-			vip.nInliers = pairs.nInliers = distrat.estimateInliers(false, true, query_params.chiSquarePercentile, pairs.inlierIndexes);
-			weight = pairs.getInlierWeight();
+		#pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+		for(int i=0; i<(int) nLoops; ++i)		// first loop - get only images passing the DISTRAT check
+			verifier.verify(i);
+	}
+	else
+	{
+		for(int i=0; i<(int) nLoops; ++i)
+			verifier.verify(i);
+	}
 
-			if (weight >= pairs.local_threshold)
-				vip.fScore = (float) weight;
-		}
+	if (!errorMessage.empty())
+		throw CdvsException(errorMessage);
 
-		results.push_back(vip);
-	}
+	if (stats != NULL)
+		*stats = counters;
+
+	// Sorting of the results by descending score; equal scores keep their order (as in a stable sort, which would allocate memory)
+
+	vector< pair<float,unsigned int> > & ranking = context.ranking;
+	ranking.resize(results.size());
+	for (size_t i = 0; i < results.size(); ++i)
+		ranking[i] = make_pair(-results[i].fScore, (unsigned int) i);
+
+	sort(ranking.begin(), ranking.end());
 
-	stable_sort(results.begin(), results.end(), descending_float_score);		// Sorting of the results
+	vector<RetrievalData> & sortedResults = context.sortedResults;
+	sortedResults.resize(results.size());
+	for (size_t i = 0; i < results.size(); ++i)
+		sortedResults[i] = results[ranking[i].second];
+
+	std::copy(sortedResults.begin(), sortedResults.end(), results.begin());
 
 	// Keep a number of images <= max_matches
 	if(results.size() > max_matches)
@@ -490,6 +747,107 @@ int CdvsServerImpl::retrieve(vector<RetrievalData> & results, const CdvsDescript
 }
 
 
+void CdvsServerImpl::buildRecallGraph(unsigned int numNeighbors, unsigned int numCandidates)
+{
+	if (db.size() != scfvIdx.numberImages())		// check the number of images
+		throw CdvsException("Global and local DB contain a different number of images");
+
+	const Parameters & param_db = parset[db.getMode()];
+	const int nImages = (int) db.size();
+	const double localThreshold = useTwoWayMatch? param_db.wmRetrieval2Way: param_db.wmRetrieval;
+	const double minConsistentWeight = param_db.prefilterThreshold * localThreshold;		// geometric pre-filter (0 = disabled)
+
+	int maxFeatures = 0;
+	for (int i = 0; i < nImages; ++i)
+		maxFeatures = std::max(maxFeatures, db.images[i].nFeatures());
+
+	recallGraph_t graph(nImages);		// each node is written by exactly one thread
+	std::string errorMessage;		// exceptions cannot leave the parallel region
+
+	#pragma omp parallel
+	{
+		// per-thread working memory: its size depends only on numCandidates and on the max number of features
+		PointPairs pairs(2 * maxFeatures);
+		MatchScratch scratch;
+		DistratEigen distrat;
+		vector< pair<double,unsigned int> > candidates;
+		vector< pair<double,unsigned int> > neighbors;
+		candidates.reserve(numCandidates + 1);
+		neighbors.reserve(numCandidates);
+
+		#pragma omp for schedule(dynamic)
+		for (int i = 0; i < nImages; ++i)
+		{
+			try {
+				const SCFVSignature & signature = scfvIdx.getImage(i);
+
+				// select the best candidates using the global descriptors (heap top = worst candidate kept so far)
+				candidates.clear();
+				for (int j = 0; (j < nImages) && (numCandidates > 0); ++j)
+				{
+					if (j == i)
+						continue;
+
+					unsigned int n_q_words = 0, n_r_words = 0, n_words_overlap = 0;
+					double gScore = param_db.hasBitSelection?
+							scfvIdx.matchImages_bitselection(signature, scfvIdx.getImage(j), &n_q_words, &n_r_words, &n_words_overlap):
+							scfvIdx.matchImages(signature, scfvIdx.getImage(j), &n_q_words, &n_r_words, &n_words_overlap);
+
+					candidates.push_back(make_pair(gScore, (unsigned int) j));
+					push_heap(candidates.begin(), candidates.end(), cmpScoreIndexDescend);
+					if (candidates.size() > numCandidates)
+					{
+						pop_heap(candidates.begin(), candidates.end(), cmpScoreIndexDescend);
+						candidates.pop_back();
+					}
+				}
+
+				// verify the candidates using the local descriptors and DISTRAT
+				neighbors.clear();
+				for (size_t c = 0; c < candidates.size(); ++c)
+				{
+					unsigned int j = candidates[c].second;
+					int nMatched = useTwoWayMatch? db.matchCompressedDescriptors_twoWay(pairs, db.images[i], j, param_db.ratioThreshold, scratch):
+							db.matchCompressedDescriptors_oneWay(pairs, db.images[i], j, param_db.ratioThreshold, scratch);
+
+					if ((nMatched >= 5)			// 5 is the minimum number of points needed by DISTRAT
+							&& ((minConsistentWeight <= 0) || (pairs.getConsistentWeight(minConsistentWeight) >= minConsistentWeight)))
+					{
+						distrat.setPoints(pairs.x1, pairs.x2, pairs.y1, pairs.y2, nMatched);
+						pairs.nInliers = distrat.estimateInliers(false, true, param_db.chiSquarePercentile, pairs.inlierIndexes);
+						double weight = pairs.getInlierWeight();
+
+						if (weight >= localThreshold)
+							neighbors.push_back(make_pair(weight, j));
+					}
+				}
+
+				// keep the best verified candidates
+				sort(neighbors.begin(), neighbors.end(), cmpScoreIndexDescend);
+				if (neighbors.size() > numNeighbors)
+					neighbors.resize(numNeighbors);
+
+				graph[i].reserve(neighbors.size());
+				for (size_t n = 0; n < neighbors.size(); ++n)
+					graph[i].push_back(neighbors[n].second);
+			}
+			catch(exception & ex)
+			{
+				#pragma omp critical (recall_error)
+				{
+					if (errorMessage.empty())
+						errorMessage = ex.what();
+				}
+			}
+		}
+	}
+
+	if (!errorMessage.empty())
+		throw CdvsException(errorMessage);
+
+	db.recallGraph.swap(graph);
+}
+
 std::string CdvsServerImpl::getImageId(unsigned int index) const
 {
 	return db.getImageName(index);
@@ -498,4 +856,50 @@ std::string CdvsServerImpl::getImageId(unsigned int index) const
 void CdvsServerImpl::commitDB()
 {
 	scfvIdx.loadHammingWeight();
+	if (vtIdx.isTrained())
+		vtIdx.update();
+}
+
+void CdvsServerImpl::buildVocabularyTree(unsigned int branching, unsigned int depth, unsigned int maxTrainingFeatures)
+{
+	vtIdx.train(db.images, branching, depth, maxTrainingFeatures);
+	for (size_t i = 0; i < db.size(); ++i)
+		vtIdx.addImage(db.images[i]);
+	vtIdx.update();
+}
+
+void CdvsServerImpl::buildMultiIndexHash()
+{
+	mihIdx.build(db.images);
+}
+
+void CdvsServerImpl::storeMultiIndexHash(const char * filename) const
+{
+	mihIdx.write(filename);
+}
+
+void CdvsServerImpl::loadMultiIndexHash(const char * filename)
+{
+	mihIdx.read(filename);
+
+	if (mihIdx.numberImages() != db.size())		// check the number of images
+		throw CdvsException("Multi-index hash and local DB contain a different number of images");
+}
+
+void CdvsServerImpl::storeVocabularyTree(const char * filename) const
+{
+	vtIdx.write(filename);
+}
+
+void CdvsServerImpl::loadVocabularyTree(const char * filename)
+{
+	vtIdx.read(filename);
+
+	if (vtIdx.numberImages() != db.size())		// reuse only the vocabulary
+	{
+		vtIdx.clear();
+		for (size_t i = 0; i < db.size(); ++i)
+			vtIdx.addImage(db.images[i]);
+		vtIdx.update();
+	}
 }
@@ -40,6 +40,8 @@
 
 #include "CdvsInterface.h"
 #include "Database.h"
+#include "VocabularyTreeIndex.h"
+#include "MultiIndexHash.h"
 #include <cstring>
 #include <vector>
 #include <utility>
@@ -58,6 +60,8 @@ private:
 	ParameterSet parset;
 	Database db;
 	SCFVIndex scfvIdx;
+	VocabularyTreeIndex vtIdx;
+	MultiIndexHash mihIdx;
 	bool useTwoWayMatch;
 
 	static bool descending_float_score(const RetrievalData & i, const RetrievalData & j) {
@@ -68,10 +72,22 @@ private:
 	  return pair1.first < pair2.first;
 	}
 
+	static bool cmpScoreIndexDescend(const std::pair<double,unsigned int> & pair1, const std::pair<double,unsigned int> & pair2) {
+	  return (pair1.first > pair2.first) || ((pair1.first == pair2.first) && (pair1.second < pair2.second));
+	}
+
 	static const int LOC_INTERSECTION_THRESHOLD = 8;					// The threshold used in localization
 
 
-	PointPairs matchCompressed(const CompressedFeatureList & queryCFL, const CompressedFeatureList & refCFL, const CDVSPOINT *r_bbox, CDVSPOINT *proj_bbox, int matchType,
+	/**
+	 * Append to the first nCandidates candidates the other candidates that are not among them yet.
+	 * @param candidates the (score, image index) list of candidates, truncated to nCandidates before appending
+	 * @param nCandidates the number of candidates (updated)
+	 * @param others the (score, image index) list of other candidates
+	 */
+	void appendCandidates(std::vector< std::pair<double,unsigned int> > & candidates, unsigned int & nCandidates, const std::vector< std::pair<double,unsigned int> > & others) const;
+
+	void matchCompressed(PointPairs & pairs, const CompressedFeatureList & queryCFL, const CompressedFeatureList & refCFL, const CDVSPOINT *r_bbox, CDVSPOINT *proj_bbox, int matchType,
 			unsigned int queryMode, unsigned int refMode, const SCFVSignature & querySignature, const SCFVSignature & refSignature) const;
 
 
@@ -89,6 +105,10 @@ public:
 
 	virtual PointPairs match(const CdvsDescriptor & queryDescriptor, unsigned int index, const CDVSPOINT *r_bbox, CDVSPOINT *proj_bbox, int matchType) const;
 
+	virtual void match(PointPairs & pairs, const CdvsDescriptor & queryDescriptor, const CdvsDescriptor & refDescriptor, const CDVSPOINT *r_bbox, CDVSPOINT *proj_bbox, int matchType) const;
+
+	virtual void match(PointPairs & pairs, const CdvsDescriptor & queryDescriptor, unsigned int index, const CDVSPOINT *r_bbox, CDVSPOINT *proj_bbox, int matchType) const;
+
 	virtual void createDB(int mode, int reserve);
 
 	virtual unsigned int addDescriptorToDB(const CdvsDescriptor & refDescriptor, const char * referenceImageId);
@@ -105,7 +125,21 @@ public:
 
 	virtual size_t sizeofDB() const;
 
-	virtual int retrieve(std::vector<RetrievalData> & results, const CdvsDescriptor & cdvsDescriptor, unsigned int max_matches) const;
+	virtual int retrieve(std::vector<RetrievalData> & results, const CdvsDescriptor & cdvsDescriptor, unsigned int max_matches, RetrievalStats * stats = NULL) const;
+
+	virtual void buildRecallGraph(unsigned int numNeighbors, unsigned int numCandidates);
+
+	virtual void buildVocabularyTree(unsigned int branching, unsigned int depth, unsigned int maxTrainingFeatures);
+
+	virtual void storeVocabularyTree(const char * filename) const;
+
+	virtual void loadVocabularyTree(const char * filename);
+
+	virtual void buildMultiIndexHash();
+
+	virtual void storeMultiIndexHash(const char * filename) const;
+
+	virtual void loadMultiIndexHash(const char * filename);
 
 	virtual std::string getImageId(unsigned int index) const;
 
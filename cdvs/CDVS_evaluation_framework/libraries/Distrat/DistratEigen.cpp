@@ -36,6 +36,11 @@
 #include <float.h>
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+	#define DISTRAT_SSE2				// the log distances are computed four at a time
+	#include <emmintrin.h>
+#endif
+
 #ifdef _WIN32
     #define ISNAN _isnan
 #elif _WIN64
@@ -83,14 +88,163 @@ const float DistratEigen::LUTchiSquare80[] = {1.6203f, 3.1985f, 4.6222f, 5.9702f
 const float DistratEigen::LUTchiSquare90[] = {2.6390f, 4.5590f, 6.2139f, 7.7472f, 9.2078f, 10.6188f, 11.9933f, 13.3395f, 14.6630f, 15.9677f, 17.2566f, 18.5318f, 19.7952f, 21.0481f, 22.2917f, 23.5270f, 24.7547f, 25.9755f, 27.1901f, 28.3989f, 29.6024f, 30.8009f, 31.9948f, 33.1845f, 34.3701f, 35.5519f, 36.7302f, 37.9051f, 39.0769f, 40.2457f};
 
 
+#ifdef DISTRAT_SSE2
+/*
+ * Natural logarithm of four values (Cephes logf polynomial): within 1 ulp of the standard logf.
+ * Only positive normal finite values are supported.
+ */
+static inline __m128 log4(__m128 x)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128i xi = _mm_castps_si128(x);
+	__m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(xi, 23), _mm_set1_epi32(126)));
+	__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(xi, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f000000)));	// mantissa in [0.5, 1)
+
+	// if m < sqrt(0.5): e = e - 1, m = 2m - 1; else m = m - 1
+	__m128 small = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781186547524f));
+	e = _mm_sub_ps(e, _mm_and_ps(one, small));
+	m = _mm_add_ps(_mm_sub_ps(m, one), _mm_and_ps(m, small));
+
+	__m128 z = _mm_mul_ps(m, m);
+	__m128 y = _mm_set1_ps(7.0376836292E-2f);
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.1514610310E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.1676998740E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.2420140846E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.4249322787E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.6668057665E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(2.0000714765E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-2.4999993993E-1f));
+	y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(3.3333331174E-1f));
+	y = _mm_mul_ps(_mm_mul_ps(y, m), z);
+	y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+	y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+	return _mm_add_ps(_mm_add_ps(m, y), _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+}
+
+/*
+ * Half the logarithm of four values; the values that are not positive normal finite numbers
+ * (possible if two points coincide) are computed by the standard log.
+ */
+static inline __m128 halfLog4(__m128 x)
+{
+	__m128 result = _mm_mul_ps(_mm_set1_ps(0.5f), log4(x));
+	__m128 valid = _mm_and_ps(_mm_cmpge_ps(x, _mm_set1_ps(FLT_MIN)), _mm_cmple_ps(x, _mm_set1_ps(FLT_MAX)));
+	if (_mm_movemask_ps(valid) != 0xf)
+	{
+		float in[4], out[4];
+		_mm_storeu_ps(in, x);
+		_mm_storeu_ps(out, result);
+		for (int i = 0; i < 4; i++)
+			if ((_mm_movemask_ps(valid) & (1 << i)) == 0)
+				out[i] = 0.5f * log(in[i]);
+		result = _mm_loadu_ps(out);
+	}
+	return result;
+}
+#endif
+
+/*
+ * Compute half the logarithm of (dist[k] + offset) for n values.
+ */
+static void halfLogDistances(const float * dist, float offset, float * output, int n)
+{
+	int k = 0;
+#ifdef DISTRAT_SSE2
+	const __m128 off = _mm_set1_ps(offset);
+	for (; k + 4 <= n; k += 4)
+		_mm_storeu_ps(output + k, halfLog4(_mm_add_ps(_mm_loadu_ps(dist + k), off)));
+	if (k < n)		// the last values are computed in the same way, to get consistent results
+	{
+		float in[4] = {1.0f, 1.0f, 1.0f, 1.0f}, out[4];
+		for (int i = k; i < n; i++)
+			in[i - k] = dist[i] + offset;
+		_mm_storeu_ps(out, halfLog4(_mm_loadu_ps(in)));
+		for (int i = k; i < n; i++)
+			output[i] = out[i - k];
+	}
+#else
+	for (; k < n; k++)
+		output[k] = 0.5f * log(dist[k] + offset);
+#endif
+}
+
+/*
+ * Compute half the logarithm of the distance ratios (distA[k] + 1e-6) / (distB[k] + 1e-9) for n values.
+ */
+static void halfLogDistanceRatios(const float * distA, const float * distB, float * output, int n)
+{
+	int k = 0;
+#ifdef DISTRAT_SSE2
+	const __m128 offA = _mm_set1_ps(1e-6f);
+	const __m128 offB = _mm_set1_ps(1e-9f);
+	for (; k + 4 <= n; k += 4)
+		_mm_storeu_ps(output + k, halfLog4(_mm_div_ps(_mm_add_ps(_mm_loadu_ps(distA + k), offA), _mm_add_ps(_mm_loadu_ps(distB + k), offB))));
+	if (k < n)		// the last values are computed in the same way, to get consistent results
+	{
+		float in[4] = {1.0f, 1.0f, 1.0f, 1.0f}, out[4];
+		for (int i = k; i < n; i++)
+			in[i - k] = (distA[i] + 1e-6f) / (distB[i] + 1e-9f);
+		_mm_storeu_ps(out, halfLog4(_mm_loadu_ps(in)));
+		for (int i = k; i < n; i++)
+			output[i] = out[i - k];
+	}
+#else
+	for (; k < n; k++)
+		output[k] = 0.5f * log((distA[k] + 1e-6f) / (distB[k] + 1e-9f));
+#endif
+}
+
+#ifdef DISTRAT_SSE2
+/*
+ * Check if a value is so close to an edge of a uniform grid (with the same offset used by the histograms and by the quantization)
+ * that the difference between the vectorized and the standard logarithm could change its bin; also true for NaN.
+ */
+static inline bool nearEdge(float value, float first, float invStep)
+{
+	float x = ((value + 1e-5f) - first) * invStep;
+	float fraction = x - floorf(x);
+	return !((fraction >= 1e-3f) && (fraction <= 1.0f - 1e-3f));		// in bins: far larger than the error of log4
+}
+
+/*
+ * Same as nearEdge() for four values at a time.
+ * @return a bit mask of the values close to an edge
+ */
+static inline int nearEdge4(const float * values, float first, float invStep)
+{
+	__m128 x = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(values), _mm_set1_ps(1e-5f)), _mm_set1_ps(first)), _mm_set1_ps(invStep));
+	__m128 fraction = _mm_sub_ps(x, _mm_cvtepi32_ps(_mm_cvttps_epi32(x)));
+	fraction = _mm_andnot_ps(_mm_set1_ps(-0.0f), fraction);		// truncation instead of floor: the fraction of a negative value is negative
+	__m128 sure = _mm_and_ps(_mm_cmpge_ps(fraction, _mm_set1_ps(1e-3f)), _mm_cmple_ps(fraction, _mm_set1_ps(1.0f - 1e-3f)));
+	return _mm_movemask_ps(sure) ^ 0xf;
+}
+#endif
+
 // gaussian filter taps
 const float DistratEigen::m_GaussianKernel[] = {0.0404f, 0.9192f, 0.0404f};
 
+DistratEigen::DistratEigen():
+		m_x1(NULL), m_x2 (NULL), m_y1 (NULL), m_y2 (NULL), m_nPoints(0), m_nFeatures(0)
+{
+	setPoints(NULL, NULL, NULL, NULL, 0);
+}
+
 DistratEigen::DistratEigen(const float *x1, const float *x2, const float *y1, const float *y2, int size):
-		m_x1(x1), m_x2 (x2), m_y1 (y1), m_y2 (y2), m_nPoints(size), DA(size, size), DB(size, size), m_nFeatures(0)
+		m_x1(x1), m_x2 (x2), m_y1 (y1), m_y2 (y2), m_nPoints(size), m_nFeatures(0)
+{
+	setPoints(x1, x2, y1, y2, size);
+}
+
+void DistratEigen::setPoints(const float *x1, const float *x2, const float *y1, const float *y2, int size)
 {
+	m_x1 = x1;
+	m_x2 = x2;
+	m_y1 = y1;
+	m_y2 = y2;
+	m_nPoints = size;
+	m_nFeatures = 0;
+
 	// initialization
-	LDR = NULL;
 	m_c = 0;
 
 	// Initialization configuration parameters
@@ -104,8 +258,6 @@ DistratEigen::DistratEigen(const float *x1, const float *x2, const float *y1, co
 
 DistratEigen::~DistratEigen(void)
 {
-	if (LDR != NULL)
-		delete [] LDR;
 }
 
 int DistratEigen::estimateInliers(bool useParametric, bool computeInliers, unsigned int percentile, int * inliersIndexes)
@@ -113,8 +265,12 @@ int DistratEigen::estimateInliers(bool useParametric, bool computeInliers, unsig
 	if (m_nPoints < minNumPoints)
 		return 0;
 
-	coord2dist(m_x1, m_x2, m_nPoints, DA, true);
-	coord2dist(m_y1, m_y2, m_nPoints, DB, true);
+	m_DA.resize(m_nPoints * m_nPoints);		// no allocation if the capacity is already sufficient
+	m_DB.resize(m_nPoints * m_nPoints);
+	Map<MatrixXf> distA(&m_DA[0], m_nPoints, m_nPoints);
+	Map<MatrixXf> distB(&m_DB[0], m_nPoints, m_nPoints);
+	coord2dist(m_x1, m_x2, m_nPoints, distA, true, m_coordinates);
+	coord2dist(m_y1, m_y2, m_nPoints, distB, true, m_coordinates);
 
 
 	/****** Initialization ******/
@@ -212,24 +368,6 @@ void DistratEigen::prepareParametric()
 	}
 
 
-	// Matrix of log distance ratio
-	LDR = new float [m_nSamples];
-
-	// Compute log distance ratio - the values are divided by two since the coor2dist values are computed at a squared value
-	// Optimization to avoid the sqrt in the Coord2dist function
-
-	// Rapporto delle distanze
-
-	int counter=0;
-	for (int i=0; i< m_nPoints; i++)
-	{
-		for (int j=0; j< i; j++)
-		{
-			LDR[counter] = 0.5f * log((DA(i,j) + 1e-6f)  /   (DB(i,j) + 1e-9f)); 		// Added small numbers to avoid Inf
-			counter++;
-		}
-	}
-
 	// istogramma per i valori campionati
 
 	for (int i=0; i<m_nBins; i++ )
@@ -238,7 +376,9 @@ void DistratEigen::prepareParametric()
 	}
 	m_Edges[m_nBins] = m_Edges[m_nBins-1] + stepsize;
 
-	computeHist(m_Hist,LDR,m_Edges,m_nSamples,m_nBins+1);
+	// Compute log distance ratio and its histogram - the values are divided by two since the coor2dist values are computed at a squared value
+	// Optimization to avoid the sqrt in the Coord2dist function
+	computeLogDistanceRatios(NULL, 0, NULL, NULL);
 
 	for(int i=0; i<m_nBins; i++)
 	{
@@ -271,39 +411,19 @@ void DistratEigen::prepareNonParametric()
 {
 	// DISTRAT PART I : data preparation NON PARAMETRIC
 
-	//Compute log distance ratio - the values are divided by two since the coor2dist values are computed at a squared value
-	//Optimization to avoid the sqrt in the Coord2dist function
 	m_nSamples = m_nPoints*(m_nPoints-1)/2;
-	delete [] LDR;
-	LDR = new float [m_nSamples];
-
-	float *distEnum = new float [m_nSamples];
-	float *distDenom = new float [m_nSamples];
-
-	// calcola il logaritmo delle distanze
-
-	int counter = 0;
-	for (int i=0; i< m_nPoints; i++)
-	{
-		for (int j=0; j< i; j++)
-		{
-			distEnum[counter] = 0.5f * log(DA(i,j) + 1e-6f); 							//Added small numbers to avoid Inf
-			distDenom[counter] = 0.5f * log(DB(i,j) + 1e-9f);
-			LDR[counter] = distEnum[counter] - distDenom[counter];
-			counter++;
-		}
-	}
 
     //  la pdf modello
 	float stepsize = samplingStep;
 	int numElForT = (int)ceil(logImageDiagSize/stepsize);
-	float *histEnum = new float [numElForT+1];
-	float *histDenom = new float [numElForT+1];
-	float * edges = new float [numElForT+1];
+	m_hist.resize(10*numElForT + gaussianFilterDim);		// room for all the following arrays
+	float *histEnum = &m_hist[0];
+	float *histDenom = histEnum + numElForT+1;
+	float * edges = histDenom + numElForT+1;
 
 	// Computation edges for first histogram
 
-	float *t = new float [numElForT];
+	float *t = edges + numElForT+1;
 	for (int i=0; i<numElForT; i++)
 	{
 		t[i] = stepsize*i;
@@ -312,18 +432,37 @@ void DistratEigen::prepareNonParametric()
 	}
   	edges[numElForT] = edges[numElForT-1] + stepsize;
 
-	//Compute histogram
-	computeHist(histEnum,distEnum,edges,m_nSamples,numElForT+1);
-	computeHist(histDenom,distDenom,edges,m_nSamples,numElForT+1);
+	// l'istogramma dei log distance ratio (the bins do not depend on the data)
+	int samplesToKeep = m_nBins / 2;
+	m_nBins -= 1;
+	int halfIndex = m_nBins/2;
+
+	m_Bins [halfIndex] = 0;
+	for(int i=1; i< samplesToKeep; i++)
+	{
+		m_Bins[halfIndex+i] = t[i];
+		m_Bins[halfIndex-i] = -t[i];
+	}
+
+	for(int i=0; i<m_nBins; i++)
+	{
+		m_Edges[i] = m_Bins[i] -stepsize/2;
+	}
+	m_Edges[m_nBins] = m_Edges[m_nBins-1] + stepsize;
+
+	// calcola il logaritmo delle distanze - the values are divided by two since the coor2dist values are computed at a squared value
+	// Optimization to avoid the sqrt in the Coord2dist function
+	// Compute all the histograms in the same pass
+	computeLogDistanceRatios(edges, numElForT+1, histEnum, histDenom);
 
 	// Smussamento dela funzione modello (sembra apportare miglioramenti,
     // provato con i dataset CDVS). Diminuisce anche la probabilita' che
     // qualche elemento di modelDensity sia uguale a zero (il coefficiente c
     // di accostamento diventerebbe di conseguenza infinito).
 
-	float * modelDensity = new float[2*numElForT-1];
-	float * histDenomI = new float[numElForT];
-	float * histEnumI = new float[numElForT];
+	float * modelDensity = t + numElForT;
+	float * histDenomI = modelDensity + 2*numElForT-1;
+	float * histEnumI = histDenomI + numElForT;
 
 	for(int i=0; i<numElForT;i++)
 	{
@@ -346,40 +485,13 @@ void DistratEigen::prepareNonParametric()
 	}
 
 	// Smussamento funzione modello
-	float *filteredModelDensity = new float[2*numElForT-1 + gaussianFilterDim -1];
+	float *filteredModelDensity = histEnumI + numElForT;		// 2*numElForT-1 + gaussianFilterDim -1 elements
 	convolution(modelDensity, filteredModelDensity, m_GaussianKernel, 2*numElForT-1, gaussianFilterDim);
 
-	// l'istogramma dei log distance ratio
-	int samplesToKeep = m_nBins / 2;
-	m_nBins -= 1;
-	int halfIndex = m_nBins/2;
-
-	m_Bins [halfIndex] = 0;
-	for(int i=1; i< samplesToKeep; i++)
-	{
-		m_Bins[halfIndex+i] = t[i];
-		m_Bins[halfIndex-i] = -t[i];
-	}
-
 	for(int i=0; i<m_nBins; i++)
 	{
 		m_Fvalues[i] = filteredModelDensity[numElForT-halfIndex+i]*stepsize;
-		m_Edges[i] = m_Bins[i] -stepsize/2;
 	}
-	m_Edges[m_nBins] = m_Edges[m_nBins-1] + stepsize;
-
-	computeHist(m_Hist,LDR,m_Edges,m_nSamples,m_nBins+1);
-
-	delete [] distDenom;
-	delete [] distEnum;
-	delete [] histDenom;
-	delete [] histDenomI;
-	delete [] histEnum;
-	delete [] histEnumI;
-	delete [] t;
-	delete [] filteredModelDensity;
-	delete [] modelDensity;
-	delete [] edges;
 	return;
 }
 
@@ -468,7 +580,7 @@ bool DistratEigen::goodnessOfFit(unsigned int percentile)
 		// considerati simili.
 		int upperLimit = SAMPLES_ASYMPTOTE;
 		float newN = upperLimit*(1-exp(-m_nFeatures/upperLimit));
-		float *newHist = new float [histogramLength];
+		float newHist[maxNumBins];
 
 		//np computation
 		for(int i=0; i<histogramLength; i++)
@@ -483,8 +595,6 @@ bool DistratEigen::goodnessOfFit(unsigned int percentile)
 			float diff = (newHist[i]-m_Np[i]);
 			c+=((diff * diff)/m_Np [i]);
 		}
-
-		delete [] newHist;
 	}
 
 	if(ISNAN(c))
@@ -508,9 +618,9 @@ int DistratEigen::MLCoherence(int * inliersIndexes)
 	//Check to evaluate the amount of the histogram that can be represented my the model function
 	int histogramLength = m_nBins;
 
-	float *modelHistogram = new float [histogramLength];
-	float *quantizedDistRatio = new float [m_nSamples];
-	MatrixXf G(m_nPoints,m_nPoints);
+	float modelHistogram[maxNumBins];
+	const unsigned char *quantizedDistRatio = &m_quantizedDistRatio[0];
+	Map<MatrixXf> G(&m_DA[0], m_nPoints,m_nPoints);		// the distances of image1 are not needed anymore
 
 	for(int i=0; i<histogramLength; i++)
 	{
@@ -535,52 +645,44 @@ int DistratEigen::MLCoherence(int * inliersIndexes)
 
 	// la matrice G contiene valori che permettono il calcolo degli inlier
 	// mediante autovalore e autovettore dominante
-	//Quantizzazione uniforme
-	uniformQuantize(LDR, m_Edges, m_nSamples, m_nBins, quantizedDistRatio);
-
-	for(int i=0; i< m_nSamples; i++)
+	// The quantized ratios of the pairs (i, j) with i > j are stored column by column (see computeLogDistanceRatios):
+	// G is filled one column at a time, reading the elements above the diagonal from the previous columns.
+	const int n = m_nPoints;
+	long columnStart = 0;				// position of the pair (j+1, j) in quantizedDistRatio
+	for (int j=0; j < n; j++)
 	{
-		quantizedDistRatio[i] = m_differenceCurve[(int)quantizedDistRatio[i] -1];
-	}
-
-
-	//Creazione di G
-	int counter=0;
-	for (int i=0; i < m_nPoints; i++)
-	{
-		G(i,i) = 0.0f;
-	}
-	for (int i=0; i< m_nPoints; i++)
-	{
-		for (int j=0; j< i; j++)
+		float * column = &G(0, j);
+		long pos = j - 1;				// position of the pair (j, i) for i = 0
+		for (int i=0; i < j; i++)
+		{
+			column[i] = m_differenceCurve[quantizedDistRatio[pos] - 1];
+			pos += n - i - 2;
+		}
+		column[j] = 0.0f;
+		pos = columnStart;
+		for (int i=j+1; i < n; i++)
 		{
-			G(j,i) = quantizedDistRatio[counter];
-			G(i,j) = quantizedDistRatio[counter];
-			counter++;
+			column[i] = m_differenceCurve[quantizedDistRatio[pos++] - 1];
 		}
+		columnStart = pos;
 	}
 
 	// cerchiamo l'autovettore dominante di G
-	VectorXf u(m_nPoints);
+	m_u.resize(m_nPoints);
+	m_unew.resize(m_nPoints);
+	m_diff.resize(m_nPoints);
+	Map<VectorXf> u(&m_u[0], m_nPoints);
+	Map<VectorXf> unew(&m_unew[0], m_nPoints);
+	Map<VectorXf> diff(&m_diff[0], m_nPoints);
 	float lambda = 0.0f;
 
-	eigPowIteration(G, u, lambda, 4);	// compute dominant eigenvector of G
+	eigPowIteration(G, u, unew, diff, lambda, 4);	// compute dominant eigenvector of G
 
-	float *pin = new float [histogramLength];
-
-	float pinsum = 0;
 	float max = 0;
 	for(int i = 0; i < histogramLength; i++)
 	{
-		if (m_differenceCurve[i]> 0)
-		{
-			pin[i] = m_differenceCurve[i];
-			pinsum += m_differenceCurve[i];
-			if (m_differenceCurve[i] > max)
-				max = m_differenceCurve[i];
-		}
-		else
-			pin[i] = 0;
+		if (m_differenceCurve[i] > max)
+			max = m_differenceCurve[i];
 	}
 
 	// Estimate inliers
@@ -611,13 +713,14 @@ int DistratEigen::MLCoherence(int * inliersIndexes)
 		u(i) = u(i)*sign;
 	}
 
-	int *indexes = new int[m_nPoints];
+	m_indexes.resize(m_nPoints);
+	int *indexes = &m_indexes[0];
 	for (int i = 0; i<m_nPoints; i++)
 	{
 		indexes[i] = i;
 	}
 
-	quicksort(u, 0, m_nPoints-1, indexes);
+	quicksort(&m_u[0], 0, m_nPoints-1, indexes);
 
 	//retrieval n first numbers
 	for(int i=0; i<nEstimatedInliers; i++)
@@ -625,15 +728,10 @@ int DistratEigen::MLCoherence(int * inliersIndexes)
 		inliersIndexes[i] = indexes[m_nPoints-1-i];
 	}
 
-	delete [] indexes;
-	delete [] quantizedDistRatio;
-	delete [] pin;
-	delete [] modelHistogram;
-
 	return nEstimatedInliers;
 }
 
-void DistratEigen::eigPowIteration (const MatrixXf &G, VectorXf &u, float &lambda, int maxIterations)
+void DistratEigen::eigPowIteration (const Map<MatrixXf> &G, Map<VectorXf> &u, Map<VectorXf> &unew, Map<VectorXf> &diff, float &lambda, int maxIterations)
 {
 	size_t nPoints = G.rows();
 	static const float zerof = 1e-6f;		// floating point threshold for "zero"
@@ -642,12 +740,14 @@ void DistratEigen::eigPowIteration (const MatrixXf &G, VectorXf &u, float &lambd
 
 	float changeThreshold = 1e-3f;
 
+	// G is symmetric: its row sums are computed on the columns, which are contiguous
 	for (unsigned int i = 0; i<nPoints; i++)
 	{
+		const float * column = &G(0, i);
 		float acc = 0;
 		for (unsigned int j = 0; j<nPoints; j++)
 		{
-			acc += G(i,j);
+			acc += column[j];
 		}
 		u(i) = acc;
 	}
@@ -661,14 +761,11 @@ void DistratEigen::eigPowIteration (const MatrixXf &G, VectorXf &u, float &lambd
 		return;
 	}
 
-	VectorXf unew(nPoints);
-	VectorXf diff(nPoints);
-
 	u.normalize();
 
 	for (int i=0; i<maxIterations; i++)
 	{
-		unew = G * u; 							// unew = G*u;
+		unew.noalias() = G * u; 				// unew = G*u;
 		lambda = unew.norm();					// lambda = norm(unew);
 		unew.normalize();						// normalized unew
 
@@ -682,10 +779,11 @@ void DistratEigen::eigPowIteration (const MatrixXf &G, VectorXf &u, float &lambd
 	}
 }
 
-void DistratEigen::coord2dist(const float *v1, const float *v2, int nPoints, MatrixXf & result, bool squared)
+void DistratEigen::coord2dist(const float *v1, const float *v2, int nPoints, Map<MatrixXf> & result, bool squared, std::vector<float> & coordinates)
 {
-	Matrix<float, 4, Dynamic> A(4,nPoints);
-	Matrix<float, 4, Dynamic> B(4,nPoints);
+	coordinates.resize(8 * nPoints);
+	Map< Matrix<float, 4, Dynamic> > A(&coordinates[0], 4, nPoints);
+	Map< Matrix<float, 4, Dynamic> > B(&coordinates[4 * nPoints], 4, nPoints);
 
 	for (int j = 0; j < nPoints; j++)
 	{
@@ -703,7 +801,7 @@ void DistratEigen::coord2dist(const float *v1, const float *v2, int nPoints, Mat
 		B(3,j) = v2[j];
 	}
 
-	result = A.transpose() * B;
+	result.noalias() = A.transpose() * B;		// result does not alias A or B: no temporary is needed
 
 	//Set zero to the diagonal elements
 	for (int i=0; i < nPoints; i++)
@@ -759,62 +857,205 @@ void DistratEigen::logRootF(const float *input, float *output, int nValues, floa
 	}
 }
 
-void DistratEigen::computeHist(float *hist, float *input, float *edges, long nValues, int nEdges)
+inline int DistratEigen::histogramBin(float value, const float *edges, int nEdges, float invStep)
 {
-	int half = (int)(nEdges/2);
-	int j;
+	value += 1e-5f;
+
+	// the edges are uniformly spaced: guess the bin, then fix it comparing the value with the edges
+	float x = (value - edges[0]) * invStep;
+	x = (x > 0) ? x : 0;					// also if the value is NaN
+	x = (x < nEdges - 2) ? x : nEdges - 2;
+	int j = (int) x;
+	while ((j > 0) && (edges[j] > value))
+		j--;
+	while ((j < nEdges - 2) && (edges[j+1] <= value))
+		j++;
+
+	// a value equal to the central edge belongs to the lower bin
+	j -= (j == nEdges/2 - 1) & (value == edges[j]);
+
+	// the values out of range are counted in the element following the last bin (no branch to mispredict)
+	bool valid = (value >= edges[0]) & (value < edges[nEdges-1]) & (j >= 0);
+	return valid ? j : nEdges - 1;
+}
 
-	for (int i=0; i < (nEdges - 1); i++)
-		hist[i] = 0.0f;
+inline unsigned char DistratEigen::quantizeRatio(float value, float first, float stepSize, int nLevels)
+{
+	if (ISNAN(value))
+		return 1;
+
+	float x = ((value+1e-5f)-first)/stepSize;
+	if (!(x > 0))
+		return 1;
+	if (x > nLevels)
+		return (unsigned char) nLevels;
+
+	int result = (int) x;		// ceil(x), without the function call
+	if (result < x)
+		result++;
+	return (unsigned char) result;
+}
 
-	for (int i=0; i < nValues; i++)
+void DistratEigen::accumulateHistogram(const float * values, int n, const float * edges, int nEdges, float * hist)
+{
+	const float invStep = 1.0f / (edges[1] - edges[0]);
+	int k = 0;
+#ifdef DISTRAT_SSE2
+	// The bin of a value is given by its position relative to the first edge, unless the value is so close to an edge
+	// that the rounding errors matter: those values are checked by histogramBin
+	const __m128 offset = _mm_set1_ps(1e-5f);
+	const __m128 first = _mm_set1_ps(edges[0]);
+	const __m128 last = _mm_set1_ps(edges[nEdges-1]);
+	const __m128 inv = _mm_set1_ps(invStep);
+	const __m128 lowMargin = _mm_set1_ps(1e-3f);			// in bins: far larger than any rounding error
+	const __m128 highMargin = _mm_set1_ps(1.0f - 1e-3f);
+	const __m128i outside = _mm_set1_epi32(nEdges - 1);
+	int bins[4];
+	for (; k + 4 <= n; k += 4)
 	{
-		float value = input[i]+1e-5f;
-		if(value>edges[half-1])
+		__m128 value = _mm_add_ps(_mm_loadu_ps(values + k), offset);
+		__m128 inRange = _mm_and_ps(_mm_cmpge_ps(value, first), _mm_cmplt_ps(value, last));		// false for NaN
+		__m128 x = _mm_and_ps(_mm_mul_ps(_mm_sub_ps(value, first), inv), inRange);
+		__m128i j = _mm_cvttps_epi32(x);
+		__m128 fraction = _mm_sub_ps(x, _mm_cvtepi32_ps(j));
+		__m128 sure = _mm_and_ps(_mm_cmpge_ps(fraction, lowMargin), _mm_cmple_ps(fraction, highMargin));
+		__m128i valid = _mm_castps_si128(inRange);
+		_mm_storeu_si128((__m128i *) bins, _mm_or_si128(_mm_and_si128(valid, j), _mm_andnot_si128(valid, outside)));
+
+		int check = _mm_movemask_ps(_mm_andnot_ps(sure, inRange));
+		if (check != 0)
 		{
-			for (j = half; j<nEdges; j++)
-				if(value<edges[j])
-				{
-					j--;
-					break;
-				}
-		}
-		else{
-			for (j = half-2; j>=0; j--)
-			{
-				if(value>=edges[j])
-					break;
-			}
+			for (int i = 0; i < 4; i++)
+				if (check & (1 << i))
+					bins[i] = histogramBin(values[k + i], edges, nEdges, invStep);
 		}
 
-		if(j>=0 && j<nEdges)
-			hist[j] += 1.0f;
+		hist[bins[0]] += 1.0f;
+		hist[bins[1]] += 1.0f;
+		hist[bins[2]] += 1.0f;
+		hist[bins[3]] += 1.0f;
+	}
+#endif
+	for (; k < n; k++)
+		hist[histogramBin(values[k], edges, nEdges, invStep)] += 1.0f;
+}
 
+void DistratEigen::quantizeRatios(const float * values, int n, float first, float stepSize, int nLevels, unsigned char * results)
+{
+	int k = 0;
+#ifdef DISTRAT_SSE2
+	const __m128 offset = _mm_set1_ps(1e-5f);
+	const __m128 firstv = _mm_set1_ps(first);
+	const __m128 step = _mm_set1_ps(stepSize);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 levels = _mm_set1_ps((float) nLevels);
+	const __m128i one = _mm_set1_epi32(1);
+	for (; k + 4 <= n; k += 4)
+	{
+		__m128 x = _mm_div_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(values + k), offset), firstv), step);
+		x = _mm_min_ps(_mm_max_ps(x, zero), levels);		// NaN becomes 0
+		__m128i q = _mm_cvttps_epi32(x);
+		q = _mm_sub_epi32(q, _mm_castps_si128(_mm_cmplt_ps(_mm_cvtepi32_ps(q), x)));	// ceil: add 1 if truncated
+		__m128i small = _mm_cmplt_epi32(q, one);
+		q = _mm_or_si128(_mm_andnot_si128(small, q), _mm_and_si128(small, one));			// at least 1
+		q = _mm_packus_epi16(_mm_packs_epi32(q, q), q);
+		int packed = _mm_cvtsi128_si32(q);
+		memcpy(results + k, &packed, 4);
 	}
+#endif
+	for (; k < n; k++)
+		results[k] = quantizeRatio(values[k], first, stepSize, nLevels);
 }
 
-void DistratEigen::uniformQuantize(float *distRatios,float *samplingGrid, long nElem, int nEdges, float *results)
+void DistratEigen::computeLogDistanceRatios(const float * logEdges, int nLogEdges, float * histEnum, float * histDenom)
 {
+	const int n = m_nPoints;
+	const int nEdges = m_nBins + 1;
+
+	for (int i=0; i < nEdges; i++)		// including the element counting the values out of range
+		m_Hist[i] = 0.0f;
 
-	float stepSize = samplingGrid[1]-samplingGrid[0];
-	float step = (samplingGrid[0]);
+	if (logEdges != NULL)
+	{
+		for (int i=0; i < nLogEdges; i++)
+		{
+			histEnum[i] = 0.0f;
+			histDenom[i] = 0.0f;
+		}
+	}
+
+	// buffers for one column
+	LDR.resize(n);
+	m_distEnum.resize(n);
+	m_distDenom.resize(n);
+	m_quantizedDistRatio.resize(m_nSamples);
+	float * ldr = &LDR[0];
+	float * distEnum = &m_distEnum[0];
+	float * distDenom = &m_distDenom[0];
+	unsigned char * quantized = &m_quantizedDistRatio[0];
+#ifdef DISTRAT_SSE2
+	const float invStep = 1.0f / (m_Edges[1] - m_Edges[0]);
+	const float invLogStep = (logEdges != NULL) ? 1.0f / (logEdges[1] - logEdges[0]) : 0.0f;
+#endif
 
-	for(int i=0; i< nElem; i++)
+	// The distance matrices are symmetric: the pairs (i, j) with i > j are visited column by column, so that all accesses are sequential
+	for (int j=0; j < n - 1; j++)
 	{
-		if (ISNAN(distRatios[i]))
-			results[i] = 1;
+		const float * da = &m_DA[(long) j*n + j + 1];
+		const float * db = &m_DB[(long) j*n + j + 1];
+		const int len = n - j - 1;
+
+		if (logEdges == NULL)
+		{
+			halfLogDistanceRatios(da, db, ldr, len);		// Added small numbers to avoid Inf
+#ifdef DISTRAT_SSE2
+			// the values close to an edge are computed again by the standard log, so that their bins are exactly the same
+			for (int k=0; k < len; k += 4)
+			{
+				int check = (k + 4 <= len) ? nearEdge4(ldr + k, m_Edges[0], invStep) : 0xf;
+				for (int i = k; check != 0; i++, check >>= 1)
+					if ((check & 1) && (i < len) && nearEdge(ldr[i], m_Edges[0], invStep))
+						ldr[i] = 0.5f * log((da[i] + 1e-6f) / (db[i] + 1e-9f));
+			}
+#endif
+		}
 		else
 		{
-			results[i] = ceil(((distRatios[i]+1e-5f)-step)/stepSize);
-			if(results[i] < 1)
-				results[i] = 1;
-			if (results[i] > nEdges)
-				results[i] = (float)nEdges;
+			halfLogDistances(da, 1e-6f, distEnum, len);		// Added small numbers to avoid Inf
+			halfLogDistances(db, 1e-9f, distDenom, len);
+			for (int k=0; k < len; k++)
+				ldr[k] = distEnum[k] - distDenom[k];
+#ifdef DISTRAT_SSE2
+			// the values close to an edge are computed again by the standard log, so that their bins are exactly the same
+			for (int k=0; k < len; k += 4)
+			{
+				int check = 0xf;
+				if (k + 4 <= len)
+					check = nearEdge4(distEnum + k, logEdges[0], invLogStep) | nearEdge4(distDenom + k, logEdges[0], invLogStep) | nearEdge4(ldr + k, m_Edges[0], invStep);
+				for (int i = k; check != 0; i++, check >>= 1)
+				{
+					if ((check & 1) && (i < len) &&
+							(nearEdge(distEnum[i], logEdges[0], invLogStep) || nearEdge(distDenom[i], logEdges[0], invLogStep) || nearEdge(ldr[i], m_Edges[0], invStep)))
+					{
+						distEnum[i] = 0.5f * log(da[i] + 1e-6f);
+						distDenom[i] = 0.5f * log(db[i] + 1e-9f);
+						ldr[i] = distEnum[i] - distDenom[i];
+					}
+				}
+			}
+#endif
+
+			accumulateHistogram(distEnum, len, logEdges, nLogEdges, histEnum);
+			accumulateHistogram(distDenom, len, logEdges, nLogEdges, histDenom);
 		}
+
+		accumulateHistogram(ldr, len, m_Edges, nEdges, m_Hist);
+		quantizeRatios(ldr, len, m_Edges[0], m_Edges[1] - m_Edges[0], m_nBins, quantized);
+		quantized += len;
 	}
 }
 
-void DistratEigen::quicksort(VectorXf & vector, int beg, int end, int *indexes)
+void DistratEigen::quicksort(float * vector, int beg, int end, int *indexes)
 {
 
     int  l,r,p;
@@ -33,6 +33,7 @@
 #pragma once
 
 #include <eigen3/Eigen/Dense>
+#include <vector>
 
 using namespace Eigen;
 
@@ -49,6 +50,13 @@ class DistratEigen {
 public:
 	virtual ~DistratEigen();
 
+	/**
+	 * Default constructor; setPoints() must be called before estimateInliers().
+	 * An instance can be reused for any number of point sets: its working memory is kept and grows only when needed,
+	 * so no memory is allocated once it has processed the largest set of points.
+	 */
+	DistratEigen();
+
 	/**
 	 * Parametric constructor.
 	 * @param x1 a vector containing the first coordinate of all the points belonging to the first image
@@ -59,6 +67,17 @@ public:
 	 */
 	DistratEigen(const float *x1, const float *x2, const float *y1, const float *y2, int size);
 
+	/**
+	 * Set the points to check in the next call of estimateInliers().
+	 * The coordinates are not copied, so they must be valid until estimateInliers() returns.
+	 * @param x1 a vector containing the first coordinate of all the points belonging to the first image
+	 * @param x2 contains the second coordinate on the first image
+	 * @param y1 contains the first coordinate on the second image
+	 * @param y2 contains the second coordinate on the second image
+	 * @param size the number of elements of all (x1, x2, y1, y2) vectors
+	 */
+	void setPoints(const float *x1, const float *x2, const float *y1, const float *y2, int size);
+
 	/**
 	 * Function computing the estimation of the number of inliers (DISTRAT core).
 	 * @param useParametric if true the parametric version of Distrat is used, instead of the non-parametric one
@@ -123,12 +142,23 @@ private:
 	//number of matchings
 	int m_nPoints;
 
-	// Matrix of distances computed from points of image1
-	MatrixXf DA;
-	// Matrix of distances computed from points of image2
-	MatrixXf DB;
-	// Log Distance Ratio matrix
-	float *LDR;
+	// Matrix of distances computed from points of image1 (column-major m_nPoints x m_nPoints); its memory is reused for the matrix G in MLCoherence
+	std::vector<float> m_DA;
+	// Matrix of distances computed from points of image2 (column-major m_nPoints x m_nPoints)
+	std::vector<float> m_DB;
+	// Log Distance Ratios of one column of the distance matrices
+	std::vector<float> LDR;
+
+	// Working memory, kept across calls
+	std::vector<float> m_coordinates;		// coordinate products used by coord2dist
+	std::vector<float> m_distEnum;			// log distances of the points of image1 (one column)
+	std::vector<float> m_distDenom;			// log distances of the points of image2 (one column)
+	std::vector<unsigned char> m_quantizedDistRatio;	// quantized log distance ratios of all the pairs of points
+	std::vector<float> m_u;					// dominant eigenvector of G
+	std::vector<float> m_unew;				// next estimate of the dominant eigenvector
+	std::vector<float> m_diff;				// difference of two estimates of the dominant eigenvector
+	std::vector<int> m_indexes;				// indexes of the sorted eigenvector elements
+	std::vector<float> m_hist;				// histograms and model densities of prepareNonParametric
 
 	//Initial values for image dimensions
 	float m_stdA;
@@ -147,7 +177,7 @@ private:
 	float m_nFeatures;
 
 	/* Private methods */
-	static void eigPowIteration (const MatrixXf &G, VectorXf &u, float &lambda, int maxIterations);
+	static void eigPowIteration (const Map<MatrixXf> &G, Map<VectorXf> &u, Map<VectorXf> &unew, Map<VectorXf> &diff, float &lambda, int maxIterations);
 
 	/**
 	 * Computes the convolution of arrays x and h and produces the result in y.
@@ -166,8 +196,9 @@ private:
 	 * @param nPoints number of points
 	 * @param result a matrix containing the resulting distances
 	 * @param squared input parameter, if true the square of distances are provided (instead of the plain distances)
+	 * @param coordinates working memory
 	 */
-	static void coord2dist(const float *v1, const float *v2, int nPoints, MatrixXf & result, bool squared);
+	static void coord2dist(const float *v1, const float *v2, int nPoints, Map<MatrixXf> & result, bool squared, std::vector<float> & coordinates);
 
 	/**
 	 * Computes the average and standard deviation of an array of float.
@@ -188,24 +219,57 @@ private:
 	static void logRootF(const float *input, float*output, int nValues, float scalingFactor);
 
 	/**
-	 * Computation of histograms for a vector.
-	 * @param hist output histogram of input values, where (nEdges - 1) values will be returned
-	 * @param input input array
+	 * Get the histogram bin of a value, exactly as a linear search on the edges would (the edges must be uniformly spaced).
+	 * A small offset is added to the value; a value equal to the central edge belongs to the lower bin.
+	 * @param value the input value
 	 * @param edges limits of histogram bins
-	 * @param nValues length of input array
 	 * @param nEdges lenght of edges array
+	 * @param invStep the inverse of the distance between two consecutive edges
+	 * @return the bin index, or nEdges - 1 if the value does not belong to any bin
+	 */
+	static int histogramBin(float value, const float *edges, int nEdges, float invStep);
+
+	/**
+	 * Add the values of an array to a histogram, computing the bins of four values at a time when possible.
+	 * Same as incrementing hist[histogramBin(value)] for each value.
+	 * @param values input array
+	 * @param n length of input array
+	 * @param edges limits of histogram bins (uniformly spaced)
+	 * @param nEdges lenght of edges array
+	 * @param hist histogram of nEdges - 1 bins, followed by the element counting the values out of range
+	 */
+	static void accumulateHistogram(const float * values, int n, const float * edges, int nEdges, float * hist);
+
+	/**
+	 * Uniform quantization of an array of values, four at a time when possible; same as quantizeRatio() for each value.
+	 * @param values the values to be quantized
+	 * @param n length of input and output arrays
+	 * @param first the first quantization edge
+	 * @param stepSize the quantization step
+	 * @param nLevels number of quantization levels
+	 * @param results the quantization levels
+	 */
+	static void quantizeRatios(const float * values, int n, float first, float stepSize, int nLevels, unsigned char * results);
+
+	/**
+	 * Uniform quantization of a value.
+	 * @param value the value to be quantized
+	 * @param first the first quantization edge
+	 * @param stepSize the quantization step
+	 * @param nLevels number of quantization levels
+	 * @return the quantization level, from 1 to nLevels (1 if the value is NaN)
 	 */
-	static void computeHist(float *hist, float *input, float *edges, long nValues, int nEdges);
+	static unsigned char quantizeRatio(float value, float first, float stepSize, int nLevels);
 
 	/**
-	 * Uniform quantization
-	 * @param distRatios input array to be quantized
-	 * @param samplingGrid quantization centroids array
-	 * @param nElem length of input and output array
-	 * @param nEdges number of quantization levels
-	 * @param results quantized output array
+	 * Compute the log distance ratios of all the pairs of points, and in the same pass their histogram on m_Edges (m_Hist)
+	 * and their quantization on m_Edges (m_quantizedDistRatio, stored column by column of the lower triangle of the distance matrix).
+	 * @param logEdges edges of the histograms of the log distances of each image (NULL for the parametric version, that only needs the ratios)
+	 * @param nLogEdges lenght of the logEdges array
+	 * @param histEnum output histogram of the log distances of the points of image1 (nLogEdges - 1 values)
+	 * @param histDenom output histogram of the log distances of the points of image2 (nLogEdges - 1 values)
 	 */
-	static void uniformQuantize(float *distRatios,float *samplingGrid, long nElem,  int nEdges, float *results);
+	void computeLogDistanceRatios(const float * logEdges, int nLogEdges, float * histEnum, float * histDenom);
 
 	/**
 	 * Stand-alone quicksort, returns a sorted array of values and indexes.
@@ -214,7 +278,7 @@ private:
 	 * @param end index of the last element to sort
 	 * @param indexes input/output indexes of sorted values
 	 */
-	static void quicksort(VectorXf & vector, int beg, int end, int *indexes);
+	static void quicksort(float * vector, int beg, int end, int *indexes);
 
 	//Initialization
 	void prepareParametric();
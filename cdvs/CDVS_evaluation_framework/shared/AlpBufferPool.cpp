@@ -0,0 +1,182 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include "AlpBufferPool.h"
+#include "AlpOctave.h"
+#include "ThreadLocal.h"
+#include <stdint.h>
+
+using namespace mpeg7cdvs;
+using namespace std;
+
+AlpBufferPool::AlpBufferPool():memory(NULL),block(NULL),blockSize(0),used(0),busy(false),abandoned(false),overflow(),keypointStore(),tileStore()
+{}
+
+AlpBufferPool::~AlpBufferPool()
+{
+	for (size_t k = 0; k < overflow.size(); ++k)
+		delete[] overflow[k];
+
+	delete[] memory;
+}
+
+/*
+ * Align the given pointer to the next multiple of 64 bytes.
+ */
+static float * align(float * p)
+{
+	uintptr_t addr = (uintptr_t) p;
+	return (float *) ((addr + 63) & ~((uintptr_t) 63));
+}
+
+bool AlpBufferPool::acquire()
+{
+	bool acquired = false;
+
+	#pragma omp critical (alp_buffer_pool)
+	if (! busy)
+	{
+		busy = true;
+		acquired = true;
+	}
+
+	if (acquired)
+		used = 0;
+
+	return acquired;
+}
+
+void AlpBufferPool::release()
+{
+	if (used > blockSize)
+	{
+		// replace the block and the overflow buffers with a single block of the size needed by this image
+
+		for (size_t k = 0; k < overflow.size(); ++k)
+			delete[] overflow[k];
+		overflow.clear();
+
+		delete[] memory;
+		memory = new float[used + alignment - 1];
+		block = align(memory);
+		blockSize = used;
+	}
+
+	used = 0;
+
+	// the pool is handed over to the next acquire(), which may run on the owning thread while this one is another thread
+	bool orphan;
+	#pragma omp critical (alp_buffer_pool)
+	{
+		busy = false;
+		orphan = abandoned;
+	}
+
+	if (orphan)
+		delete this;
+}
+
+void AlpBufferPool::abandon()
+{
+	bool inUse;
+	#pragma omp critical (alp_buffer_pool)
+	{
+		abandoned = true;
+		inUse = busy;
+	}
+
+	if (! inUse)
+		delete this;
+}
+
+float * AlpBufferPool::get(size_t size)
+{
+	size = (size + alignment - 1) & ~(alignment - 1);		// keep the next buffer aligned
+
+	float * p;
+	if (used + size <= blockSize)
+	{
+		p = block + used;
+	}
+	else
+	{
+		overflow.push_back(new float[size + alignment - 1]);
+		p = align(overflow.back());
+	}
+
+	used += size;
+	return p;
+}
+
+vector<FeatureAlp> & AlpBufferPool::keypoints(size_t index)
+{
+	if (index >= keypointStore.size())
+		keypointStore.resize(index + 1);
+
+	return keypointStore[index];
+}
+
+vector<unsigned char> & AlpBufferPool::tiles(size_t index)
+{
+	if (index >= tileStore.size())
+		tileStore.resize(index + 1);
+
+	return tileStore[index];
+}
+
+size_t AlpBufferPool::capacity() const
+{
+	return blockSize;
+}
+
+namespace {
+
+/*
+ * The pool of a thread, abandoned when the thread ends.
+ */
+class PoolOwner
+{
+public:
+	AlpBufferPool * pool;
+
+	PoolOwner():pool(new AlpBufferPool()) {}
+	~PoolOwner() { pool->abandon(); }
+};
+
+ThreadLocal<PoolOwner> threadPools;
+
+}	// end of anonymous namespace
+
+AlpBufferPool & AlpBufferPool::threadLocal()
+{
+	return *threadPools.get().pool;
+}
@@ -0,0 +1,125 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace mpeg7cdvs
+{
+
+class FeatureAlp;
+
+/**
+ * @class AlpBufferPool
+ * Per-thread working memory of the ALP detector.
+ * The image buffers of all octaves are carved out of a single block, aligned to 64 bytes, which is resized to the
+ * largest requirement seen so far when the pool is released; the keypoint vectors of the octaves are kept here too.
+ * A thread that keeps encoding images stops allocating detector memory once it has processed the largest image,
+ * and its memory use is bounded by the needs of that image.
+ * The pool may be released by a thread other than the one that acquired it (e.g. when a detector is destroyed
+ * by another thread), and it outlives its thread if it is still in use when the thread ends.
+ */
+class AlpBufferPool
+{
+private:
+	static const size_t alignment = 16;		// alignment of the buffers, in floats
+
+	float * memory;			// the allocated block
+	float * block;			// the aligned start of the block
+	size_t blockSize;		// usable size of the block, in floats
+	size_t used;			// floats given out since the pool was acquired (may exceed blockSize)
+	bool busy;				// true if the pool is in use
+	bool abandoned;			// true if the thread owning the pool has ended (the pool is deleted when released)
+	std::vector<float *> overflow;		// buffers allocated when the block was too small
+	std::vector< std::vector<FeatureAlp> > keypointStore;
+	std::vector< std::vector<unsigned char> > tileStore;
+
+	AlpBufferPool(const AlpBufferPool &);				// not copyable
+	AlpBufferPool & operator=(const AlpBufferPool &);
+
+public:
+	AlpBufferPool();			///< constructor
+	~AlpBufferPool();			///< destructor
+
+	/**
+	 * Start using the pool; all buffers given out before are invalidated.
+	 * @return false if the pool is already in use (e.g. by another detector in the same thread).
+	 */
+	bool acquire();
+
+	/**
+	 * Stop using the pool; if the block was too small, it is resized to the memory used since acquire().
+	 * If the thread owning the pool has ended, the pool is deleted.
+	 */
+	void release();
+
+	/**
+	 * Called when the thread owning the pool ends: delete the pool, or let release() delete it if the pool is in use.
+	 * Only pools allocated on the heap can be abandoned.
+	 */
+	void abandon();
+
+	/**
+	 * Get a buffer from the pool, valid until the pool is released.
+	 * @param size the number of floats
+	 * @return a buffer aligned to 64 bytes
+	 */
+	float * get(size_t size);
+
+	/**
+	 * Get a reusable keypoint vector.
+	 * @param index the index of the vector
+	 * @return the vector (its content is unspecified)
+	 */
+	std::vector<FeatureAlp> & keypoints(size_t index);
+
+	/**
+	 * Get a reusable byte vector.
+	 * @param index the index of the vector
+	 * @return the vector (its content is unspecified)
+	 */
+	std::vector<unsigned char> & tiles(size_t index);
+
+	size_t capacity() const;		///< return the size of the block, in floats
+
+	/**
+	 * Get the pool of the calling thread.
+	 * The pool is created at the first call in each thread, and destroyed when the thread ends (or when it is
+	 * released, if it is still in use at that time).
+	 * @return the pool of the calling thread.
+	 */
+	static AlpBufferPool & threadLocal();
+};
+
+}	// end of namespace
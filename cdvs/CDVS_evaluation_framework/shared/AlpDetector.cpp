@@ -35,20 +35,61 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <string>
 
 // exceptions
 #include "CdvsException.h"
 
+#ifdef _OPENMP
+  #include <omp.h>		// use OpenMP multithreading if supported
+#endif
+
 using namespace mpeg7cdvs;
 using namespace std;
 
-AlpDetector::AlpDetector():alpKeypoints()
+AlpDetector::AlpDetector():alpKeypoints(),pool(NULL)
 {
 	verbose = 0;
+	nThreads = 1;
 }
 
 AlpDetector::~AlpDetector()
-{}
+{
+	if (pool != NULL)
+	{
+		for (int k = 0; k < maxNumberOctaves; ++k)
+			octaves[k].detach();
+
+		alpKeypoints.swap(pool->keypoints(maxNumberOctaves));
+		pool->release();
+	}
+}
+
+/*
+ * The octave buffers are taken from the pool of the calling thread, so that a thread encoding many images
+ * stops allocating memory once it has processed the largest image. The pool stays acquired until this detector
+ * is destroyed, because extract() still uses the octave buffers; the destructor releases it into the pool it
+ * was taken from, whatever thread runs it. If another detector of the same thread holds it, this one uses the
+ * heap as before.
+ */
+void AlpDetector::attachPool()
+{
+	if (pool != NULL)
+		return;		// already attached
+
+	AlpBufferPool & threadPool = AlpBufferPool::threadLocal();
+	if (! threadPool.acquire())
+		return;
+
+	pool = &threadPool;
+	for (int k = 0; k < maxNumberOctaves; ++k)
+		octaves[k].attach(threadPool, k);
+
+	std::vector<FeatureAlp> & storage = pool->keypoints(maxNumberOctaves);
+	storage.clear();
+	storage.insert(storage.end(), alpKeypoints.begin(), alpKeypoints.end());
+	alpKeypoints.swap(storage);
+}
 
 /*
  * Detect keypoints using the ALP algorithm.
@@ -68,30 +109,45 @@ void AlpDetector::detect(FeatureList & featurelist, const Parameters &params)
 {
 	int noctaves = 0;
 	verbose = params.debugLevel;
+	attachPool();
 
-	if (octaves[0].init(buffer.data(), width, height))		// input: the original image
+	nThreads = 1;
+#ifdef _OPENMP
+	nThreads = std::max(1, params.extractionThreads);
+	if (omp_get_active_level() >= omp_get_max_active_levels())
+		nThreads = 1;		// already inside a parallel region (e.g. one thread per image): a nested team would have one thread
+#endif
+
+	if (nThreads > 1)
 	{
-		octaves[0].detect();			// detect keypoints in this octave
-		noctaves++;
+		noctaves = detectParallel();
 	}
-
-	for (int k = 1; k < maxNumberOctaves; ++k)
+	else
 	{
-		if (octaves[k].init(octaves[k - 1]))					// input: the previous octave
+		if (octaves[0].init(buffer.data(), width, height))		// input: the original image
 		{
-			octaves[k].detect();			// detect keypoints in this octave
-			octaves[k].detectDuplicates(octaves[k - 1]);	// detect duplicates using previous octave
-			noctaves++;							// count the number of octaves
+			octaves[0].detect();			// detect keypoints in this octave
+			noctaves++;
+		}
+
+		for (int k = 1; k < maxNumberOctaves; ++k)
+		{
+			if (octaves[k].init(octaves[k - 1]))					// input: the previous octave
+			{
+				octaves[k].detect();			// detect keypoints in this octave
+				octaves[k].detectDuplicates(octaves[k - 1]);	// detect duplicates using previous octave
+				noctaves++;							// count the number of octaves
+			}
+			else
+				break;				// end loop
 		}
-		else
-			break;				// end loop
 	}
 
     // get key points at all octaves
 
 	for (int k=0; k<noctaves; ++k)
 	{
-		octaves[k].getAlpKeypoints(alpKeypoints);	// get the detected key points
+		octaves[k].getAlpKeypoints(alpKeypoints, true, params.lazyGradients);	// get the detected key points
 	}	// end for all octaves
 
 
@@ -100,16 +156,81 @@ void AlpDetector::detect(FeatureList & featurelist, const Parameters &params)
 	sortPdf(alpKeypoints, width, height);
 }
 
+/*
+ * Octave pipeline: only the init() of octave k depends on octave k-1 (it subsamples its G3), so one thread initializes
+ * the octaves in sequence while the detection of each octave runs as a task as soon as the octave is initialized.
+ * The duplicates of octave k are marked when both octave k and k-1 have been detected; as each duplicate detection
+ * also depends on the previous one, they run in the same order as in the serial code, so the results are identical.
+ */
+int AlpDetector::detectParallel()
+{
+	int noctaves = 0;
+	char detected[maxNumberOctaves];		// task dependencies: the keypoints of each octave
+	std::string errorMessage;				// exceptions cannot leave the parallel region
+	(void) detected;						// only used by the depend clauses (unused without OpenMP)
+
+	#pragma omp parallel num_threads(nThreads) default(shared)
+	#pragma omp single
+	{
+		try
+		{
+			for (int k = 0; k < maxNumberOctaves; ++k)
+			{
+				if (! ((k == 0) ? octaves[0].init(buffer.data(), width, height) : octaves[k].init(octaves[k - 1])))
+					break;				// the octave is too small: end loop
+
+				noctaves++;				// count the number of octaves
+
+				#pragma omp task firstprivate(k) depend(out: detected[k])
+				{
+					try {
+						octaves[k].detect();			// detect keypoints in this octave
+					}
+					catch (std::exception & ex) {
+						#pragma omp critical (alp_detect_error)
+						if (errorMessage.empty())
+							errorMessage = ex.what();
+					}
+				}
+
+				if (k > 0)
+				{
+					#pragma omp task firstprivate(k) depend(inout: detected[k - 1], detected[k])
+					octaves[k].detectDuplicates(octaves[k - 1]);	// detect duplicates using previous octave
+				}
+			}
+		}
+		catch (std::exception & ex)
+		{
+			#pragma omp critical (alp_detect_error)
+			if (errorMessage.empty())
+				errorMessage = ex.what();
+		}
+	}		// end parallel: all tasks are completed here
+
+	if (!errorMessage.empty())
+		throw CdvsException(errorMessage);
+
+	return noctaves;
+}
+
 void AlpDetector::extract(FeatureList & featurelist, size_t num) const
 {
 	if (featurelist.features.size() >= num)
 		return;			// nothing to do: the required number of features have already been extracted
 
-//	#pragma omp parallel for default(shared)
+	featurelist.features.reserve(std::min(num, featurelist.features.size() + alpKeypoints.size()));		// most keypoints have a single orientation
 
-	for(std::vector<FeatureAlp>::const_iterator d = alpKeypoints.begin() ; (d < alpKeypoints.end()) && (featurelist.features.size() < num); ++d)
+	if (nThreads > 1)
+	{
+		extractParallel(featurelist, num);
+	}
+	else
 	{
-		octaves[d->octave].computeDescriptor(featurelist, *d, true, num - featurelist.features.size());
+		for(std::vector<FeatureAlp>::const_iterator d = alpKeypoints.begin() ; (d < alpKeypoints.end()) && (featurelist.features.size() < num); ++d)
+		{
+			octaves[d->octave].computeDescriptor(featurelist, *d, true, num - featurelist.features.size());
+		}
 	}
 
 	if (verbose > 0)
@@ -120,6 +241,61 @@ void AlpDetector::extract(FeatureList & featurelist, size_t num) const
 	}
 }
 
+/*
+ * Parallel version of extract(): the keypoints are processed in batches of the size of the missing features
+ * (each keypoint usually produces one feature). The orientations of a batch are computed in parallel; then the
+ * features to be described are selected in sortPdf() order, exactly as in the serial loop, and their descriptors
+ * are computed in parallel into preallocated slots of featurelist.
+ */
+void AlpDetector::extractParallel(FeatureList & featurelist, size_t num) const
+{
+	std::vector<int> nangles;
+	std::vector<double> angles;
+	std::vector< std::pair<int, int> > slots;		// (keypoint in the batch, orientation) of each output feature
+
+	size_t next = 0;		// first keypoint of the batch
+	while ((featurelist.features.size() < num) && (next < alpKeypoints.size()))
+	{
+		size_t missing = num - featurelist.features.size();
+		int batch = (int) std::min(missing, alpKeypoints.size() - next);
+		const FeatureAlp * keypoints = &alpKeypoints[next];
+
+		for (int i = 0; i < batch; ++i)		// lazy gradients are computed serially (they are cached per octave)
+			octaves[keypoints[i].octave].prepareGradients(keypoints[i], true);
+
+		nangles.resize(batch);
+		angles.resize(4 * batch);
+
+		#pragma omp parallel for num_threads(nThreads) schedule(dynamic, 16)
+		for (int i = 0; i < batch; ++i)
+			nangles[i] = octaves[keypoints[i].octave].computeOrientations(keypoints[i], true, &angles[4 * i]);
+
+		// select the output features as in the serial loop: stop when the missing features are reached
+
+		slots.clear();
+		int used = 0;		// number of keypoints of the batch used
+		while ((used < batch) && (slots.size() < missing))
+		{
+			int n = (int) std::min((size_t) nangles[used], missing - slots.size());
+			for (int q = 0; q < n; ++q)
+				slots.push_back(std::make_pair(used, q));
+			++used;
+		}
+
+		size_t base = featurelist.features.size();
+		featurelist.features.resize(base + slots.size());
+
+		#pragma omp parallel for num_threads(nThreads) schedule(dynamic, 4)
+		for (int k = 0; k < (int) slots.size(); ++k)
+		{
+			const FeatureAlp & keypoint = keypoints[slots[k].first];
+			octaves[keypoint.octave].computeDescriptor(featurelist.features[base + k], keypoint, true, angles[4 * slots[k].first + slots[k].second]);
+		}
+
+		next += used;
+	}
+}
+
 // implementation of sortPdf() for this type of keypoints (ALP)
 // statistics optained removing the limit on the number of keypoints stored in the cache files
 // so that this feature selection does not depend from any previous version of the same
@@ -168,28 +344,31 @@ void AlpDetector::sortPdf(FeatureList & featurelist)
 {
 	if(featurelist.features.size()>0)
 	{
-		float distFromCenter;
-		float diffx, diffy;
 		float halfImageWidth = (float) featurelist.imageWidth/2;
 		float halfImageHeight = (float) featurelist.imageHeight/2;
 
 		for(std::vector<Feature>::iterator p=featurelist.features.begin(); p<featurelist.features.end(); ++p)
 		{
-			diffx = p->x - halfImageWidth;
-			diffy = p->y - halfImageHeight;
-			distFromCenter = sqrt(diffx*diffx + diffy*diffy);
-
-			p->pdf = fastScalarQuantize(distFromCenter, DistC, DistP, sizeof(DistC)/sizeof(float))
-				   * fastScalarQuantize(p->scale, ScaleC, ScaleP, sizeof(ScaleC)/sizeof(float))
-				   * fastScalarQuantize(fabs(p->peak), PeakC, PeakP, sizeof(PeakC)/sizeof(float))
-				   * fastScalarQuantize(fabs(p->curvRatio), CurvRatioC, CurvRatioP, sizeof(CurvRatioC)/sizeof(float))
-				   * fastScalarQuantize(fabs(p->curvSigma), CurvSigmaC, CurvSigmaP, sizeof(CurvSigmaC)/sizeof(float));
+			p->pdf = computePdf(*p, halfImageWidth, halfImageHeight);
 		}
 
 		std::stable_sort(featurelist.features.begin(), featurelist.features.end(), sortPdfPredicate);
 	}
 }
 
+float AlpDetector::computePdf(const Feature & feature, float halfImageWidth, float halfImageHeight)
+{
+	float diffx = feature.x - halfImageWidth;
+	float diffy = feature.y - halfImageHeight;
+	float distFromCenter = sqrt(diffx*diffx + diffy*diffy);
+
+	return fastScalarQuantize(distFromCenter, DistC, DistP, sizeof(DistC)/sizeof(float))
+		   * fastScalarQuantize(feature.scale, ScaleC, ScaleP, sizeof(ScaleC)/sizeof(float))
+		   * fastScalarQuantize(fabs(feature.peak), PeakC, PeakP, sizeof(PeakC)/sizeof(float))
+		   * fastScalarQuantize(fabs(feature.curvRatio), CurvRatioC, CurvRatioP, sizeof(CurvRatioC)/sizeof(float))
+		   * fastScalarQuantize(fabs(feature.curvSigma), CurvSigmaC, CurvSigmaP, sizeof(CurvSigmaC)/sizeof(float));
+}
+
 bool AlpDetector::sortAlpPredicate(const FeatureAlp &f1, const FeatureAlp &f2)
 {
   return f1.pdf > f2.pdf;
@@ -71,6 +71,15 @@ public:
 	 */
 	static void sortPdf(FeatureList & featurelist);
 
+	/**
+	 * Compute the probability of a feature to be matched, used to sort the features in descending order of importance.
+	 * @param feature the feature (with absolute coordinates and scale)
+	 * @param halfImageWidth half the width of the (possibly resampled) image
+	 * @param halfImageHeight half the height of the (possibly resampled) image
+	 * @return the pdf of the feature
+	 */
+	static float computePdf(const Feature & feature, float halfImageWidth, float halfImageHeight);
+
 	/**
 	 * Sort the given ALP features in descending order of importance.
 	 * @param alpFeatures the detected keypoints (without descriptor information and/or storage)
@@ -83,9 +92,14 @@ private:
 	static const int maxNumberOctaves = 8;
 	AlpOctave octaves[maxNumberOctaves];		// keep one instance per octave
 	int verbose;
+	int nThreads;								// max number of threads used by detect() and extract()
 	std::vector<FeatureAlp> alpKeypoints;
+	AlpBufferPool * pool;						// the working memory of the calling thread (NULL if it is used by another detector)
 
+	void attachPool();						// take the octave buffers from the pool of the calling thread, if available
 	static bool sortAlpPredicate(const FeatureAlp &f1, const FeatureAlp &f2);
+	int detectParallel();					// detect the octaves as parallel tasks using nThreads threads; returns the number of octaves
+	void extractParallel(FeatureList & featurelist, size_t num) const;	// extract the descriptors using nThreads threads
 
 	// constants used in sortPdf()
 	static const float DistC[];
@@ -68,13 +68,22 @@ void AlpDetectorBF::detect(FeatureList & featurelist, const Parameters &params)
 
 	AlpOctaveBF octave;				// keep only one instance of AlpOctave
 	octave.filters = &frequencyfilter;
-	if (octave.processOctave(featurelist, buffer.data(), width, height))		// process first octave
-	{
-		while (octave.processOctave(featurelist))			// process next octaves
+	frequencyfilter.Acquire();		// the FFT buffers of this thread, only needed while processing the octaves
+	try {
+		if (octave.processOctave(featurelist, buffer.data(), width, height))		// process first octave
 		{
+			while (octave.processOctave(featurelist))			// process next octaves
+			{
 
+			}
 		}
 	}
+	catch (...)
+	{
+		frequencyfilter.Release();
+		throw;
+	}
+	frequencyfilter.Release();
 	AlpDetector::sortPdf(featurelist);	// sort keypoints in descending order of importance
 }
 
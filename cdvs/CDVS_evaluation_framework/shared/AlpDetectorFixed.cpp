@@ -0,0 +1,136 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include "AlpDetectorFixed.h"
+#include "AlpDetector.h"
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+// exceptions
+#include "CdvsException.h"
+
+using namespace std;
+using namespace mpeg7cdvs;
+
+AlpDetectorFixed::AlpDetectorFixed():alpKeypoints(),pool(NULL)
+{
+	verbose = 0;
+}
+
+AlpDetectorFixed::~AlpDetectorFixed()
+{
+	if (pool != NULL)
+	{
+		for (int k = 0; k < maxNumberOctaves; ++k)
+			octaves[k].detach();
+
+		alpKeypoints.swap(pool->keypoints(maxNumberOctaves));
+		pool->release();
+	}
+}
+
+/*
+ * Use the buffer pool of the calling thread, as in AlpDetector::attachPool().
+ */
+void AlpDetectorFixed::attachPool()
+{
+	if (pool != NULL)
+		return;		// already attached
+
+	AlpBufferPool & threadPool = AlpBufferPool::threadLocal();
+	if (! threadPool.acquire())
+		return;
+
+	pool = &threadPool;
+	for (int k = 0; k < maxNumberOctaves; ++k)
+		octaves[k].attach(threadPool, k);
+
+	std::vector<FeatureAlp> & storage = pool->keypoints(maxNumberOctaves);
+	storage.clear();
+	storage.insert(storage.end(), alpKeypoints.begin(), alpKeypoints.end());
+	alpKeypoints.swap(storage);
+}
+
+/*
+ * Detect keypoints using the ALP algorithm, as in AlpDetector::detect() (serial version).
+ */
+void AlpDetectorFixed::detect(FeatureList & featurelist, const Parameters &params)
+{
+	int noctaves = 0;
+	verbose = params.debugLevel;
+	attachPool();
+
+	if (octaves[0].init(buffer.data(), width, height))		// input: the original image
+	{
+		octaves[0].detect();			// detect keypoints in this octave
+		noctaves++;
+	}
+
+	for (int k = 1; (k < maxNumberOctaves) && (noctaves == k); ++k)
+	{
+		if (octaves[k].init(octaves[k - 1]))					// input: the previous octave
+		{
+			octaves[k].detect();			// detect keypoints in this octave
+			octaves[k].detectDuplicates(octaves[k - 1]);	// detect duplicates using previous octave
+			noctaves++;							// count the number of octaves
+		}
+	}
+
+	// get key points at all octaves (after all octaves have been initialized: each one uses a level of the previous one)
+
+	for (int k=0; k<noctaves; ++k)
+	{
+		octaves[k].getAlpKeypoints(alpKeypoints, true, params.lazyGradients);	// get the detected key points
+	}
+
+	// sort keypoints in descending order of importance
+
+	AlpDetector::sortPdf(alpKeypoints, width, height);
+}
+
+void AlpDetectorFixed::extract(FeatureList & featurelist, size_t num) const
+{
+	featurelist.features.reserve(std::min(num, featurelist.features.size() + alpKeypoints.size()));
+
+	for(std::vector<FeatureAlp>::const_iterator d = alpKeypoints.begin() ; (d < alpKeypoints.end()) && (featurelist.features.size() < num); ++d)
+	{
+		octaves[d->octave].computeDescriptor(featurelist, *d, true, num - featurelist.features.size());
+	}
+
+	if (verbose > 0)
+	{
+		printHeader("AlpDetectorFixed.cpp", featurelist.features.size());
+		for(std::vector<Feature>::const_iterator d=featurelist.features.begin(); d<featurelist.features.end(); ++d)
+			printDescr(*d);
+	}
+}
@@ -39,6 +39,10 @@
 // exceptions
 #include "CdvsException.h"
 
+#ifdef _OPENMP
+  #include <omp.h>		// use OpenMP multithreading if supported
+#endif
+
 using namespace std;
 using namespace mpeg7cdvs;
 
@@ -65,11 +69,35 @@ void AlpDetectorLowMem::detect(FeatureList & featurelist, const Parameters &para
 {
 	verbose = params.debugLevel;	// import the debugging level
 
-	AlpOctave octave;				// keep only one instance of AlpOctave
+	int nThreads = 1;
+#ifdef _OPENMP
+	nThreads = std::max(1, params.extractionThreads);
+	if (omp_get_active_level() >= omp_get_max_active_levels())
+		nThreads = 1;		// already inside a parallel region (e.g. one thread per image): a nested team would have one thread
+#endif
+
+	// the encoder keeps only the first selectMaxPoints features: the others are not described (see FeatureBudget)
+
+	size_t first = featurelist.features.size();
+	FeatureBudget budget(params.selectMaxPoints, featurelist.imageWidth, featurelist.imageHeight);		// the size used by sortPdf()
+	process(featurelist, params, nThreads, &budget);
+
+	if (! budget.select(featurelist))
+	{
+		// not expected (see FeatureBudget::select()): process the image again describing all keypoints
+
+		featurelist.features.erase(featurelist.features.begin() + first, featurelist.features.end());
+		process(featurelist, params, nThreads, NULL);
+	}
+}
+
+void AlpDetectorLowMem::process(FeatureList & featurelist, const Parameters &params, int nThreads, FeatureBudget * budget)
+{
+	AlpOctave octave;				// keep only one instance of AlpOctave (plus one per thread for the strips of the first octave)
 
-	if (octave.processFirst(buffer.data(), width, height, featurelist))		// process first octave
+	if (octave.processFirst(buffer.data(), width, height, featurelist, params.lowMemStrips, nThreads))		// process first octave
 	{
-		while (octave.processNext(featurelist))			// process next octaves
+		while (octave.processNext(featurelist, budget))			// process next octaves
 		{}
 	}
 
@@ -67,6 +67,8 @@ public:
 private:
 
 	int verbose;
+
+	void process(FeatureList & featurelist, const Parameters &params, int nThreads, FeatureBudget * budget);	// detect and describe all octaves, then sort
 };
 
 }  // end of namespace
@@ -43,6 +43,7 @@
 #include <algorithm>
 #include "CdvsException.h"
 #include "vl/sift.h"		// vl_feat library
+#include "vl/mathop.h"
 
 using namespace std;
 using namespace mpeg7cdvs;
@@ -185,7 +186,7 @@ float FeatureAlp::distL1(const FeatureAlp & other) const
 }
 
 
-AlpOctave::AlpOctave():height(0),width(0),octave(0),keypoints(),extraTopLines(0),extraBottomLines(0),capacity(0),fast_mode(false) 
+AlpOctave::AlpOctave():height(0),width(0),octave(0),keypoints(),extraTopLines(0),extraBottomLines(0),capacity(0),fast_mode(false),gradientTiles(),lazyGradMod(NULL),pool(NULL),poolIndex(0) 
 {
 	G1 = G2 = G3 = G4 = L1 = L2 = L3 = L4 = A = B = C = D = tmp = nextG1 = NULL;
 	minResponse = maxResponse = minScale = maxScale = NULL;
@@ -202,18 +203,18 @@ AlpOctave::~AlpOctave()
 
 /*
  * Process the first octave.
- * If the image is greater than a certain limit, it is split into four parts to reduce memory usage.
+ * If the image is greater than a certain limit, it is split into nStrips horizontal strips to reduce memory usage.
+ * If nThreads > 1, the strips are processed concurrently by separate octaves (at most one per thread), whose
+ * keypoints are merged in strip order: the result is the same as processing the strips one after another.
  */
-bool AlpOctave::processFirst(unsigned char * data, int width, int height, FeatureList & featurelist)
+bool AlpOctave::processFirst(unsigned char * data, int width, int height, FeatureList & featurelist, int nStrips, int nThreads)
 {
 	if (min(width, height) <= minSize)	// check minimum size
 		return false;
 
-	int next_size = ((width+1)/2) * ((height+1)/2);				// next octave size
-
-	if (height <= 4*overlapLines)	// decide if this image must be split
+	if ((nStrips <= 1) || (height <= nStrips*overlapLines))	// decide if this image must be split
 	{
-		allocate(width, height, false);		// false ==> not split
+		allocate(width, height, 1);		// 1 ==> not split
 		if (init(data, width, height))
 		{
 			detect();				// detect keypoints in this octave
@@ -223,60 +224,100 @@ bool AlpOctave::processFirst(unsigned char * data, int width, int height, Featur
 		else
 			return false;
 	}
-	else		// split the first octave image into 4 parts to reduce allocated memory
+	else		// split the first octave image into nStrips parts to reduce allocated memory
 	{
-		allocate(width, height, true);	// true ==> split
-
-		float * next_dst = nextG1;			// the first destination address is nextG1
-		bool skip_next_line = false;		// the first time do not skip the first line while subsampling
+		allocate(width, height, nStrips);
 
-		int splitImageLines = height/4;
-		int splitLines[4] = {splitImageLines, splitImageLines, splitImageLines, (height - 3*splitImageLines)};
+		bool success = true;
+		if (nThreads <= 1)
+		{
+			for (int sk = 0; (sk < nStrips) && success; ++sk)		// loop over the split image (on the first octave only)
+				success = processStrip(*this, data, width, height, nStrips, sk, featurelist.features);
+		}
+		else
+		{
+			std::vector< std::vector<Feature> > stripFeatures(nStrips);
+			std::vector<char> stripDone(nStrips, 0);
+			std::string errorMessage;						// exceptions cannot leave the parallel region
 
-		int splitHeight[4] = {
-				splitLines[0] + overlapLines,		// only bottom overlap
-				splitLines[1] + 2*overlapLines, 		// top and bottom overlap
-				splitLines[2] + 2*overlapLines, 		// top and bottom overlap
-				splitLines[3] + overlapLines};		// only top overlap
+			#pragma omp parallel num_threads(min(nThreads, nStrips)) default(shared)
+			{
+				AlpOctave worker;			// one octave per thread: memory grows with the threads, not with the strips
+				#pragma omp for schedule(dynamic, 1)
+				for (int sk = 0; sk < nStrips; ++sk)
+				{
+					try {
+						stripDone[sk] = processStrip(worker, data, width, height, nStrips, sk, stripFeatures[sk]);
+					}
+					catch (std::exception & ex) {
+						#pragma omp critical (alp_strip_error)
+						if (errorMessage.empty())
+							errorMessage = ex.what();
+					}
+				}
+			}
 
-		int startLine[4] = { 0, splitImageLines - overlapLines, 2*splitImageLines - overlapLines, 3*splitImageLines - overlapLines};
-		int extraTopLines[4] = {0, overlapLines, overlapLines, overlapLines};
-		int extraBottomLines[4] = {overlapLines, overlapLines, overlapLines, 0};
+			if (!errorMessage.empty())
+				throw CdvsException(errorMessage);
 
-		for (int sk = 0; sk < 4; ++sk)		// loop 4 times over the split image (on the first octave only)
-		{
-			if (init(data + width*startLine[sk], width, splitHeight[sk], extraTopLines[sk], extraBottomLines[sk]))		// input: the original image split into 4 parts
+			for (int sk = 0; (sk < nStrips) && success; ++sk)		// merge the keypoints in strip order
 			{
-				detect();						// detect keypoints in this part of the octave
-				getKeypoints(featurelist.features, true, true, startLine[sk]);
-
-				next_dst = subsampleImage(G3 + width * extraTopLines[sk], next_dst, width, splitLines[sk], skip_next_line);
-				if (splitLines[sk] & 1)
-					skip_next_line = !skip_next_line; 	// if odd, invert the skipping logic
+				success = (stripDone[sk] != 0);
+				if (success)
+					featurelist.features.insert(featurelist.features.end(), stripFeatures[sk].begin(), stripFeatures[sk].end());
 			}
-			else
-				return false;		// init() failed
 		}
 
+		if (!success)
+			return false;		// init() failed
+
 		this->width = width;		// restore the real width
 		this->height = height;		// restore the real height
-
 	}
 
 	return true;
 }
 
+/*
+ * Process one strip of the split first octave using the given worker octave (which can be this octave).
+ * Strip sk covers the lines [sk*height/nStrips, (sk+1)*height/nStrips) (the last one takes the remaining lines),
+ * plus overlapLines halo lines on each inner side; the subsampled strip is written into the rows of nextG1
+ * corresponding to the even lines of the full image, so the strips can be subsampled in any order.
+ */
+bool AlpOctave::processStrip(AlpOctave & worker, unsigned char * data, int width, int height, int nStrips, int sk, std::vector<Feature> & outKeypoints)
+{
+	int splitImageLines = height/nStrips;
+	int firstLine = sk * splitImageLines;
+	int splitLines = (sk < nStrips - 1) ? splitImageLines : (height - firstLine);
+	int extraTop = (sk > 0) ? overlapLines : 0;					// top overlap (except the first strip)
+	int extraBottom = (sk < nStrips - 1) ? overlapLines : 0;	// bottom overlap (except the last strip)
+	int startLine = firstLine - extraTop;
+
+	if (! worker.init(data + width*startLine, width, splitLines + extraTop + extraBottom, extraTop, extraBottom))	// input: the original image split into parts
+		return false;
+
+	worker.detect();						// detect keypoints in this part of the octave
+	worker.getKeypoints(outKeypoints, true, true, startLine);
+
+	float * dst = nextG1 + ((firstLine + 1)/2) * (width/2);		// the subsampled rows are the even lines of the full image
+	subsampleImage(worker.G3 + width * extraTop, dst, width, splitLines, (firstLine & 1) != 0);
+
+	return true;
+}
+
 /*
  * Process the next octave.
  * Returns true if successful, false if the resampled image is too small.
  */
-bool AlpOctave::processNext(FeatureList & featurelist)
+bool AlpOctave::processNext(FeatureList & featurelist, FeatureBudget * budget)
 {
 	if (init())
 	{
 		detect();				// detect keypoints in this octave
 		detectDuplicates(featurelist); // detect duplicates
-		getKeypoints(featurelist.features, true, true);
+		if (budget != NULL)
+			budget->commit(featurelist, octave - 1);	// the previous octave has no more duplicates
+		getKeypoints(featurelist.features, true, true, 0, budget);
 		subsampleImage(G3, nextG1, width, height);
 		return true;
 	}
@@ -298,7 +339,7 @@ bool AlpOctave::init(unsigned char * data, int width_par, int height_par, int ex
 	fast_mode = fast; 
 	int size = width_par * height_par;
 
-	allocate(width, height, false);		// allocate memory (if needed) 
+	allocate(width, height, 1);		// allocate memory (if needed) 
 	
 	// copy the source image
 
@@ -349,7 +390,7 @@ bool AlpOctave::init(const AlpOctave & previous)
 	fast_mode = previous.fast_mode; 
 
 	int size = width * height;
-	allocate(width, height, false);		// allocate memory (if needed)
+	allocate(width, height, 1);		// allocate memory (if needed)
 
 	// get data from previous G3 (subsampling)
 
@@ -398,14 +439,18 @@ bool AlpOctave::init()
 }
 
 
-void AlpOctave::allocate(int width, int height, bool split) 
+void AlpOctave::allocate(int width, int height, int nStrips) 
 {
-	// allocate buffers according to the split/not split parameter
+	gradientTiles.clear();		// a new image: any lazy gradient tile is stale
+
+	// allocate buffers according to the number of strips
 	int size = 0;
-	if (split)
+	if (nStrips > 1)
 	{
-		int splitImageLines = height/4;
-		size = width * (splitImageLines + 2*overlapLines);
+		int splitImageLines = height/nStrips;
+		int lastLines = height - (nStrips - 1)*splitImageLines;		// the last strip takes the remaining lines
+		size = width * max(splitImageLines + 2*overlapLines, lastLines + overlapLines);
+		size = max(size, (width/2) * (height/2));		// the next octaves are processed as a whole
 	}
 	else
 	{
@@ -418,33 +463,33 @@ void AlpOctave::allocate(int width, int height, bool split)
 
 		capacity = size;
 
-		G1 = new float [size];
-		G2 = new float [size];
-		G3 = new float [size];
-		G4 = new float [size];
-		tmp = new float [size];
+		G1 = newBuffer(size);
+		G2 = newBuffer(size);
+		G3 = newBuffer(size);
+		G4 = newBuffer(size);
+		tmp = newBuffer(size);
 
 		// prepare buffer to contain the next octave G1
 
 		int next_size = ((width+1)/2) * ((height+1)/2);
-		nextG1 = new float [next_size];
+		nextG1 = newBuffer(next_size);
 
 		// low memory implementation: allocate only 3 lines of the source image
 
-		L1 = new float [3*width];
-		L2 = new float [3*width];
-		L3 = new float [3*width];
-		L4 = new float [3*width];
+		L1 = newBuffer(3*width);
+		L2 = newBuffer(3*width);
+		L3 = newBuffer(3*width);
+		L4 = newBuffer(3*width);
 
-		A = new float [3*width];
-		B = new float [3*width];
-		C = new float [3*width];
-		D = new float [3*width];
+		A = newBuffer(3*width);
+		B = newBuffer(3*width);
+		C = newBuffer(3*width);
+		D = newBuffer(3*width);
 
-		minResponse = new float [3*width];
-		maxResponse = new float [3*width];
-		minScale = new float [3*width];
-		maxScale = new float [3*width];
+		minResponse = newBuffer(3*width);
+		maxResponse = newBuffer(3*width);
+		minScale = newBuffer(3*width);
+		maxScale = newBuffer(3*width);
 
 		// all gradient buffers reuse previously allocated buffers
 		// we keep G3 because it will be subsampled and used as next G1 in the next octave
@@ -458,7 +503,7 @@ void AlpOctave::allocate(int width, int height, bool split)
 		gradMod[1] = tmp;
 
 		if(fast_mode) // Added by ETRI : for faster gradient computation, Gaussian and gradient buffers should be available at the same time
-			gradMod[2] = new float[size];
+			gradMod[2] = newBuffer(size);
 		else
 			gradMod[2] = G2;			// once gradTheta[1] and gradMod[1] have been computed, we can reuse G2
 
@@ -480,45 +525,537 @@ void AlpOctave::clear ()
 	if (empty())
 			return;
 
-	if (G1 != NULL) delete[] G1;
-	if (G2 != NULL) delete[] G2;
-	if (G3 != NULL) delete[] G3;
-	if (G4 != NULL) delete[] G4;
-	if (nextG1 != NULL) delete[] nextG1;
-	if (L1 != NULL) delete[] L1;
-	if (L2 != NULL) delete[] L2;
-	if (L3 != NULL) delete[] L3;
-	if (L4 != NULL) delete[] L4;
-	if (A != NULL) delete[] A;
-	if (B != NULL) delete[] B;
-	if (C != NULL) delete[] C;
-	if (D != NULL) delete[] D;
-	if (tmp != NULL) delete[] tmp;
-	if (minResponse != NULL) delete[] minResponse;
-	if (maxResponse != NULL) delete[] maxResponse;
-	if (minScale != NULL) delete[] minScale;
-	if (maxScale != NULL) delete[] maxScale;
-
-	G1 = G2 = G3 = G4 = nextG1 = L1 = L2 = L3 = L4 = A = B = C = D = NULL;
-	minResponse = maxResponse = minScale = maxScale = NULL;
+	deleteBuffer(G1);
+	deleteBuffer(G2);
+	deleteBuffer(G3);
+	deleteBuffer(G4);
+	deleteBuffer(nextG1);
+	deleteBuffer(L1);
+	deleteBuffer(L2);
+	deleteBuffer(L3);
+	deleteBuffer(L4);
+	deleteBuffer(A);
+	deleteBuffer(B);
+	deleteBuffer(C);
+	deleteBuffer(D);
+	deleteBuffer(tmp);
+	deleteBuffer(minResponse);
+	deleteBuffer(maxResponse);
+	deleteBuffer(minScale);
+	deleteBuffer(maxScale);
 
 	// Added by ETRI : for faster gradient computation, gradient buffers are allocated
-	if(fast_mode && (gradMod[2]!=NULL)) delete[] gradMod[2]; 
+	if(fast_mode) deleteBuffer(gradMod[2]); 
 
 	// all four gradient buffers were shared
 	gradTheta[1]=gradTheta[2]=gradMod[1] = gradMod[2] = NULL;
+
+	deleteBuffer(lazyGradMod);
+	gradientTiles.clear();
 	
 	capacity = 0;
 }
 
+float * AlpOctave::newBuffer(size_t size)
+{
+	if (pool != NULL)
+		return pool->get(size);
+
+	return new float [size];
+}
+
+void AlpOctave::deleteBuffer(float * & buffer)
+{
+	if ((pool == NULL) && (buffer != NULL))
+		delete[] buffer;		// pool buffers are freed by the pool
+
+	buffer = NULL;
+}
+
+void AlpOctave::attach(AlpBufferPool & pool, size_t index)
+{
+	detach();
+	clear();		// free the heap buffers, if any
+
+	this->pool = &pool;
+	poolIndex = index;
+
+	// borrow the pool vectors: their content is dropped, their capacity is kept
+
+	keypoints.swap(pool.keypoints(index));
+	keypoints.clear();
+	gradientTiles.swap(pool.tiles(index));
+	gradientTiles.clear();
+}
+
+void AlpOctave::detach()
+{
+	if (pool == NULL)
+		return;
+
+	clear();		// forget the pool buffers
+
+	keypoints.swap(pool->keypoints(poolIndex));
+	gradientTiles.swap(pool->tiles(poolIndex));
+	keypoints.clear();
+
+	pool = NULL;
+}
+
+/*
+ * Separable Gaussian smoothing.
+ * Each output pixel is accumulated exactly as in vl_feat's alp_smooth (vertical taps first, then horizontal taps,
+ * from the first to the last tap, replicating the border pixels), so the result is bit-exact with the original code;
+ * the difference is that both passes work along the image rows, so no transposed copy of the image is needed.
+ */
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define ALP_OCTAVE_X86		// the AVX and AVX2 kernels are compiled with function-specific target attributes
+#endif
+
+#if defined(__SSE2__) || defined(ALP_OCTAVE_X86)
+	#include <immintrin.h>
+#endif
+
+/**
+ * Vertical pass on one row: out[x] = sum of rows[j][x] * kernel[j].
+ */
+static void smoothColumns_scalar(float * out, const float * const * rows, const float * kernel, int ntaps, int begin, int width)
+{
+	for (int x = begin; x < width; ++x)
+	{
+		float acc = 0;
+		for (int j = 0; j < ntaps; ++j)
+			acc += rows[j][x] * kernel[j];
+		out[x] = acc;
+	}
+}
+
+/**
+ * Horizontal pass on one row: out[x] = sum of in[x + j] * kernel[j], where in is padded with ntaps/2 pixels on both sides.
+ */
+static void smoothRow_scalar(float * out, const float * in, const float * kernel, int ntaps, int begin, int width)
+{
+	for (int x = begin; x < width; ++x)
+	{
+		float acc = 0;
+		for (int j = 0; j < ntaps; ++j)
+			acc += in[x + j] * kernel[j];
+		out[x] = acc;
+	}
+}
+
+#ifdef __SSE2__
+
+static void smoothColumns_sse(float * out, const float * const * rows, const float * kernel, int ntaps, int width)
+{
+	int x = 0;
+	for (; x + 8 <= width; x += 8)
+	{
+		__m128 acc0 = _mm_setzero_ps();
+		__m128 acc1 = _mm_setzero_ps();
+		for (int j = 0; j < ntaps; ++j)
+		{
+			const __m128 k = _mm_set1_ps(kernel[j]);
+			acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(rows[j] + x), k));
+			acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(rows[j] + x + 4), k));
+		}
+		_mm_storeu_ps(out + x, acc0);
+		_mm_storeu_ps(out + x + 4, acc1);
+	}
+	smoothColumns_scalar(out, rows, kernel, ntaps, x, width);
+}
+
+static void smoothRow_sse(float * out, const float * in, const float * kernel, int ntaps, int width)
+{
+	int x = 0;
+	for (; x + 8 <= width; x += 8)
+	{
+		__m128 acc0 = _mm_setzero_ps();
+		__m128 acc1 = _mm_setzero_ps();
+		for (int j = 0; j < ntaps; ++j)
+		{
+			const __m128 k = _mm_set1_ps(kernel[j]);
+			acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(in + x + j), k));
+			acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(in + x + j + 4), k));
+		}
+		_mm_storeu_ps(out + x, acc0);
+		_mm_storeu_ps(out + x + 4, acc1);
+	}
+	smoothRow_scalar(out, in, kernel, ntaps, x, width);
+}
+
+#else
+
+static void smoothColumns_sse(float * out, const float * const * rows, const float * kernel, int ntaps, int width)
+{
+	smoothColumns_scalar(out, rows, kernel, ntaps, 0, width);
+}
+
+static void smoothRow_sse(float * out, const float * in, const float * kernel, int ntaps, int width)
+{
+	smoothRow_scalar(out, in, kernel, ntaps, 0, width);
+}
+
+#endif
+
+#ifdef ALP_OCTAVE_X86
+
+// multiplications and additions are kept separate (no FMA) to give the same rounding as the SSE and scalar code
+
+__attribute__((target("avx")))
+static void smoothColumns_avx(float * out, const float * const * rows, const float * kernel, int ntaps, int width)
+{
+	int x = 0;
+	for (; x + 16 <= width; x += 16)
+	{
+		__m256 acc0 = _mm256_setzero_ps();
+		__m256 acc1 = _mm256_setzero_ps();
+		for (int j = 0; j < ntaps; ++j)
+		{
+			const __m256 k = _mm256_set1_ps(kernel[j]);
+			acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(rows[j] + x), k));
+			acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(rows[j] + x + 8), k));
+		}
+		_mm256_storeu_ps(out + x, acc0);
+		_mm256_storeu_ps(out + x + 8, acc1);
+	}
+	smoothColumns_scalar(out, rows, kernel, ntaps, x, width);
+}
+
+__attribute__((target("avx")))
+static void smoothRow_avx(float * out, const float * in, const float * kernel, int ntaps, int width)
+{
+	int x = 0;
+	for (; x + 16 <= width; x += 16)
+	{
+		__m256 acc0 = _mm256_setzero_ps();
+		__m256 acc1 = _mm256_setzero_ps();
+		for (int j = 0; j < ntaps; ++j)
+		{
+			const __m256 k = _mm256_set1_ps(kernel[j]);
+			acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(in + x + j), k));
+			acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(in + x + j + 8), k));
+		}
+		_mm256_storeu_ps(out + x, acc0);
+		_mm256_storeu_ps(out + x + 8, acc1);
+	}
+	smoothRow_scalar(out, in, kernel, ntaps, x, width);
+}
+
+#endif
+
+static int bestSupportedImplementation()
+{
+#ifdef ALP_OCTAVE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return AlpOctave::AVX2;
+	if (__builtin_cpu_supports("avx"))
+		return AlpOctave::AVX;
+#endif
+#ifdef __SSE2__
+	return AlpOctave::SSE2;
+#else
+	return AlpOctave::SCALAR;
+#endif
+}
+
+int AlpOctave::implementation = bestSupportedImplementation();
+
+int AlpOctave::getImplementation()
+{
+	return implementation;
+}
+
+int AlpOctave::setImplementation(int level)
+{
+	implementation = std::min(std::max(level, (int) SCALAR), bestSupportedImplementation());
+	return implementation;
+}
+
+static inline void smoothColumns(float * out, const float * const * rows, const float * kernel, int ntaps, int width)
+{
+	const int level = AlpOctave::getImplementation();
+#ifdef ALP_OCTAVE_X86
+	if (level >= AlpOctave::AVX)
+	{
+		smoothColumns_avx(out, rows, kernel, ntaps, width);
+		return;
+	}
+#endif
+	if (level >= AlpOctave::SSE2)
+		smoothColumns_sse(out, rows, kernel, ntaps, width);
+	else
+		smoothColumns_scalar(out, rows, kernel, ntaps, 0, width);
+}
+
+static inline void smoothRow(float * out, const float * in, const float * kernel, int ntaps, int width)
+{
+	const int level = AlpOctave::getImplementation();
+#ifdef ALP_OCTAVE_X86
+	if (level >= AlpOctave::AVX)
+	{
+		smoothRow_avx(out, in, kernel, ntaps, width);
+		return;
+	}
+#endif
+	if (level >= AlpOctave::SSE2)
+		smoothRow_sse(out, in, kernel, ntaps, width);
+	else
+		smoothRow_scalar(out, in, kernel, ntaps, 0, width);
+}
+
 void AlpOctave::conv2(const float * imagein, const Filter & filter, float * imageout) const
 {
-	// this operation needs a temporary image of size [width, height]
-	// filter must contain a 2D separable filter
-	// use vl_feat filtering function
+	// filter must contain a 2D separable filter; imagein and imageout may be the same buffer.
+	// The tmp buffer holds the last input rows (needed when filtering in place) and one vertically filtered row.
+
+	const int half = filter.ntaps / 2;
+	const bool inPlace = (imagein == imageout);
+	if ((long) (half + 1) * width + 2 * half > (long) width * height)
+	{
+		alp_smooth( imageout, tmp, imagein, width, height, filter.kernel, filter.ntaps);	// tmp is too small: use vl_feat
+		return;
+	}
+
+	float * history = tmp;								// input rows y-half .. y-1, at position (row % half)
+	float * padded = tmp + half * width;				// vertically filtered row y, with replicated borders
+	const float * rows[Filter::maxsize];
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int j = 0; j < filter.ntaps; ++j)
+		{
+			int r = min(max(y - half + j, 0), height - 1);
+			rows[j] = (inPlace && r < y) ? history + (r % half) * width : imagein + r * width;
+		}
+		smoothColumns(padded + half, rows, filter.kernel, filter.ntaps, width);
+
+		for (int x = 0; x < half; ++x)
+		{
+			padded[x] = padded[half];
+			padded[half + width + x] = padded[half + width - 1];
+		}
+
+		if (inPlace && half > 0)
+			memcpy(history + (y % half) * width, imagein + y * width, width * sizeof(float));
+
+		smoothRow(imageout + y * width, padded, filter.kernel, filter.ntaps, width);
+	}
+}
+
+/*
+ * Gradient module and orientation.
+ * The SIMD code computes the same operations as vl_feat's alp_update_gradient (vl_fast_sqrt_f, vl_fast_atan2_f and
+ * vl_mod_2pi_f), including their rounding, so the results are bit-exact; the branches of those functions become masks.
+ */
+
+static const float sqrtThreshold = nextafterf((float) 1e-8, 1.0f);	// x < 1e-8 (as double) if and only if x < sqrtThreshold
+
+static inline void gradientPixel(float gx, float gy, float * mod, float * theta)
+{
+	*mod = vl_fast_sqrt_f (gx*gx + gy*gy);
+	*theta = vl_mod_2pi_f (vl_fast_atan2_f (gy, gx) + 2*VL_PI);
+}
+
+/**
+ * Gradient of the pixels [begin, end) of one row; up and down are the rows used for the vertical derivative.
+ */
+static void gradientRow_scalar(float * mod, float * theta, const float * row, const float * up, const float * down, float yscale, int begin, int end)
+{
+	for (int x = begin; x < end; ++x)
+		gradientPixel(0.5f * (row[x + 1] - row[x - 1]), yscale * (down[x] - up[x]), mod + x, theta + x);
+}
+
+#ifdef __SSE2__
+
+static inline __m128 select_sse(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static void gradientRow_sse(float * mod, float * theta, const float * row, const float * up, const float * down, float yscale, int begin, int end)
+{
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 ys = _mm_set1_ps(yscale);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128d pi2 = _mm_set1_pd(2*VL_PI);
+	int x = begin;
+	for (; x + 4 <= end; x += 4)
+	{
+		__m128 gx = _mm_mul_ps(half, _mm_sub_ps(_mm_loadu_ps(row + x + 1), _mm_loadu_ps(row + x - 1)));
+		__m128 gy = _mm_mul_ps(ys, _mm_sub_ps(_mm_loadu_ps(down + x), _mm_loadu_ps(up + x)));
+
+		// module: x * resqrt(x) with the integer initial guess and two Newton steps
+		__m128 m = _mm_add_ps(_mm_mul_ps(gx, gx), _mm_mul_ps(gy, gy));
+		__m128 xhalf = _mm_mul_ps(half, m);
+		__m128 u = _mm_castsi128_ps(_mm_sub_epi32(_mm_set1_epi32(0x5f3759df), _mm_srli_epi32(_mm_castps_si128(m), 1)));
+		u = _mm_mul_ps(u, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(xhalf, u), u)));
+		u = _mm_mul_ps(u, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(xhalf, u), u)));
+		_mm_storeu_ps(mod + x, _mm_andnot_ps(_mm_cmplt_ps(m, _mm_set1_ps(sqrtThreshold)), _mm_mul_ps(m, u)));
+
+		// orientation
+		__m128 absy = _mm_add_ps(_mm_andnot_ps(signMask, gy), _mm_set1_ps(VL_EPSILON_F));
+		__m128 positive = _mm_cmpge_ps(gx, zero);
+		__m128 num = select_sse(positive, _mm_sub_ps(gx, absy), _mm_add_ps(gx, absy));
+		__m128 den = select_sse(positive, _mm_add_ps(gx, absy), _mm_sub_ps(absy, gx));
+		__m128 r = _mm_div_ps(num, den);
+		__m128 angle = select_sse(positive, _mm_set1_ps((float) VL_PI_1q), _mm_set1_ps((float) VL_PI_3q));
+		angle = _mm_add_ps(angle, _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.1821F), r), r), _mm_set1_ps(0.9675F)), r));
+		angle = _mm_xor_ps(angle, _mm_and_ps(_mm_cmplt_ps(gy, zero), signMask));
+
+		// the 2*pi offset is added in double precision, as in the scalar code
+		__m128 lo = _mm_cvtpd_ps(_mm_add_pd(_mm_cvtps_pd(angle), pi2));
+		__m128 hi = _mm_cvtpd_ps(_mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(angle, angle)), pi2));
+		__m128 t = _mm_movelh_ps(lo, hi);
+		const __m128 fpi2 = _mm_set1_ps((float) VL_PI2);
+		t = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, fpi2), fpi2));
+		_mm_storeu_ps(theta + x, t);
+	}
+	gradientRow_scalar(mod, theta, row, up, down, yscale, x, end);
+}
+
+#else
+
+static void gradientRow_sse(float * mod, float * theta, const float * row, const float * up, const float * down, float yscale, int begin, int end)
+{
+	gradientRow_scalar(mod, theta, row, up, down, yscale, begin, end);
+}
+
+#endif
+
+#ifdef ALP_OCTAVE_X86
+
+__attribute__((target("avx2")))
+static void gradientRow_avx2(float * mod, float * theta, const float * row, const float * up, const float * down, float yscale, int begin, int end)
+{
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 ys = _mm256_set1_ps(yscale);
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256d pi2 = _mm256_set1_pd(2*VL_PI);
+	int x = begin;
+	for (; x + 8 <= end; x += 8)
+	{
+		__m256 gx = _mm256_mul_ps(half, _mm256_sub_ps(_mm256_loadu_ps(row + x + 1), _mm256_loadu_ps(row + x - 1)));
+		__m256 gy = _mm256_mul_ps(ys, _mm256_sub_ps(_mm256_loadu_ps(down + x), _mm256_loadu_ps(up + x)));
+
+		// module: x * resqrt(x) with the integer initial guess and two Newton steps
+		__m256 m = _mm256_add_ps(_mm256_mul_ps(gx, gx), _mm256_mul_ps(gy, gy));
+		__m256 xhalf = _mm256_mul_ps(half, m);
+		__m256 u = _mm256_castsi256_ps(_mm256_sub_epi32(_mm256_set1_epi32(0x5f3759df), _mm256_srli_epi32(_mm256_castps_si256(m), 1)));
+		u = _mm256_mul_ps(u, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(_mm256_mul_ps(xhalf, u), u)));
+		u = _mm256_mul_ps(u, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(_mm256_mul_ps(xhalf, u), u)));
+		_mm256_storeu_ps(mod + x, _mm256_andnot_ps(_mm256_cmp_ps(m, _mm256_set1_ps(sqrtThreshold), _CMP_LT_OQ), _mm256_mul_ps(m, u)));
+
+		// orientation
+		__m256 absy = _mm256_add_ps(_mm256_andnot_ps(signMask, gy), _mm256_set1_ps(VL_EPSILON_F));
+		__m256 positive = _mm256_cmp_ps(gx, zero, _CMP_GE_OQ);
+		__m256 num = _mm256_blendv_ps(_mm256_add_ps(gx, absy), _mm256_sub_ps(gx, absy), positive);
+		__m256 den = _mm256_blendv_ps(_mm256_sub_ps(absy, gx), _mm256_add_ps(gx, absy), positive);
+		__m256 r = _mm256_div_ps(num, den);
+		__m256 angle = _mm256_blendv_ps(_mm256_set1_ps((float) VL_PI_3q), _mm256_set1_ps((float) VL_PI_1q), positive);
+		angle = _mm256_add_ps(angle, _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.1821F), r), r), _mm256_set1_ps(0.9675F)), r));
+		angle = _mm256_xor_ps(angle, _mm256_and_ps(_mm256_cmp_ps(gy, zero, _CMP_LT_OQ), signMask));
+
+		// the 2*pi offset is added in double precision, as in the scalar code
+		__m128 lo = _mm256_cvtpd_ps(_mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(angle)), pi2));
+		__m128 hi = _mm256_cvtpd_ps(_mm256_add_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(angle, 1)), pi2));
+		__m256 t = _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+		const __m256 fpi2 = _mm256_set1_ps((float) VL_PI2);
+		t = _mm256_sub_ps(t, _mm256_and_ps(_mm256_cmp_ps(t, fpi2, _CMP_GT_OQ), fpi2));
+		_mm256_storeu_ps(theta + x, t);
+	}
+	gradientRow_scalar(mod, theta, row, up, down, yscale, x, end);
+}
+
+#endif
+
+void AlpOctave::gradient(float * gradmod, float * gradtheta, const float * src, int w, int h)
+{
+	gradient(gradmod, gradtheta, src, w, h, 0, 0, w, h);
+}
 
-	alp_smooth( imageout, tmp, imagein, width, height, filter.kernel, filter.ntaps);
+void AlpOctave::gradient(float * gradmod, float * gradtheta, const float * src, int w, int h, int x0, int y0, int x1, int y1)
+{
+	// one-sided differences on the borders, central differences elsewhere (same as vl_feat alp_update_gradient)
 
+	const int begin = max(x0, 1);
+	const int end = min(x1, w - 1);
+	const int level = implementation;
+
+	for (int y = y0; y < y1; ++y)
+	{
+		const float * row = src + y * w;
+		const float * up = (y > 0) ? row - w : row;
+		const float * down = (y < h - 1) ? row + w : row;
+		const float yscale = (y > 0 && y < h - 1) ? 0.5f : 1.0f;
+		float * mod = gradmod + y * w;
+		float * theta = gradtheta + y * w;
+
+		if (x0 == 0)
+			gradientPixel(row[1] - row[0], yscale * (down[0] - up[0]), mod, theta);
+#ifdef ALP_OCTAVE_X86
+		if (level >= AVX2)
+			gradientRow_avx2(mod, theta, row, up, down, yscale, begin, end);
+		else
+#endif
+		if (level >= SSE2)
+			gradientRow_sse(mod, theta, row, up, down, yscale, begin, end);
+		else
+			gradientRow_scalar(mod, theta, row, up, down, yscale, begin, end);
+		if (x1 == w)
+			gradientPixel(row[w - 1] - row[w - 2], yscale * (down[w - 1] - up[w - 1]), mod + w - 1, theta + w - 1);
+	}
+}
+
+void AlpOctave::updateGradientTiles(int iscale, double x, double y, double sigma) const
+{
+	const float * srcGaussian[] = {G1, G2, G3, G4};
+
+	// support of the orientation histogram and of the descriptor (see alp_keypoint_orientations and alp_keypoint_descriptor)
+
+	int xi = (int) (x + 0.5);
+	int yi = (int) (y + 0.5);
+	int orientationRadius = max((int) floor(3.0 * magnification / 2.0 * sigma), 1);
+	int descriptorRadius = (int) floor(sqrt(2.0) * (magnification * sigma + VL_EPSILON_D) * 5 / 2.0 + 0.5);
+	int radius = max(orientationRadius, descriptorRadius);
+
+	int xmin = max(xi - radius, 0);
+	int xmax = min(xi + radius, width - 1);
+	int ymin = max(yi - radius, 0);
+	int ymax = min(yi + radius, height - 1);
+	if (xmin > xmax || ymin > ymax)
+		return;		// the keypoint is out of bounds
+
+	const int tilesX = (width + gradientTileSize - 1) / gradientTileSize;
+	const int tilesY = (height + gradientTileSize - 1) / gradientTileSize;
+	unsigned char * ready = &gradientTiles[(iscale - 1) * tilesX * tilesY];
+
+	for (int ty = ymin / gradientTileSize; ty <= ymax / gradientTileSize; ++ty)
+	{
+		int y0 = ty * gradientTileSize;
+		int y1 = min(y0 + gradientTileSize, height);
+		int tx = xmin / gradientTileSize;
+		int txEnd = xmax / gradientTileSize + 1;
+		while (tx < txEnd)
+		{
+			if (ready[ty * tilesX + tx])
+			{
+				++tx;
+				continue;
+			}
+
+			int first = tx;		// compute a run of missing tiles at once
+			while (tx < txEnd && !ready[ty * tilesX + tx])
+				ready[ty * tilesX + tx++] = 1;
+
+			gradient(gradMod[iscale], gradTheta[iscale], srcGaussian[iscale], width, height,
+					first * gradientTileSize, y0, min(tx * gradientTileSize, width), y1);
+		}
+	}
 }
 
 void AlpOctave::laplacian(const float * src, float sigma, float * dst, int w, int h)
@@ -617,6 +1154,13 @@ void AlpOctave::computeResponse(int startLineSrc, int startLineDst, int nLines)
  		D[k] = 8.643160f*L1[k] + -10.842436f*L2[k] + 2.120433f*L3[k] + 1.388641f*L4[k];
 	}
 
+	computeExtrema(startLineDst, nLines);
+}
+
+void AlpOctave::computeExtrema(int startLine, int nLines)
+{
+	int dest_offset  = startLine * width;
+
 	// Values at octave boundaries:
 	// L = a*octaveRange(1).^3 + b*octaveRange(1).^2 + c*octaveRange(1) + d;
 	// R = a*octaveRange(end).^3 + b*octaveRange(end).^2 + c*octaveRange(end) + d;
@@ -917,7 +1461,7 @@ bool AlpOctave::computeCurvRatioAndCoordinates(FeatureAlp & d) const
 	return true;	// save this point
 }
 
-void AlpOctave::getAlpKeypoints(std::vector<FeatureAlp> & outKeypoints, bool rescale)
+void AlpOctave::getAlpKeypoints(std::vector<FeatureAlp> & outKeypoints, bool rescale, bool lazyGradients)
 {
 	int size = width * height;
 
@@ -935,12 +1479,31 @@ void AlpOctave::getAlpKeypoints(std::vector<FeatureAlp> & outKeypoints, bool res
 	if (needGradient[0] || needGradient[3])		// check if assumption on gradients has been violated
 		throw CdvsException("Basic assumption on gradients has been violated");
 
-	for (int scale = 1; scale <= 2; ++scale)
+	if (lazyGradients)
 	{
-		if (needGradient[scale])
+		// gradients will be computed by computeDescriptor() only where needed:
+		// G2 must survive, so the module of scale 2 needs its own buffer
+
+		if (gradMod[2] == G2)
 		{
-			// call vl_feat update_gradient()
-			alp_update_gradient (gradMod[scale], gradTheta[scale], srcGaussian[scale], width, height);
+			if (lazyGradMod == NULL)
+				lazyGradMod = newBuffer(capacity);
+			gradMod[2] = lazyGradMod;
+		}
+
+		int ntiles = ((width + gradientTileSize - 1) / gradientTileSize) * ((height + gradientTileSize - 1) / gradientTileSize);
+		gradientTiles.assign(2 * ntiles, 0);
+	}
+	else
+	{
+		gradientTiles.clear();
+
+		for (int scale = 1; scale <= 2; ++scale)
+		{
+			if (needGradient[scale])
+			{
+				gradient(gradMod[scale], gradTheta[scale], srcGaussian[scale], width, height);
+			}
 		}
 	}
 
@@ -964,7 +1527,7 @@ void AlpOctave::getAlpKeypoints(std::vector<FeatureAlp> & outKeypoints, bool res
 
 }
 
-void AlpOctave::getKeypoints(std::vector<Feature> & outKeypoints, bool calcDescriptor, bool rescale, int base_Y)
+void AlpOctave::getKeypoints(std::vector<Feature> & outKeypoints, bool calcDescriptor, bool rescale, int base_Y, FeatureBudget * budget)
 {
 	int size = width * height;
 
@@ -986,8 +1549,7 @@ void AlpOctave::getKeypoints(std::vector<Feature> & outKeypoints, bool calcDescr
 	{
 		if (needGradient[scale])
 		{
-			// call vl_feat update_gradient()
-			alp_update_gradient (gradMod[scale], gradTheta[scale], srcGaussian[scale], width, height);
+			gradient(gradMod[scale], gradTheta[scale], srcGaussian[scale], width, height);
 		}
 	}
 
@@ -1002,8 +1564,8 @@ void AlpOctave::getKeypoints(std::vector<Feature> & outKeypoints, bool calcDescr
 
 		// call alp_keypoint_orientations in vl_feat library
 		angles[i] = new double[4];
-		nangles[i] = alp_keypoint_orientations (angles[i], width, height, d->sigma,
-					d->x, d->y, gradMod[d->iscale], gradTheta[d->iscale], magnification);
+		nangles[i] = (d->spatialIndex != -1) ? alp_keypoint_orientations (angles[i], width, height, d->sigma,
+					d->x, d->y, gradMod[d->iscale], gradTheta[d->iscale], magnification) : 0;		// skip duplicates
 	}
 
 	for(int i=0; i<keypoints.size(); ++i)
@@ -1032,10 +1594,17 @@ void AlpOctave::getKeypoints(std::vector<Feature> & outKeypoints, bool calcDescr
 				e.scale = rescaler * d->sigma;		// in CDVS scale contains sigma with no sqrt factor
 			}
 
-			for (int q = 0; q < nangles[i] ; ++q)
+			// a keypoint that cannot be selected is returned once, without descriptor, only to detect the duplicates
+
+			bool describe = (budget == NULL) || budget->accept(e, base_Y);
+			int n = describe ? nangles[i] : min(nangles[i], 1);
+			if (!describe)
+				e.spatialIndex = FeatureBudget::notDescribed;
+
+			for (int q = 0; q < n ; ++q)
 			{
 				e.orientation = angles[i][q];				// set orientation
-				if (calcDescriptor)
+				if (calcDescriptor && describe)
 					computeDescriptor(e, rescale);			// compute SIFT descriptor --> either here or in ImageBuffer.extract()
 
 				outKeypoints.push_back(e);
@@ -1139,6 +1708,9 @@ void AlpOctave::computeDescriptor(Feature & keypoint, bool rescale) const
 		sigma /= rescaler;
 	}
 
+	if (!gradientTiles.empty())
+		updateGradientTiles(keypoint.iscale, x, y, sigma);	// lazy gradients: compute the missing gradients around this keypoint
+
   // call alp_keypoint_descriptor in vl_feat library
   alp_keypoint_descriptor(descr, x, y, sigma, angle0, width, height,  gradMod[keypoint.iscale],  gradTheta[keypoint.iscale], magnification);
 
@@ -1157,21 +1729,31 @@ void AlpOctave::computeDescriptor(Feature & keypoint, bool rescale) const
  */
 void AlpOctave::computeDescriptor(FeatureList & featurelist, const FeatureAlp & in, bool rescale, size_t missing) const
 {
-	Feature out;
-	out.x = in.x;				  // the X coordinate of the ALP keypoint
-	out.y = in.y;	  			  // the Y coordinate of the ALP keypoint
-	out.scale = in.sigma;		  // the sigma of the Gaussian filter used to detect this point
-	out.peak = in.peak;		  // the peak of the ALP keypoint
-	out.curvRatio = in.curvRatio;		  // the ratio of the curvatures
-	out.curvSigma = in.curvSigma;		  // the curvature at sigma
-	out.pdf = in.pdf;				  // probability of this point to be matched
-	out.octave = in.octave;				// octave of this feature
-	out.iscale = in.iscale;				// int scale
+	prepareGradients(in, rescale);
 
-	double x = in.x;
-	double y = in.y;
-	double sigma = in.sigma;
-	float * descr = out.descr;
+	// compute orientation of each keypoint (up to four orientations are possible)
+	double angles[4];
+	int nangles = computeOrientations(in, rescale, angles);
+
+	if (nangles > missing)			// check if we are going to produce more keypoints than required:
+		nangles = (int) missing;	// in this case reduce the number of keypoints accordingly
+
+	// compute a descriptor for each orientation
+	for (int k = 0; k < nangles; ++k)
+	{
+		featurelist.features.push_back(Feature());
+		computeDescriptor(featurelist.features.back(), in, rescale, angles[k]);	// store output keypoint into featurelist
+	}
+}
+
+/*
+ * Get the coordinates and sigma of an ALP keypoint in its own octave.
+ */
+static inline void octaveCoordinates(const FeatureAlp & in, bool rescale, double & x, double & y, double & sigma)
+{
+	x = in.x;
+	y = in.y;
+	sigma = in.sigma;
 
 	if ((rescale) && (in.octave > 0))
 	{
@@ -1180,30 +1762,51 @@ void AlpOctave::computeDescriptor(FeatureList & featurelist, const FeatureAlp &
 		y /= rescaler;
 		sigma /= rescaler;
 	}
+}
 
-	// compute orientation of each keypoint (up to four orientations are possible)
-	double angles[4];
-	int nangles = alp_keypoint_orientations (angles, width, height, sigma, x, y, gradMod[in.iscale], gradTheta[in.iscale], magnification);
+void AlpOctave::prepareGradients(const FeatureAlp & in, bool rescale) const
+{
+	if (!gradientTiles.empty())
+	{
+		double x, y, sigma;
+		octaveCoordinates(in, rescale, x, y, sigma);
+		updateGradientTiles(in.iscale, x, y, sigma);		// lazy gradients: compute the missing gradients around this keypoint
+	}
+}
 
-	if (nangles > missing)			// check if we are going to produce more keypoints than required:
-		nangles = (int) missing;	// in this case reduce the number of keypoints accordingly
+int AlpOctave::computeOrientations(const FeatureAlp & in, bool rescale, double angles[4]) const
+{
+	double x, y, sigma;
+	octaveCoordinates(in, rescale, x, y, sigma);
 
-	// compute a descriptor for each orientation
-	for (int k = 0; k < nangles; ++k)
-	{
-		out.orientation = angles[k];	// save orientation
+	return alp_keypoint_orientations (angles, width, height, sigma, x, y, gradMod[in.iscale], gradTheta[in.iscale], magnification);
+}
+
+void AlpOctave::computeDescriptor(Feature & out, const FeatureAlp & in, bool rescale, double angle) const
+{
+	out.x = in.x;				  // the X coordinate of the ALP keypoint
+	out.y = in.y;	  			  // the Y coordinate of the ALP keypoint
+	out.scale = in.sigma;		  // the sigma of the Gaussian filter used to detect this point
+	out.peak = in.peak;		  // the peak of the ALP keypoint
+	out.curvRatio = in.curvRatio;		  // the ratio of the curvatures
+	out.curvSigma = in.curvSigma;		  // the curvature at sigma
+	out.pdf = in.pdf;				  // probability of this point to be matched
+	out.octave = in.octave;				// octave of this feature
+	out.iscale = in.iscale;				// int scale
+	out.orientation = angle;			// save orientation
 
-		// call alp_keypoint_descriptor in vl_feat library
-		alp_keypoint_descriptor(descr, x, y, sigma, angles[k], width, height,  gradMod[in.iscale],  gradTheta[in.iscale], magnification);
+	double x, y, sigma;
+	octaveCoordinates(in, rescale, x, y, sigma);
+	float * descr = out.descr;
 
-		// export data
-		for (int k = 0 ; k < 128 ; ++k)
-		{
-			float exportval = 512.0f * descr[k];
-			descr[k] = (unsigned int) ((exportval < 255.0f) ? exportval : 255.0f);
-		}
+	// call alp_keypoint_descriptor in vl_feat library
+	alp_keypoint_descriptor(descr, x, y, sigma, angle, width, height,  gradMod[in.iscale],  gradTheta[in.iscale], magnification);
 
-		featurelist.features.push_back(out);		// store output keypoint into featurelist
+	// export data
+	for (int k = 0 ; k < 128 ; ++k)
+	{
+		float exportval = 512.0f * descr[k];
+		descr[k] = (unsigned int) ((exportval < 255.0f) ? exportval : 255.0f);
 	}
 }
 
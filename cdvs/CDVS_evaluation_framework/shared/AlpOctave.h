@@ -33,6 +33,8 @@
 #pragma once
 #include "FeatureList.h"
 #include "Parameters.h"
+#include "AlpBufferPool.h"
+#include "FeatureBudget.h"
 #include <ostream>
 
 namespace mpeg7cdvs
@@ -110,7 +112,7 @@ public:
  */
 class AlpOctave
 {
-private:
+protected:
 	bool fast_mode;// // boolean parameter indicating whether partial gradient will be used or not (Added by ETRI)
 	static const int minSize = 20;					// minimum size of the octave
 	static const int nsigmas = 4;					// number of different filtered images
@@ -138,21 +140,29 @@ private:
 	static const float maxDisplacement;			// maximum displacement of the x and y coordinate
 	static const float qcoeff[4][54];				// coefficients of the qcoeff matrix for all sigmas
 	static const int   overlapLines;				// how many overlap lines are needed when splitting the source image into blocks
+	static int implementation;					// kernels used by conv2() and gradient()
 
 	AlpOctave (const AlpOctave&);					// disallow copy
 	AlpOctave & operator= (const AlpOctave&);		// disallow assignment
 
 	void conv2(const float * imagein, const Filter & filter, float * imageout) const;	 // same as MATLAB conv2 function
+	static void gradient(float * gradmod, float * gradtheta, const float * src, int w, int h);	// compute gradient module and orientation
+	static void gradient(float * gradmod, float * gradtheta, const float * src, int w, int h, int x0, int y0, int x1, int y1);	// same, only in [x0,x1) x [y0,y1)
+	void updateGradientTiles(int iscale, double x, double y, double sigma) const;	// compute the missing gradient tiles around a keypoint
 	static void laplacian(const float * imagein, float sigma, float * imageout, int w, int h);		// compute the Laplacian on an image
 	static void print(const Feature & f, float ratio);
 	bool isMax(int k, float * R) const;
 	bool isMin(int k, float * R) const;
 	static int getClosestIndex(float scale);
 	bool computeCurvRatioAndCoordinates(FeatureAlp & d) const;
-	void allocate(int width, int height, bool split); 
-	void computeResponse(int startLineSrc, int startLineDst, int nLines);
+	void allocate(int width, int height, int nStrips); 		// nStrips > 1: the first octave is processed in strips
+	float * newBuffer(size_t size);		// allocate a buffer from the pool (if attached) or from the heap
+	void deleteBuffer(float * & buffer);	// free a buffer allocated by newBuffer() and set it to NULL
+	virtual void computeResponse(int startLineSrc, int startLineDst, int nLines);	// compute the polynomial coefficients and the extrema of nLines lines
+	void computeExtrema(int startLine, int nLines);		// compute the extrema of the response from L1, L4 and the coefficients A, B, C, D
 	void shiftUp();
 	static bool isDuplicate(const Feature & a);		// is the keypoint marked as duplicate?
+	bool processStrip(AlpOctave & worker, unsigned char * data, int width, int height, int nStrips, int sk, std::vector<Feature> & outKeypoints);	// process strip sk of the first octave
 
 	// member variables
 
@@ -190,6 +200,13 @@ private:
 	float * gradTheta[4];	// will contain 4 pointers to gradients angle
 	float * gradMod[4];		// will contain 4 pointers to gradients module
 
+	static const int gradientTileSize = 32;			// side of the square tiles of the lazy gradient computation
+	mutable std::vector<unsigned char> gradientTiles;	// lazy gradients: flags of the computed tiles of scale 1 and 2 (empty if all gradients are computed)
+	float * lazyGradMod;	// lazy gradients: module of scale 2 (G2 must be kept to compute the gradients of scale 1 on demand)
+
+	AlpBufferPool * pool;	// the pool owning the buffers (NULL if they are allocated on the heap)
+	size_t poolIndex;		// the index of the keypoint vectors borrowed from the pool
+
 	// std::vector<FeatureAlp> keypoints;					///< raw key points detected in this octave (without orientation)
 
 	/**
@@ -212,6 +229,31 @@ private:
 	
 public:
 
+	/**
+	 * Implementations of the smoothing (conv2) and gradient kernels; all of them give bit-exact results.
+	 * AlpOctaveFixed selects its fixed-point kernels with the same level (SSE2 kernels at the AVX level).
+	 */
+	enum {
+		SCALAR = 0,		///< plain C++ loops
+		SSE2 = 1,		///< SSE2 smoothing and gradient
+		AVX = 2,		///< AVX smoothing, SSE2 gradient
+		AVX2 = 3		///< AVX smoothing, AVX2 gradient
+	};
+
+	/**
+	 * Get the implementation of the smoothing and gradient kernels (the best one supported by the CPU, unless forced).
+	 * @return SCALAR, SSE2, AVX or AVX2
+	 */
+	static int getImplementation();
+
+	/**
+	 * Force the implementation of the smoothing and gradient kernels (e.g. for testing or benchmarking).
+	 * If the CPU does not support the required implementation, the best supported one is used.
+	 * @param level SCALAR, SSE2, AVX or AVX2
+	 * @return the implementation actually selected
+	 */
+	static int setImplementation(int level);
+
 	AlpOctave();					///< constructor
 
 	virtual ~AlpOctave();					///< destructor
@@ -242,6 +284,19 @@ public:
 
 	void clear ();						///< clear the AlpOctave
 
+	/**
+	 * Take all buffers from the given pool instead of the heap, until detach() is called.
+	 * The keypoint vectors are swapped with the pool vectors at the given index, so their capacity is reused too.
+	 * @param pool the pool; it must stay acquired until detach()
+	 * @param index the index of the pool vectors used by this octave
+	 */
+	void attach(AlpBufferPool & pool, size_t index);
+
+	/**
+	 * Give back the pool buffers and vectors; the octave is cleared.
+	 */
+	void detach();
+
 	/**
 	 * Detect all ALP keypoints from this octave.
 	 * @throws CdvsException in case of error
@@ -267,8 +322,9 @@ public:
 	 * This must be done after init(), detect() and detectDuplicates() because it reuses the same memory buffers.
 	 * @param outKeypoints the output vector of keypoints
 	 * @param rescale rescale the keypoints to their absolute value
+	 * @param lazyGradients if true, computeDescriptor() computes the gradients only around the described keypoints (in tiles shared by neighbouring keypoints)
 	 */
-	void getAlpKeypoints(std::vector<FeatureAlp> & outKeypoints, bool rescale = true);
+	void getAlpKeypoints(std::vector<FeatureAlp> & outKeypoints, bool rescale = true, bool lazyGradients = false);
 
 
 	/**
@@ -278,8 +334,9 @@ public:
 	 * @param calcDescriptor optionally compute the descriptor of each keypoint
 	 * @param rescale rescale the keypoints to their absolute value
 	 * @param base_Y displace all Y coordinates using the given base Y
+	 * @param budget if not NULL, the descriptors are computed only for the keypoints accepted by the budget (see FeatureBudget)
 	 */
-	void getKeypoints(std::vector<Feature> & outKeypoints, bool calcDescriptor = false, bool rescale = true, int base_Y = 0); 
+	void getKeypoints(std::vector<Feature> & outKeypoints, bool calcDescriptor = false, bool rescale = true, int base_Y = 0, FeatureBudget * budget = NULL);
 
 	/**
 	 * Get the final keypoints (fast mode). This function was added by ETRI.
@@ -310,6 +367,33 @@ public:
 	 */
 	void computeDescriptor(FeatureList & featurelist, const FeatureAlp & keypoint, bool rescale, size_t missing) const;
 
+	/**
+	 * Compute the gradients needed to describe the given ALP keypoint, if they are computed lazily (see getAlpKeypoints()).
+	 * This must be called before computeOrientations() and computeDescriptor(Feature &, const FeatureAlp &, bool, double);
+	 * unlike those methods, it must not be called concurrently on the same octave.
+	 * @param keypoint the input ALP keypoint instance
+	 * @param rescale if true, the keypoint x and y coordinates are scaled to match the octave of the keypoint
+	 */
+	void prepareGradients(const FeatureAlp & keypoint, bool rescale) const;
+
+	/**
+	 * Compute the orientations of the given ALP keypoint.
+	 * @param keypoint the input ALP keypoint instance
+	 * @param rescale if true, the keypoint x and y coordinates are scaled to match the octave of the keypoint
+	 * @param angles the output orientations
+	 * @return the number of orientations (from 0 to 4)
+	 */
+	int computeOrientations(const FeatureAlp & keypoint, bool rescale, double angles[4]) const;
+
+	/**
+	 * Compute the descriptor of the given ALP keypoint for one of its orientations.
+	 * @param out the output keypoint
+	 * @param keypoint the input ALP keypoint instance
+	 * @param rescale if true, the keypoint x and y coordinates are scaled to match the octave of the keypoint
+	 * @param angle the orientation, as returned by computeOrientations()
+	 */
+	void computeDescriptor(Feature & out, const FeatureAlp & keypoint, bool rescale, double angle) const;
+
 	/**
 	 * This function was added by ETRI which is fast mode of computeDescriptor
 	 * Partial gradient computation was adopted in this function
@@ -325,17 +409,20 @@ public:
 	 * @param width the image width
 	 * @param height the image height
 	 * @param featurelist the output list of features
+	 * @param nStrips the number of horizontal strips of a large image
+	 * @param nThreads max number of threads used to process the strips concurrently (1 = one strip after another)
 	 * @return true if successful
 	 */
-	bool processFirst(unsigned char * data, int width, int height, FeatureList & featurelist);
+	bool processFirst(unsigned char * data, int width, int height, FeatureList & featurelist, int nStrips = 4, int nThreads = 1);
 
 	/**
 	 * Process the next octave (low memory version).
 	 * This implementation extract all keypoints before applying the feature selection.
 	 * @param featurelist the output list of features
+	 * @param budget if not NULL, the keypoint budget of the image (see FeatureBudget)
 	 * @return true if successful, false if the next octave is too small.
 	 */
-	bool processNext(FeatureList & featurelist);
+	bool processNext(FeatureList & featurelist, FeatureBudget * budget = NULL);
 
 	/**
 	 * Export the height value (read only)
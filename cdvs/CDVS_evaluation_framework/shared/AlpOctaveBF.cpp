@@ -41,6 +41,7 @@
 #include <iomanip>
 #include <algorithm>
 #include "CdvsException.h"
+#include "ThreadLocal.h"
 #include "vl/sift.h"		// vl_feat library
 
 using namespace std;
@@ -121,7 +122,7 @@ const float AlpOctaveBF::qcoeff[4][54] =	{
 
 #define log2(x) (log(x)/LOG_OF_2)
 
-FrequencyFilter::FrequencyFilter()
+FrequencyFilter::FrequencyFilter():fft(),ownBuffers(false),inmat(NULL),fblock(NULL),fblock_flog(NULL)
 {
 	Init();
 }
@@ -401,20 +402,44 @@ const filter_type FrequencyFilter::g_fgaussian_data0[1446] = {
 	const float FrequencyFilter::fft_scale_factor = 1.0 / (FBLOCK_WIDTH * FBLOCK_WIDTH);
 	const int FrequencyFilter::total_memory = sizeof(float) * imageSize + sizeof(fftwf_complex) * fblock_size + sizeof(fftwf_complex) * fblock_size;
 
+	std::string FrequencyFilter::wisdom_file;
+	FrequencyFilter::plans FrequencyFilter::shared_plans = {NULL, NULL};
+
 	// methods
 
-void FrequencyFilter::open_lib()
+void FrequencyFilter::open_lib(const char * wisdom)
 {
 	// there's no fftwf_init();
 #if defined(_OPENMP)
 	fftwf_init_threads();
 #endif
+	if (wisdom != NULL)
+	{
+		#pragma omp critical (fftw)
+		{
+			wisdom_file = wisdom;
+			fftwf_import_wisdom_from_filename(wisdom);		// a missing file is not an error: the wisdom is saved at the end
+		}
+	}
 }
 
 void FrequencyFilter::close_lib()
 {
+	#pragma omp critical (fftw)
+	{
+		if (! wisdom_file.empty())
+			fftwf_export_wisdom_to_filename(wisdom_file.c_str());
+
+		// the plans must be destroyed before the cleanup, which makes them undefined
+		if (shared_plans.fftplan != NULL)
+			fftwf_destroy_plan(shared_plans.fftplan);
+		if (shared_plans.ifftplan != NULL)
+			fftwf_destroy_plan(shared_plans.ifftplan);
+		shared_plans.fftplan = shared_plans.ifftplan = NULL;
+	}
+
 #if defined(_OPENMP)
-	fftwf_cleanup_threads();
+	fftwf_cleanup_threads();		// includes fftwf_cleanup()
 #else
 	fftwf_cleanup();
 #endif
@@ -504,36 +529,132 @@ void FrequencyFilter::Convolution(int o_cur, int type, int loc)
 	res.mask = res.mask + res.mask_pos[0];
 
 	complex_mutil(fblock, res, fblock_flog, fblock_size, FHWIDTH, fft_scale_factor);
-	fftwf_execute(ifftplan);
+	fftwf_execute_dft_c2r(fft.ifftplan, fblock_flog, inmat);		// the shared plan on the buffers of this filter
+}
+
+void FrequencyFilter::Forward()
+{
+	fftwf_execute_dft_r2c(fft.fftplan, inmat, fblock);		// the shared plan on the buffers of this filter
+}
+
+/*
+ * The block size is fixed, so the plans are created once and then executed concurrently on the buffers of each thread
+ * with the new-array execute functions, which are thread safe. The buffers are allocated by fftwf_malloc (which is
+ * thread safe), so they have the alignment of the planning buffers. Planning, wisdom and the destruction of the plans
+ * are serialized by the fftw critical section; close_lib() destroys the plans.
+ */
+bool FrequencyFilter::CreatePlans()
+{
+	unsigned flags = wisdom_file.empty() ? FFTW_ESTIMATE : FFTW_MEASURE;
+
+	float * in = (float*) fftwf_malloc (sizeof(float) * imageSize);
+	fftwf_complex * out = (fftwf_complex*) fftwf_malloc (sizeof(fftwf_complex) * fblock_size);
+
+	shared_plans.fftplan = fftwf_plan_dft_r2c_2d(FBLOCK_WIDTH, FBLOCK_WIDTH, in, out, flags);
+	shared_plans.ifftplan = fftwf_plan_dft_c2r_2d(FBLOCK_WIDTH, FBLOCK_WIDTH, out, in, flags);		// may overwrite its input, as fblock_flog
+
+	fftwf_free(out);
+	fftwf_free(in);
+
+	if ((shared_plans.fftplan != NULL) && (shared_plans.ifftplan != NULL))
+		return true;
+
+	if (shared_plans.fftplan != NULL)
+		fftwf_destroy_plan(shared_plans.fftplan);
+	if (shared_plans.ifftplan != NULL)
+		fftwf_destroy_plan(shared_plans.ifftplan);
+	shared_plans.fftplan = shared_plans.ifftplan = NULL;
+	return false;
 }
 
 void FrequencyFilter::Init()
 {
-	#pragma omp critical
+	bool planned = true;
+
+	#pragma omp critical (fftw)
 	{
-		inmat = (float*) fftwf_malloc (sizeof(float) * imageSize) ;
-#ifndef SPACIAL_FILTERING
-		fblock     = (fftwf_complex*) fftwf_malloc (sizeof(fftwf_complex) * fblock_size) ;
-		fblock_flog = (fftwf_complex*) fftwf_malloc (sizeof(fftwf_complex) * fblock_size) ;
+		if (shared_plans.fftplan == NULL)
+			planned = CreatePlans();
+		fft = shared_plans;
+	}
 
-		fftplan = fftwf_plan_dft_r2c_2d(FBLOCK_WIDTH, FBLOCK_WIDTH, inmat, fblock, FFTW_ESTIMATE);
-		ifftplan = fftwf_plan_dft_c2r_2d(FBLOCK_WIDTH, FBLOCK_WIDTH, fblock_flog, inmat, FFTW_ESTIMATE);
-#endif
+	if (! planned)
+		throw CdvsException("FrequencyFilter: cannot create the FFTW plans");
+}
+
+namespace {
+
+/*
+ * The FFT buffers of a thread, freed when the thread ends.
+ */
+class FrequencyBuffers
+{
+public:
+	float * inmat;
+	fftwf_complex * fblock;
+	fftwf_complex * fblock_flog;
+	bool busy;						// true if a filter is using the buffers
+
+	FrequencyBuffers():busy(false)
+	{
+		inmat = (float*) fftwf_malloc (sizeof(float) * FBLOCK_WIDTH * FBLOCK_WIDTH);
+		fblock = (fftwf_complex*) fftwf_malloc (sizeof(fftwf_complex) * FBLOCK_WIDTH * FHWIDTH);
+		fblock_flog = (fftwf_complex*) fftwf_malloc (sizeof(fftwf_complex) * FBLOCK_WIDTH * FHWIDTH);
+	}
+
+	~FrequencyBuffers()
+	{
+		fftwf_free(fblock_flog);
+		fftwf_free(fblock);
+		fftwf_free(inmat);
+	}
+};
+
+ThreadLocal<FrequencyBuffers> threadBuffers;
+
+}	// end of anonymous namespace
+
+void FrequencyFilter::Acquire()
+{
+	if (inmat != NULL)
+		return;
+
+	FrequencyBuffers & buffers = threadBuffers.get();
+	if (buffers.busy)
+	{
+		// another filter of this thread holds the buffers
+		inmat = (float*) fftwf_malloc (sizeof(float) * imageSize);
+		fblock = (fftwf_complex*) fftwf_malloc (sizeof(fftwf_complex) * fblock_size);
+		fblock_flog = (fftwf_complex*) fftwf_malloc (sizeof(fftwf_complex) * fblock_size);
+		ownBuffers = true;
+	}
+	else
+	{
+		buffers.busy = true;
+		inmat = buffers.inmat;
+		fblock = buffers.fblock;
+		fblock_flog = buffers.fblock_flog;
+		ownBuffers = false;
 	}
 }
 
 void FrequencyFilter::Release()
 {
-	#pragma omp critical
+	if (inmat == NULL)
+		return;
+
+	if (ownBuffers)
 	{
-		if (inmat) fftwf_free (inmat);
-#ifndef SPACIAL_FILTERING
-		if (fblock) fftwf_free(fblock);
-		if (fblock_flog) fftwf_free(fblock_flog);
-		if (fftplan) fftwf_destroy_plan(fftplan);
-		if (ifftplan) fftwf_destroy_plan(ifftplan);
-#endif
+		fftwf_free(fblock_flog);
+		fftwf_free(fblock);
+		fftwf_free(inmat);
 	}
+	else
+		threadBuffers.get().busy = false;
+
+	inmat = NULL;
+	fblock = fblock_flog = NULL;
+	ownBuffers = false;
 }
 
 
@@ -1151,7 +1272,7 @@ void AlpOctaveBF::FrequencyFiltering()
 	//First layer
 	if(octave == 0)
 	{
-		fftwf_execute(filters->fftplan);	//forward FFT transform
+		filters->Forward();			//forward FFT transform
 		filters->Convolution(octave, FILTER_LOG, 0);
 
 		pLoG = L1;
@@ -1187,7 +1308,7 @@ void AlpOctaveBF::FrequencyFiltering()
 			pLoG += extrema_w;
 			pdata += FBLOCK_WIDTH;
 		}//*/
-		fftwf_execute(filters->fftplan);	//forward FFT transform
+		filters->Forward();			//forward FFT transform
 	}
 	////////////////////////////////////////////////////////////////////////// 
 	//Second and third layer
@@ -37,6 +37,7 @@
 #include "AlpOctave.h"
 #include "fftw3.h"
 #include <cstring>
+#include <string>
 
 namespace mpeg7cdvs
 {
@@ -127,8 +128,20 @@ private:
 
 	static void complex_mutil(fftwf_complex *srcA, const node srcB, fftwf_complex *dest,size_t size, int fwidth, float factor);
 
+	typedef struct _plans
+	{
+		fftwf_plan fftplan;				//forward FFT of a FBLOCK_WIDTH x FBLOCK_WIDTH block
+		fftwf_plan ifftplan;			//inverse FFT of a FBLOCK_WIDTH x FBLOCK_WIDTH block
+	} plans;
+
+	static plans shared_plans;			// process-wide plans, created by the first Init() and destroyed by close_lib()
+	static bool CreatePlans();			// plan the forward and inverse FFT of a block into shared_plans
+	static std::string wisdom_file;		// FFTW wisdom file set by open_lib() (empty if none)
+
+	plans fft;							// copy of the shared plans taken by Init(), so that no lock is needed to execute them
+	bool ownBuffers;					// true if the buffers were allocated by Acquire() instead of taken from the thread
+
 	void Init();
-	void Release();
 
 public:
 	FrequencyFilter();
@@ -138,13 +151,25 @@ public:
 	fftwf_complex *fblock;			/**< current frequency block data. */
 	fftwf_complex *fblock_flog;		/**< current frequency block log data. */
 
-	fftwf_plan fftplan;				/**< pointer to plans used for fft*/
-	fftwf_plan ifftplan;			/**< pointer to plans used for ifft*/
-	
+	/**
+	 * Take the buffers (inmat, fblock, fblock_flog) of the calling thread, which are allocated at the first call in each
+	 * thread and reused by the following filters; if another filter of the thread is using them, new buffers are allocated.
+	 * The buffers must be given back by Release() in the same thread.
+	 */
+	void Acquire();
+	void Release();					///< give back the buffers taken by Acquire()
+
 	void Convolution(int o_cur, int type, int loc);
+	void Forward();					///< forward FFT of inmat into fblock
 
-	static void open_lib();		///< to be called once at the beginning of main
-	static void close_lib();		///< to be called once at the end of main
+	/**
+	 * Optional global initialization, to be called once at the beginning of main.
+	 * If a wisdom file is given, the wisdom is imported from it (if it exists), the plans are measured instead of
+	 * estimated, and the accumulated wisdom is saved again by close_lib(), so only the first run pays for the planning.
+	 * @param wisdom the FFTW wisdom file (NULL = estimate the plans)
+	 */
+	static void open_lib(const char * wisdom = NULL);
+	static void close_lib();		///< to be called once at the end of main (destroys the plans); no FrequencyFilter may be used afterwards
 
 };
 
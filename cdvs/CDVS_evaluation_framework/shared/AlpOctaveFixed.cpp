@@ -0,0 +1,597 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include "AlpOctaveFixed.h"
+#include <cmath>
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define ALP_OCTAVE_FIXED_X86		// the AVX2 kernels are compiled with function-specific target attributes
+#endif
+
+#if defined(__SSE2__) || defined(ALP_OCTAVE_FIXED_X86)
+	#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace mpeg7cdvs;
+
+FixedFilter::FixedFilter(const Filter & filter):ntaps(filter.ntaps)
+{
+	int sum = 0;
+	for (int j = 0; j < ntaps; ++j)
+	{
+		kernel[j] = (short) floor(filter.kernel[j] * (1 << shift) + 0.5);
+		sum += kernel[j];
+	}
+
+	kernel[ntaps / 2] += (1 << shift) - sum;		// the taps must sum to exactly 2^shift
+
+	for (int i = 0; 2*i < ntaps; ++i)
+	{
+		int high = (2*i + 1 < ntaps) ? kernel[2*i + 1] : 0;
+		pairs[i] = (kernel[2*i] & 0xffff) | (high << 16);
+	}
+}
+
+// A = -0.246388*L1 + 0.493379*L2 - 0.271662*L3 + 0.013998*L4 (and so on for B, C, D, as in AlpOctave::computeResponse),
+// where Lk is the Laplacian of level k multiplied by sigmas[k-1]^2 (2.56, 5.12, 10.24, 20.48).
+
+const int AlpOctaveFixed::coeffShift[4] = {13, 10, 8, 9};
+
+const short AlpOctaveFixed::coeff[4][4] = {
+		{-5167, 20694, -22789, 2348},
+		{6559, -23926, 21085, 3248},
+		{-5374, 17016, -10603, -5539},
+		{11329, -28423, 11117, 14561}
+};
+
+AlpOctaveFixed::AlpOctaveFixed():AlpOctave()
+{
+	Q[0] = Q[1] = Q[2] = Q[3] = NULL;
+}
+
+/*
+ * The fixed-point filters are built at the first use, when the filters of AlpOctave have surely been initialized.
+ */
+const FixedFilter * AlpOctaveFixed::filters()
+{
+	static const FixedFilter fixed[4] = {FixedFilter(o1g1_filter), FixedFilter(g2_filter), FixedFilter(g3_filter), FixedFilter(g4_filter)};
+	return fixed;
+}
+
+void AlpOctaveFixed::setLevels()
+{
+	// each floating point buffer holds 2*capacity 16-bit values; G2 and G3 are free until getAlpKeypoints()
+
+	Q[0] = (short *) G1;
+	Q[1] = Q[0] + capacity;
+	Q[2] = (short *) G4;
+	Q[3] = Q[2] + capacity;
+}
+
+bool AlpOctaveFixed::init(const unsigned char * data, int width_par, int height_par)
+{
+	if (min(width_par, height_par) <= minSize)
+		return false;
+
+	octave = 0;				// this is the first octave
+	extraTopLines = 0;
+	extraBottomLines = 0;
+	width = width_par;
+	height = height_par;
+	fast_mode = false;
+	int size = width_par * height_par;
+
+	allocate(width, height, 1);		// allocate memory (if needed)
+	setLevels();
+
+	for (int k = 0; k < size; ++k)
+		Q[3][k] = (short) ((data[k] - levelOffset) * (1 << levelShift));		// Q4 is free: use it for the source image
+
+	const FixedFilter * filter = filters();
+	conv2(Q[3], filter[0], Q[0]);	// now Q1 contains the filtered image
+	conv2(Q[0], filter[1], Q[1]);	// now Q2 contains the filtered image
+	conv2(Q[1], filter[2], Q[2]);	// now Q3 contains the filtered image
+	conv2(Q[2], filter[3], Q[3]);	// now Q4 contains the filtered image
+
+	return true;
+}
+
+bool AlpOctaveFixed::init(const AlpOctaveFixed & previous)
+{
+	if (min(previous.width, previous.height) <= 2*minSize)
+		return false;
+
+	width = previous.width / 2;
+	height = previous.height / 2;
+	octave = previous.octave + 1;
+	extraTopLines = 0;
+	extraBottomLines = 0;
+	fast_mode = false;
+
+	allocate(width, height, 1);		// allocate memory (if needed)
+	setLevels();
+
+	// get data from previous Q3 (subsampling)
+
+	for (int i=0; i<height; ++i)
+	{
+		short * dest = Q[0] + i*width;							// set destination
+		const short * source = previous.Q[2] + 2*i*previous.width;	// set source
+
+		for (int k=0; k < width; ++k)
+			dest[k] = source[2*k];		// copy and subsample
+	}
+
+	const FixedFilter * filter = filters();
+	conv2(Q[0], filter[1], Q[1]);	// now Q2 contains the filtered image
+	conv2(Q[1], filter[2], Q[2]);	// now Q3 contains the filtered image
+	conv2(Q[2], filter[3], Q[3]);	// now Q4 contains the filtered image
+
+	return true;
+}
+
+void AlpOctaveFixed::toFloat(const short * level, float * imageout) const
+{
+	const float scale = 1.0f / (1 << levelShift);
+	int size = width * height;
+	int k = 0;
+#ifdef __SSE2__
+	const __m128 vscale = _mm_set1_ps(scale);
+	const __m128 offset = _mm_set1_ps((float) levelOffset);
+	for (; k + 8 <= size; k += 8)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *) (level + k));
+		__m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+		__m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+		_mm_storeu_ps(imageout + k, _mm_add_ps(_mm_mul_ps(lo, vscale), offset));
+		_mm_storeu_ps(imageout + k + 4, _mm_add_ps(_mm_mul_ps(hi, vscale), offset));
+	}
+#endif
+	for (; k < size; ++k)
+		imageout[k] = level[k] * scale + levelOffset;
+}
+
+void AlpOctaveFixed::getAlpKeypoints(std::vector<FeatureAlp> & outKeypoints, bool rescale, bool lazyGradients)
+{
+	// the gradients of scale 1 and 2 are computed from G2 and G3; the next octave has already used Q3
+
+	toFloat(Q[1], G2);
+	toFloat(Q[2], G3);
+
+	AlpOctave::getAlpKeypoints(outKeypoints, rescale, lazyGradients);
+}
+
+/*
+ * Separable smoothing with 16-bit taps summing to 2^FixedFilter::shift: each pass accumulates in 32 bits and rounds
+ * the result back to 16 bits. As the taps are positive, the results never exceed the largest input value.
+ * The SIMD code multiplies two taps at a time (madd) on interleaved pairs of inputs.
+ */
+
+static inline short roundTaps(int acc)
+{
+	return (short) ((acc + (1 << (FixedFilter::shift - 1))) >> FixedFilter::shift);
+}
+
+static void smoothColumnsFixed_scalar(short * out, const short * const * rows, const FixedFilter & filter, int begin, int width)
+{
+	for (int x = begin; x < width; ++x)
+	{
+		int acc = 0;
+		for (int j = 0; j < filter.ntaps; ++j)
+			acc += rows[j][x] * filter.kernel[j];
+		out[x] = roundTaps(acc);
+	}
+}
+
+static void smoothRowFixed_scalar(short * out, const short * in, const FixedFilter & filter, int begin, int width)
+{
+	for (int x = begin; x < width; ++x)
+	{
+		int acc = 0;
+		for (int j = 0; j < filter.ntaps; ++j)
+			acc += in[x + j] * filter.kernel[j];
+		out[x] = roundTaps(acc);
+	}
+}
+
+#ifdef __SSE2__
+
+static void smoothColumnsFixed_sse(short * out, const short * const * rows, const FixedFilter & filter, int begin, int width)
+{
+	const __m128i round = _mm_set1_epi32(1 << (FixedFilter::shift - 1));
+	int x = begin;
+	for (; x + 8 <= width; x += 8)
+	{
+		__m128i acclo = round, acchi = round;
+		for (int j = 0; j < filter.ntaps; j += 2)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i *) (rows[j] + x));
+			__m128i b = _mm_loadu_si128((const __m128i *) (rows[j + 1] + x));		// rows[ntaps] is valid (zero tap)
+			__m128i k = _mm_set1_epi32(filter.pairs[j / 2]);
+			acclo = _mm_add_epi32(acclo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), k));
+			acchi = _mm_add_epi32(acchi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), k));
+		}
+		acclo = _mm_srai_epi32(acclo, FixedFilter::shift);
+		acchi = _mm_srai_epi32(acchi, FixedFilter::shift);
+		_mm_storeu_si128((__m128i *) (out + x), _mm_packs_epi32(acclo, acchi));
+	}
+	smoothColumnsFixed_scalar(out, rows, filter, x, width);
+}
+
+static void smoothRowFixed_sse(short * out, const short * in, const FixedFilter & filter, int begin, int width)
+{
+	const __m128i round = _mm_set1_epi32(1 << (FixedFilter::shift - 1));
+	int x = begin;
+	for (; x + 8 <= width; x += 8)
+	{
+		__m128i acclo = round, acchi = round;
+		for (int j = 0; j < filter.ntaps; j += 2)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i *) (in + x + j));
+			__m128i b = _mm_loadu_si128((const __m128i *) (in + x + j + 1));		// in is padded by one more value (zero tap)
+			__m128i k = _mm_set1_epi32(filter.pairs[j / 2]);
+			acclo = _mm_add_epi32(acclo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), k));
+			acchi = _mm_add_epi32(acchi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), k));
+		}
+		acclo = _mm_srai_epi32(acclo, FixedFilter::shift);
+		acchi = _mm_srai_epi32(acchi, FixedFilter::shift);
+		_mm_storeu_si128((__m128i *) (out + x), _mm_packs_epi32(acclo, acchi));
+	}
+	smoothRowFixed_scalar(out, in, filter, x, width);
+}
+
+#else
+
+static void smoothColumnsFixed_sse(short * out, const short * const * rows, const FixedFilter & filter, int begin, int width)
+{
+	smoothColumnsFixed_scalar(out, rows, filter, begin, width);
+}
+
+static void smoothRowFixed_sse(short * out, const short * in, const FixedFilter & filter, int begin, int width)
+{
+	smoothRowFixed_scalar(out, in, filter, begin, width);
+}
+
+#endif
+
+#ifdef ALP_OCTAVE_FIXED_X86
+
+// the 256-bit unpack and pack instructions work on each 128-bit lane, so packing the two halves restores the order
+
+__attribute__((target("avx2")))
+static void smoothColumnsFixed_avx2(short * out, const short * const * rows, const FixedFilter & filter, int width)
+{
+	const __m256i round = _mm256_set1_epi32(1 << (FixedFilter::shift - 1));
+	int x = 0;
+	for (; x + 16 <= width; x += 16)
+	{
+		__m256i acclo = round, acchi = round;
+		for (int j = 0; j < filter.ntaps; j += 2)
+		{
+			__m256i a = _mm256_loadu_si256((const __m256i *) (rows[j] + x));
+			__m256i b = _mm256_loadu_si256((const __m256i *) (rows[j + 1] + x));
+			__m256i k = _mm256_set1_epi32(filter.pairs[j / 2]);
+			acclo = _mm256_add_epi32(acclo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), k));
+			acchi = _mm256_add_epi32(acchi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), k));
+		}
+		acclo = _mm256_srai_epi32(acclo, FixedFilter::shift);
+		acchi = _mm256_srai_epi32(acchi, FixedFilter::shift);
+		_mm256_storeu_si256((__m256i *) (out + x), _mm256_packs_epi32(acclo, acchi));
+	}
+	smoothColumnsFixed_sse(out, rows, filter, x, width);
+}
+
+__attribute__((target("avx2")))
+static void smoothRowFixed_avx2(short * out, const short * in, const FixedFilter & filter, int width)
+{
+	const __m256i round = _mm256_set1_epi32(1 << (FixedFilter::shift - 1));
+	int x = 0;
+	for (; x + 16 <= width; x += 16)
+	{
+		__m256i acclo = round, acchi = round;
+		for (int j = 0; j < filter.ntaps; j += 2)
+		{
+			__m256i a = _mm256_loadu_si256((const __m256i *) (in + x + j));
+			__m256i b = _mm256_loadu_si256((const __m256i *) (in + x + j + 1));
+			__m256i k = _mm256_set1_epi32(filter.pairs[j / 2]);
+			acclo = _mm256_add_epi32(acclo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), k));
+			acchi = _mm256_add_epi32(acchi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), k));
+		}
+		acclo = _mm256_srai_epi32(acclo, FixedFilter::shift);
+		acchi = _mm256_srai_epi32(acchi, FixedFilter::shift);
+		_mm256_storeu_si256((__m256i *) (out + x), _mm256_packs_epi32(acclo, acchi));
+	}
+	smoothRowFixed_sse(out, in, filter, x, width);
+}
+
+#endif
+
+// the kernels are selected as in AlpOctave; there is no AVX kernel, so the AVX level uses the SSE2 kernels
+
+static inline void smoothColumnsFixed(short * out, const short * const * rows, const FixedFilter & filter, int width)
+{
+	const int level = AlpOctave::getImplementation();
+#ifdef ALP_OCTAVE_FIXED_X86
+	if (level >= AlpOctave::AVX2)
+	{
+		smoothColumnsFixed_avx2(out, rows, filter, width);
+		return;
+	}
+#endif
+	if (level >= AlpOctave::SSE2)
+		smoothColumnsFixed_sse(out, rows, filter, 0, width);
+	else
+		smoothColumnsFixed_scalar(out, rows, filter, 0, width);
+}
+
+static inline void smoothRowFixed(short * out, const short * in, const FixedFilter & filter, int width)
+{
+	const int level = AlpOctave::getImplementation();
+#ifdef ALP_OCTAVE_FIXED_X86
+	if (level >= AlpOctave::AVX2)
+	{
+		smoothRowFixed_avx2(out, in, filter, width);
+		return;
+	}
+#endif
+	if (level >= AlpOctave::SSE2)
+		smoothRowFixed_sse(out, in, filter, 0, width);
+	else
+		smoothRowFixed_scalar(out, in, filter, 0, width);
+}
+
+void AlpOctaveFixed::conv2(const short * imagein, const FixedFilter & filter, short * imageout) const
+{
+	// as in AlpOctave::conv2, the border pixels are replicated; tmp holds the vertically filtered row
+
+	const int half = filter.ntaps / 2;
+	short * padded = (short *) tmp;
+	const short * rows[Filter::maxsize + 1];
+
+	for (int y = 0; y < height; ++y)
+	{
+		for (int j = 0; j < filter.ntaps; ++j)
+			rows[j] = imagein + min(max(y - half + j, 0), height - 1) * width;
+		rows[filter.ntaps] = rows[filter.ntaps - 1];
+
+		smoothColumnsFixed(padded + half, rows, filter, width);
+
+		for (int x = 0; x < half; ++x)
+		{
+			padded[x] = padded[half];
+			padded[half + width + x] = padded[half + width - 1];
+		}
+		padded[2*half + width] = 0;
+
+		smoothRowFixed(imageout + y * width, padded, filter, width);
+	}
+}
+
+/*
+ * Response of a range of pixels: the Laplacians of the four levels, the coefficients A, B, C, D of the polynomial and
+ * the Laplacians L1, L4 at the octave boundaries (see AlpOctave::computeResponse).
+ * The Laplacian of a pixel always fits in 16 bits because the levels are smooth: in the worst case (an isolated
+ * white pixel) it is about 75, 37, 19 and 9 gray levels in the four levels, i.e. at most 19200 in fixed point, so the
+ * SIMD code can compute it modulo 2^16. For the same reason, the sums of the products by the coefficients of A, B,
+ * C, D always fit in 32 bits. Only the first and the last pixel of each line, which are never keypoint candidates,
+ * may wrap around (their Laplacian uses the pixels at the other end of the adjacent line).
+ */
+struct FixedResponse
+{
+	const short * q[4];		// the four levels
+	float * out[4];			// A, B, C, D
+	float * l1;				// L1
+	float * l4;				// L4
+	int width;				// the line width
+	int coeffPairs[4][2];	// the coefficients of levels (1,2) and (3,4) of A, B, C, D, as used by madd
+	float scale[4];			// fixed-point to floating point scale of A, B, C, D
+	float scaleL1;			// fixed-point to floating point scale of L1
+	float scaleL4;			// fixed-point to floating point scale of L4
+};
+
+static inline int laplacianFixed(const short * src, int k, int w)
+{
+	return (short) (src[k - w] + src[k - 1] - 4*src[k] + src[k + 1] + src[k + w]);		// modulo 2^16, as the SIMD code
+}
+
+static void responseFixed_scalar(const FixedResponse & r, int begin, int end)
+{
+	for (int k = begin; k < end; ++k)
+	{
+		int lap[4] = {laplacianFixed(r.q[0], k, r.width), laplacianFixed(r.q[1], k, r.width), laplacianFixed(r.q[2], k, r.width), laplacianFixed(r.q[3], k, r.width)};
+
+		for (int c = 0; c < 4; ++c)
+		{
+			int acc = (short) r.coeffPairs[c][0] * lap[0] + (r.coeffPairs[c][0] >> 16) * lap[1]
+					+ (short) r.coeffPairs[c][1] * lap[2] + (r.coeffPairs[c][1] >> 16) * lap[3];
+			r.out[c][k] = (float) acc * r.scale[c];
+		}
+
+		r.l1[k] = (float) lap[0] * r.scaleL1;
+		r.l4[k] = (float) lap[3] * r.scaleL4;
+	}
+}
+
+#ifdef __SSE2__
+
+static inline __m128i laplacianFixed(const short * src, int w)
+{
+	__m128i c = _mm_loadu_si128((const __m128i *) src);
+	__m128i sum = _mm_add_epi16(_mm_loadu_si128((const __m128i *) (src - w)), _mm_loadu_si128((const __m128i *) (src + w)));
+	sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_loadu_si128((const __m128i *) (src - 1)), _mm_loadu_si128((const __m128i *) (src + 1))));
+	return _mm_sub_epi16(sum, _mm_slli_epi16(c, 2));
+}
+
+static inline __m128 toFloatLow(__m128i v)		// the 4 low 16-bit values of v as floats
+{
+	return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+}
+
+static inline __m128 toFloatHigh(__m128i v)		// the 4 high 16-bit values of v as floats
+{
+	return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+}
+
+static void responseFixed_sse(const FixedResponse & r, int begin, int end)
+{
+	const __m128 scaleL1 = _mm_set1_ps(r.scaleL1);
+	const __m128 scaleL4 = _mm_set1_ps(r.scaleL4);
+
+	int k = begin;
+	for (; k + 8 <= end; k += 8)
+	{
+		__m128i lap1 = laplacianFixed(r.q[0] + k, r.width);
+		__m128i lap2 = laplacianFixed(r.q[1] + k, r.width);
+		__m128i lap3 = laplacianFixed(r.q[2] + k, r.width);
+		__m128i lap4 = laplacianFixed(r.q[3] + k, r.width);
+
+		__m128i lo12 = _mm_unpacklo_epi16(lap1, lap2), hi12 = _mm_unpackhi_epi16(lap1, lap2);
+		__m128i lo34 = _mm_unpacklo_epi16(lap3, lap4), hi34 = _mm_unpackhi_epi16(lap3, lap4);
+
+		for (int c = 0; c < 4; ++c)		// A, B, C, D: 32-bit sums of 16-bit products
+		{
+			__m128i k12 = _mm_set1_epi32(r.coeffPairs[c][0]);
+			__m128i k34 = _mm_set1_epi32(r.coeffPairs[c][1]);
+			__m128 scale = _mm_set1_ps(r.scale[c]);
+			__m128i lo = _mm_add_epi32(_mm_madd_epi16(lo12, k12), _mm_madd_epi16(lo34, k34));
+			__m128i hi = _mm_add_epi32(_mm_madd_epi16(hi12, k12), _mm_madd_epi16(hi34, k34));
+			_mm_storeu_ps(r.out[c] + k, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+			_mm_storeu_ps(r.out[c] + k + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+		}
+
+		_mm_storeu_ps(r.l1 + k, _mm_mul_ps(toFloatLow(lap1), scaleL1));
+		_mm_storeu_ps(r.l1 + k + 4, _mm_mul_ps(toFloatHigh(lap1), scaleL1));
+		_mm_storeu_ps(r.l4 + k, _mm_mul_ps(toFloatLow(lap4), scaleL4));
+		_mm_storeu_ps(r.l4 + k + 4, _mm_mul_ps(toFloatHigh(lap4), scaleL4));
+	}
+	responseFixed_scalar(r, k, end);
+}
+
+#else
+
+static void responseFixed_sse(const FixedResponse & r, int begin, int end)
+{
+	responseFixed_scalar(r, begin, end);
+}
+
+#endif
+
+#ifdef ALP_OCTAVE_FIXED_X86
+
+__attribute__((target("avx2")))
+static inline __m256i laplacianFixed_avx2(const short * src, int w)
+{
+	__m256i c = _mm256_loadu_si256((const __m256i *) src);
+	__m256i sum = _mm256_add_epi16(_mm256_loadu_si256((const __m256i *) (src - w)), _mm256_loadu_si256((const __m256i *) (src + w)));
+	sum = _mm256_add_epi16(sum, _mm256_add_epi16(_mm256_loadu_si256((const __m256i *) (src - 1)), _mm256_loadu_si256((const __m256i *) (src + 1))));
+	return _mm256_sub_epi16(sum, _mm256_slli_epi16(c, 2));
+}
+
+__attribute__((target("avx2")))
+static inline void storeFloats_avx2(float * out, __m256i lo, __m256i hi, __m256 scale)		// lo, hi: 32-bit values of pixels 0-3, 8-11 and 4-7, 12-15
+{
+	_mm256_storeu_ps(out, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_permute2x128_si256(lo, hi, 0x20)), scale));
+	_mm256_storeu_ps(out + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_permute2x128_si256(lo, hi, 0x31)), scale));
+}
+
+__attribute__((target("avx2")))
+static void responseFixed_avx2(const FixedResponse & r, int end)
+{
+	const __m256 scaleL1 = _mm256_set1_ps(r.scaleL1);
+	const __m256 scaleL4 = _mm256_set1_ps(r.scaleL4);
+
+	int k = 0;
+	for (; k + 16 <= end; k += 16)
+	{
+		__m256i lap1 = laplacianFixed_avx2(r.q[0] + k, r.width);
+		__m256i lap2 = laplacianFixed_avx2(r.q[1] + k, r.width);
+		__m256i lap3 = laplacianFixed_avx2(r.q[2] + k, r.width);
+		__m256i lap4 = laplacianFixed_avx2(r.q[3] + k, r.width);
+
+		__m256i lo12 = _mm256_unpacklo_epi16(lap1, lap2), hi12 = _mm256_unpackhi_epi16(lap1, lap2);
+		__m256i lo34 = _mm256_unpacklo_epi16(lap3, lap4), hi34 = _mm256_unpackhi_epi16(lap3, lap4);
+
+		for (int c = 0; c < 4; ++c)		// A, B, C, D: 32-bit sums of 16-bit products
+		{
+			__m256i k12 = _mm256_set1_epi32(r.coeffPairs[c][0]);
+			__m256i k34 = _mm256_set1_epi32(r.coeffPairs[c][1]);
+			__m256i lo = _mm256_add_epi32(_mm256_madd_epi16(lo12, k12), _mm256_madd_epi16(lo34, k34));
+			__m256i hi = _mm256_add_epi32(_mm256_madd_epi16(hi12, k12), _mm256_madd_epi16(hi34, k34));
+			storeFloats_avx2(r.out[c] + k, lo, hi, _mm256_set1_ps(r.scale[c]));
+		}
+
+		storeFloats_avx2(r.l1 + k, _mm256_srai_epi32(_mm256_unpacklo_epi16(lap1, lap1), 16), _mm256_srai_epi32(_mm256_unpackhi_epi16(lap1, lap1), 16), scaleL1);
+		storeFloats_avx2(r.l4 + k, _mm256_srai_epi32(_mm256_unpacklo_epi16(lap4, lap4), 16), _mm256_srai_epi32(_mm256_unpackhi_epi16(lap4, lap4), 16), scaleL4);
+	}
+	responseFixed_sse(r, k, end);
+}
+
+#endif
+
+void AlpOctaveFixed::computeResponse(int startLineSrc, int startLineDst, int nLines)
+{
+	const int start_offset = startLineSrc * width;
+	const int dest_offset  = startLineDst * width;
+
+	FixedResponse r;
+	for (int c = 0; c < 4; ++c)
+	{
+		r.q[c] = Q[c] + start_offset;
+		r.coeffPairs[c][0] = (coeff[c][0] & 0xffff) | (coeff[c][1] << 16);
+		r.coeffPairs[c][1] = (coeff[c][2] & 0xffff) | (coeff[c][3] << 16);
+		r.scale[c] = ldexpf(1.0f, -(levelShift + coeffShift[c]));
+	}
+	r.out[0] = A + dest_offset;
+	r.out[1] = B + dest_offset;
+	r.out[2] = C + dest_offset;
+	r.out[3] = D + dest_offset;
+	r.l1 = L1 + dest_offset;
+	r.l4 = L4 + dest_offset;
+	r.width = width;
+	r.scaleL1 = ldexpf(sigmas[0] * sigmas[0], -levelShift);
+	r.scaleL4 = ldexpf(sigmas[3] * sigmas[3], -levelShift);
+
+	const int level = AlpOctave::getImplementation();
+#ifdef ALP_OCTAVE_FIXED_X86
+	if (level >= AlpOctave::AVX2)
+		responseFixed_avx2(r, nLines * width);
+	else
+#endif
+	if (level >= AlpOctave::SSE2)
+		responseFixed_sse(r, 0, nLines * width);
+	else
+		responseFixed_scalar(r, 0, nLines * width);
+
+	computeExtrema(startLineDst, nLines);
+}
@@ -0,0 +1,115 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#pragma once
+#include "AlpOctave.h"
+
+namespace mpeg7cdvs
+{
+
+/**
+ * @class FixedFilter
+ * A separable Gaussian filter kernel with 16-bit fixed-point taps, whose sum is exactly 2^shift.
+ */
+class FixedFilter
+{
+public:
+	static const int shift = 14;			///< the taps are multiplied by 2^shift
+	int ntaps;								///< the number of filter taps
+	short kernel[Filter::maxsize];			///< the filter kernel values
+	int pairs[(Filter::maxsize + 1) / 2];	///< the taps 2i (low 16 bits) and 2i+1 (high 16 bits), as used by the SIMD code
+
+	/**
+	 * Quantize the given filter.
+	 * @param filter the floating point filter
+	 */
+	FixedFilter(const Filter & filter);
+};
+
+/**
+ * @class AlpOctaveFixed
+ * Experimental fixed-point version of AlpOctave.
+ * The four Gaussian levels are 16-bit integers (the gray levels minus 128, multiplied by 2^levelShift), filtered with 16-bit taps
+ * and 32-bit accumulation. The Laplacians and the polynomial coefficients of the response are computed with integers,
+ * each coefficient with its own calibrated shift, and converted to floating point only to look for the extrema.
+ * Keypoint refinement, orientation and descriptors are computed in floating point as in AlpOctave, from the levels 2
+ * and 3 converted back to floating point. The integer levels are stored in the memory of G1 and G4, so the memory
+ * use is the same as in AlpOctave.
+ */
+class AlpOctaveFixed : public AlpOctave
+{
+private:
+	static const int levelOffset = 128;		// the levels contain the gray levels minus levelOffset...
+	static const int levelShift = 8;		// ...multiplied by 2^levelShift (from -32768 to 32512)
+	static const int coeffShift[4];			// shifts of the coefficients of A, B, C, D: the largest that keep them in 16 bits
+	static const short coeff[4][4];			// coefficients of A, B, C, D, multiplied by the sigma^2 of each level and 2^coeffShift
+
+	short * Q[4];		// the fixed-point Gaussian levels
+
+	static const FixedFilter * filters();		// the fixed-point filters of G1 (octave 1), G2, G3, G4
+	void setLevels();	// set the level pointers in the memory of G1 and G4
+	void conv2(const short * imagein, const FixedFilter & filter, short * imageout) const;	// separable smoothing (imagein != imageout)
+	void toFloat(const short * level, float * imageout) const;		// convert a level to gray levels in floating point
+
+protected:
+	virtual void computeResponse(int startLineSrc, int startLineDst, int nLines);
+
+public:
+	AlpOctaveFixed();					///< constructor
+
+	/**
+	 * initialize the first octave using the given image.
+	 * @param data the image data
+	 * @param width the image width
+	 * @param height the image height
+	 * @return true if successful
+	 */
+	bool init(const unsigned char * data, int width, int height);
+
+	/**
+	 * initialize the octave using the previous octave.
+	 * @param previous the previous octave
+	 * @return true if successful
+	 */
+	bool init(const AlpOctaveFixed & previous);
+
+	/**
+	 * Get Alp keypoints; the levels used by the descriptors are converted to floating point.
+	 * This must be done after init(), detect() and detectDuplicates(), and after the next octave has been initialized.
+	 * @param outKeypoints the output vector of keypoints
+	 * @param rescale rescale the keypoints to their absolute value
+	 * @param lazyGradients if true, computeDescriptor() computes the gradients only around the described keypoints
+	 */
+	void getAlpKeypoints(std::vector<FeatureAlp> & outKeypoints, bool rescale = true, bool lazyGradients = false);
+};
+
+}	// end of namespace
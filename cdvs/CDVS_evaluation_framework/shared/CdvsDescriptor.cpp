@@ -68,10 +68,27 @@ void CdvsDescriptor::clear() {
 
 size_t CdvsDescriptor::encode(const Parameters & params, ImageBuffer & image, const SCFVFactory & g_factory)
 {
-	debuglevel = params.debugLevel;			// 0 = off, 1 = on (quiet), 2 = on (verbose), 3 = verbose + dump files
+	extractFeatures(featurelist, params, image);		// detect and describe the key points
+	return encodeFeatures(params, g_factory);
+}
+
+void CdvsDescriptor::extractFeatures(FeatureList & featurelist, const Parameters & params, ImageBuffer & image)
+{
 	featurelist.features.clear();			// cleanup featurelist
 	featurelist.setResolution(image.width, image.height, image.originalWidth, image.originalHeight);
 	image.detect(featurelist, params);		// detect all key points in the image
+	image.extract(featurelist, params.selectMaxPoints);	// extract all key points (up to the defined limit)
+	featurelist.selectFirst(params.selectMaxPoints);	// drop all other points
+}
+
+size_t CdvsDescriptor::numGlobalFeatures(const FeatureList & featurelist)
+{
+	return std::min((size_t) num_features_in_GD, featurelist.features.size());
+}
+
+size_t CdvsDescriptor::encodeFeatures(const Parameters & params, const SCFVFactory & g_factory, const SCFVSignature * signature)
+{
+	debuglevel = params.debugLevel;			// 0 = off, 1 = on (quiet), 2 = on (verbose), 3 = verbose + dump files
 
 	// set parameters
 
@@ -88,14 +105,14 @@ size_t CdvsDescriptor::encode(const Parameters & params, ImageBuffer & image, co
 	if  (modeID > mode_id_limit)
 		throw CdvsException("Unknown mode ID");			// this is not a CDVS descriptor
 
-	// compute Global Descriptor
-
-	image.extract(featurelist, params.selectMaxPoints);	// extract all key points (up to the defined limit)
-	featurelist.selectFirst(params.selectMaxPoints);	// drop all other points
+	featurelist.selectFirst(params.selectMaxPoints);	// drop the points exceeding the limit of this mode
 
     // Generate global signature
 
-    g_factory.generateSCFV(featurelist, scfvSignature, num_features_in_GD);
+	if (signature != NULL)
+		scfvSignature = *signature;
+	else
+		g_factory.generateSCFV(featurelist, scfvSignature, num_features_in_GD);
 
 	// Local descriptors
 
@@ -90,6 +90,35 @@ public:
 	 */
 	size_t encode(const Parameters & params, ImageBuffer & image, const SCFVFactory & g_factory);
 
+	/**
+	 * Detect and describe the key points of an image, as done by encode(): the features are sorted
+	 * in descending order of importance and only the first params.selectMaxPoints ones are kept.
+	 * The first n features do not depend on params.selectMaxPoints (if not lower than n), so the features
+	 * extracted once for the largest selectMaxPoints can be used to encode several modes (see encodeFeatures()).
+	 * @param featurelist the output features
+	 * @param params set of parameters to apply for one specific mode
+	 * @param image the input image buffer
+	 */
+	static void extractFeatures(FeatureList & featurelist, const Parameters & params, ImageBuffer & image);
+
+	/**
+	 * Encode the CDVS descriptor from the features already stored in featurelist by extractFeatures();
+	 * the features exceeding params.selectMaxPoints are dropped.
+	 * @param params set of parameters to apply for one specific mode
+	 * @param g_factory the Global Descriptor factory instance that produces the GD signature for the specific mode selected in the parameters
+	 * @param signature if not NULL, the GD signature already computed by g_factory for the same first num_features_in_GD features
+	 * @return the size of the produced descriptor (bytes).
+	 */
+	size_t encodeFeatures(const Parameters & params, const SCFVFactory & g_factory, const SCFVSignature * signature = NULL);
+
+	/**
+	 * Get the number of features used to compute the global descriptor signature from the given features.
+	 * Two modes having the same SCFVFactory settings produce the same signature if this number is the same.
+	 * @param featurelist the features of the descriptor, after dropping those exceeding selectMaxPoints
+	 * @return the number of features used by the global descriptor
+	 */
+	static size_t numGlobalFeatures(const FeatureList & featurelist);
+
 	/**
 	 * Decode the CDVS descriptor.
 	 * @param pset set of parameters to apply for all modes from 0 to 6
@@ -53,6 +53,18 @@ typedef struct {
   float fScore;				///< score assigned by the local descriptors matching
 } RetrievalData;
 
+/**
+ * A structure containing the counters of the work done and pruned by a retrieval operation.
+ */
+typedef struct {
+  unsigned int nCandidates;		///< number of candidates selected by the global descriptor matching
+  unsigned int nSkipped;		///< number of candidates not matched, because they could not enter the list of results
+  unsigned int nAbandoned;		///< number of candidates whose local descriptor matching was abandoned early
+  unsigned int nDistratSkipped;	///< number of matched candidates not verified by DISTRAT, because their total matching weight was too low
+  unsigned int nPrefiltered;	///< number of matched candidates not verified by DISTRAT, because too few matches agree on scale and rotation
+  unsigned int nVerified;		///< number of candidates verified by DISTRAT
+} RetrievalStats;
+
 
 /**
  * Type of matching
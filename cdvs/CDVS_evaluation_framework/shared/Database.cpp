@@ -88,11 +88,21 @@ int Database::matchCompressedDescriptors_twoWay(PointPairs &pairs, const Compres
 	return images[imageDBindex].matchDescriptors_twoWay(pairs, query, ratioThreshold);
 }
 
+int Database::matchCompressedDescriptors_twoWay(PointPairs &pairs, const CompressedFeatureList &query, int imageDBindex, float ratioThreshold, MatchScratch & scratch, double minWeight) const
+{
+	return images[imageDBindex].matchDescriptors_twoWay(pairs, query, ratioThreshold, scratch, minWeight);
+}
+
 int Database::matchCompressedDescriptors_oneWay(PointPairs &pairs, const CompressedFeatureList &query, int imageDBindex, float ratioThreshold) const
 {
 	return images[imageDBindex].matchDescriptors_oneWay(pairs, query, ratioThreshold);
 }
 
+int Database::matchCompressedDescriptors_oneWay(PointPairs &pairs, const CompressedFeatureList &query, int imageDBindex, float ratioThreshold, MatchScratch & scratch, double minWeight) const
+{
+	return images[imageDBindex].matchDescriptors_oneWay(pairs, query, ratioThreshold, scratch, minWeight);
+}
+
 //
 // if the DB is not empty, expand it.
 // If the DB is empty, create it.
@@ -99,6 +99,19 @@ public:
 	 */
 	int matchCompressedDescriptors_oneWay(PointPairs &pairs, const CompressedFeatureList &query, int imageDBindex, float ratioThreshold) const;
 
+	/**
+	 * Euclidean match of a query against an image contained in the DB, with index imageDBindex in a one way fashion, using the given working memory.
+	 * The coordinates of the matched points are stored in the PointPairs container class.
+	 * @param pairs computed matching pairs of points
+	 * @param query features of the query image.
+	 * @param imageDBindex index of the image contained in the database that will be compared to the query.
+	 * @param ratioThreshold the threshold used in the ratio test.
+	 * @param scratch reusable working memory (one per thread).
+	 * @param minWeight the matching is abandoned if its total weight cannot reach this value (0 = never abandon).
+	 * @return number of matched points.
+	 */
+	int matchCompressedDescriptors_oneWay(PointPairs &pairs, const CompressedFeatureList &query, int imageDBindex, float ratioThreshold, MatchScratch & scratch, double minWeight = 0.0) const;
+
 	/**
 	 * Euclidean match of a query against an image contained in the DB, with index imageDBindex in a two way fashion.
 	 * The coordinates of the matched points are stored in the PointPairs container class.
@@ -110,6 +123,19 @@ public:
 	 */
 	int matchCompressedDescriptors_twoWay(PointPairs &pairs, const CompressedFeatureList &query, int imageDBindex, float ratioThreshold) const;
 
+	/**
+	 * Euclidean match of a query against an image contained in the DB, with index imageDBindex in a two way fashion, using the given working memory.
+	 * The coordinates of the matched points are stored in the PointPairs container class.
+	 * @param pairs computed matching pairs of points
+	 * @param query features of the query image.
+	 * @param imageDBindex index of the image contained in the database that will be compared to the query.
+	 * @param ratioThreshold the threshold used in the ratio test.
+	 * @param scratch reusable working memory (one per thread).
+	 * @param minWeight the matching is abandoned if its total weight cannot reach this value (0 = never abandon).
+	 * @return number of matched points.
+	 */
+	int matchCompressedDescriptors_twoWay(PointPairs &pairs, const CompressedFeatureList &query, int imageDBindex, float ratioThreshold, MatchScratch & scratch, double minWeight = 0.0) const;
+
 	/** 
 	 * Read an entire database from the given file.
 	 * @param filename the pathname of the file containing the database.
@@ -0,0 +1,110 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include "FeatureBudget.h"
+#include "AlpDetector.h"
+#include <algorithm>
+#include <functional>
+
+using namespace std;
+using namespace mpeg7cdvs;
+
+FeatureBudget::FeatureBudget(size_t maxFeatures, int imageWidth, int imageHeight):maxFeatures(maxFeatures),best()
+{
+	halfImageWidth = (float) imageWidth/2;		// as in AlpDetector::sortPdf(FeatureList &)
+	halfImageHeight = (float) imageHeight/2;
+	best.reserve(maxFeatures + 1);
+}
+
+float FeatureBudget::computePdf(const Feature & feature, int baseY) const
+{
+	if (baseY <= 0)
+		return AlpDetector::computePdf(feature, halfImageWidth, halfImageHeight);
+
+	Feature moved(feature);
+	moved.y += baseY;		// the final coordinates of the feature
+	return AlpDetector::computePdf(moved, halfImageWidth, halfImageHeight);
+}
+
+bool FeatureBudget::accept(Feature & feature, int baseY)
+{
+	feature.pdf = computePdf(feature, baseY);
+
+	// a tie with the worst of the best features must be described, as the sort is stable
+
+	return (best.size() < maxFeatures) || best.empty() || (feature.pdf >= best.front());
+}
+
+void FeatureBudget::commit(const FeatureList & featurelist, int octave)
+{
+	if (maxFeatures == 0)
+		return;
+
+	for (std::vector<Feature>::const_iterator f = featurelist.features.begin(); f < featurelist.features.end(); ++f)
+	{
+		if ((f->octave != octave) || (f->spatialIndex == notDescribed))
+			continue;
+
+		float pdf = computePdf(*f);
+		if (best.size() < maxFeatures)
+		{
+			best.push_back(pdf);
+			push_heap(best.begin(), best.end(), greater<float>());
+		}
+		else if (pdf > best.front())
+		{
+			pop_heap(best.begin(), best.end(), greater<float>());
+			best.back() = pdf;
+			push_heap(best.begin(), best.end(), greater<float>());
+		}
+	}
+}
+
+bool FeatureBudget::select(FeatureList & featurelist) const
+{
+	std::vector<Feature> & features = featurelist.features;
+	size_t n = min(maxFeatures, features.size());
+	for (size_t k = 0; k < n; ++k)
+	{
+		if (features[k].spatialIndex == notDescribed)
+			return false;		// a feature without descriptor has been selected
+	}
+
+	features.erase(remove_if(features.begin() + n, features.end(), isNotDescribed), features.end());
+
+	return true;
+}
+
+bool FeatureBudget::isNotDescribed(const Feature & feature)
+{
+	return (feature.spatialIndex == notDescribed);
+}
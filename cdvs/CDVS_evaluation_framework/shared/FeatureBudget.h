@@ -0,0 +1,104 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "FeatureList.h"
+
+namespace mpeg7cdvs
+{
+
+/**
+ * @class FeatureBudget
+ * Keypoint budget of the detectors that describe the keypoints while detecting them (e.g. AlpDetectorLowMem).
+ * Only the first maxFeatures features in descending order of pdf (see AlpDetector::sortPdf()) are kept by the encoder,
+ * so a keypoint whose pdf is lower than the pdf of maxFeatures final features does not need a descriptor.
+ * The features of an octave are final (committed) once the duplicates with the next octave have been removed.
+ * A keypoint without descriptor is still returned (with a single orientation) as it takes part in the
+ * detection of the duplicates; select() removes it after sorting.
+ */
+class FeatureBudget
+{
+public:
+	static const int notDescribed = -2;		///< spatialIndex of the keypoints without descriptor (-1 marks the duplicates)
+
+	/**
+	 * Create the budget of an image.
+	 * @param maxFeatures the number of features kept by the encoder (0 = no limit)
+	 * @param imageWidth the image width of the feature list (see AlpDetector::sortPdf(FeatureList &))
+	 * @param imageHeight the image height of the feature list
+	 */
+	FeatureBudget(size_t maxFeatures, int imageWidth, int imageHeight);
+
+	/**
+	 * Compute the pdf of a feature (see AlpDetector::computePdf()).
+	 * @param feature the feature
+	 * @param baseY the offset to be added to the Y coordinate of the feature
+	 * @return the pdf of the feature
+	 */
+	float computePdf(const Feature & feature, int baseY = 0) const;
+
+	/**
+	 * Compute the pdf of a feature and tell if it can be among the best maxFeatures features.
+	 * @param feature the feature (its pdf is set)
+	 * @param baseY the offset to be added to the Y coordinate of the feature
+	 * @return true if the feature must be described
+	 */
+	bool accept(Feature & feature, int baseY = 0);
+
+	/**
+	 * Count the final features of an octave.
+	 * @param featurelist the features detected so far, without duplicates in the given octave
+	 * @param octave the octave whose features are final
+	 */
+	void commit(const FeatureList & featurelist, int octave);
+
+	/**
+	 * Remove the features without descriptor from a list sorted in descending order of pdf.
+	 * @param featurelist the sorted list of features
+	 * @return false if a feature without descriptor is among the first maxFeatures ones (the list is not modified);
+	 * this cannot happen if the pdf of the sorted features is computed as in computePdf()
+	 */
+	bool select(FeatureList & featurelist) const;
+
+private:
+	size_t maxFeatures;
+	float halfImageWidth;
+	float halfImageHeight;
+	std::vector<float> best;		// min-heap of the pdf of the best maxFeatures committed features
+
+	static bool isNotDescribed(const Feature & feature);
+};
+
+}	// end of namespace
@@ -32,6 +32,7 @@
 
 #include "FeatureList.h"
 #include "Match.h"
+#include "HammingKernel.h"
 #include "CsscCoordinateCoding.h"
 #include "CdvsException.h"
 #include <iostream>
@@ -785,31 +786,38 @@ void CompressedFeatureList::allocate(int nFeatures, int descLen)
 	if ((descLen <= 0) || (descLen > 32))
 		throw CdvsException("invalid parameter descLen passed to CompressedFeatureList::allocate");
 
-	numFeatures = nFeatures;
-	nDescLength = descLen;
-	features = new unsigned char [nFeatures * descLen];
+	if ((nFeatures > featureCapacity) || (nFeatures * descLen > byteCapacity))
+	{
+		clear();		// the current buffers are too small
 
+		features = new unsigned char [nFeatures * descLen];
+		byteCapacity = nFeatures * descLen;
 
-	// allocate array for X and Y coordinates of key points
+		// allocate array for X and Y coordinates of key points
+
+		Xcoord = new unsigned short [nFeatures];
+		Ycoord = new unsigned short [nFeatures];
+		featureCapacity = nFeatures;
+	}
 
-	Xcoord = new unsigned short [nFeatures];
-	Ycoord = new unsigned short [nFeatures];
+	numFeatures = nFeatures;
+	nDescLength = descLen;
 }
 
 void CompressedFeatureList::clear()
 {
-	if (features != NULL)
-	{
-		delete [] features;
-	}
-	if (Xcoord != NULL)
-		delete [] Xcoord;
-
-	if (Ycoord != NULL)
-		delete [] Ycoord;
+	delete [] features;
+	delete [] Xcoord;
+	delete [] Ycoord;
+
+	features = NULL;
+	Xcoord = NULL;
+	Ycoord = NULL;
+	featureCapacity = 0;
+	byteCapacity = 0;
 }
 
-CompressedFeatureList::CompressedFeatureList():imagefile(), features(NULL), numFeatures(0), nDescLength(0),Xcoord(NULL),Ycoord(NULL)
+CompressedFeatureList::CompressedFeatureList():imagefile(), features(NULL), numFeatures(0), nDescLength(0), featureCapacity(0), byteCapacity(0), Xcoord(NULL),Ycoord(NULL)
 {
 	originalWidth = 0;
 	originalHeight = 0;
@@ -817,7 +825,7 @@ CompressedFeatureList::CompressedFeatureList():imagefile(), features(NULL), numF
 	imageWidth = 0;
 }
 
-CompressedFeatureList::CompressedFeatureList(int nFeatures, int descLen):imagefile()
+CompressedFeatureList::CompressedFeatureList(int nFeatures, int descLen):imagefile(), features(NULL), numFeatures(0), nDescLength(0), featureCapacity(0), byteCapacity(0), Xcoord(NULL),Ycoord(NULL)
 {
 	allocate(nFeatures, descLen);
 
@@ -833,7 +841,7 @@ CompressedFeatureList::~CompressedFeatureList()
 }
 
 // copy constructor
-CompressedFeatureList::CompressedFeatureList(const CompressedFeatureList & a):imagefile(), features(NULL), numFeatures(0), nDescLength(0),Xcoord(NULL),Ycoord(NULL)
+CompressedFeatureList::CompressedFeatureList(const CompressedFeatureList & a):imagefile(), features(NULL), numFeatures(0), nDescLength(0), featureCapacity(0), byteCapacity(0), Xcoord(NULL),Ycoord(NULL)
 {
 	originalWidth = a.originalWidth;
 	originalHeight = a.originalHeight;
@@ -853,12 +861,13 @@ CompressedFeatureList::CompressedFeatureList(const CompressedFeatureList & a):im
 	}
 }
 
-
 void CompressedFeatureList::swap(CompressedFeatureList & a)
 {
 	std::swap(imagefile, a.imagefile);
 	std::swap(numFeatures, a.numFeatures);
 	std::swap(nDescLength, a.nDescLength);
+	std::swap(featureCapacity, a.featureCapacity);
+	std::swap(byteCapacity, a.byteCapacity);
 	std::swap(features, a.features);
 	std::swap(Xcoord, a.Xcoord);
 	std::swap(Ycoord, a.Ycoord);
@@ -881,7 +890,12 @@ CompressedFeatureList & CompressedFeatureList::operator=(CompressedFeatureList a
  * Copy constructor from FeatureList including relevance sorting.
  * Converts a FeatureList instance into a CompressedFeatureList.
  */
-CompressedFeatureList::CompressedFeatureList(const FeatureList & a, bool relevantOnly)
+CompressedFeatureList::CompressedFeatureList(const FeatureList & a, bool relevantOnly):imagefile(), features(NULL), numFeatures(0), nDescLength(0), featureCapacity(0), byteCapacity(0), Xcoord(NULL),Ycoord(NULL)
+{
+	assign(a, relevantOnly);
+}
+
+void CompressedFeatureList::assign(const FeatureList & a, bool relevantOnly)
 {
 	originalWidth = a.originalWidth;
 	originalHeight = a.originalHeight;
@@ -1041,51 +1055,87 @@ std::streamoff CompressedFeatureList::write(std::ostream &sout) const
 
 
 int CompressedFeatureList::matchDescriptors_oneWay(PointPairs &pairs, const CompressedFeatureList & otherFeatureList, float ratioThreshold) const
+{
+	MatchScratch scratch;
+	return matchDescriptors_oneWay(pairs, otherFeatureList, ratioThreshold, scratch);
+}
+
+
+/*
+ * The nearest descriptors are found by the Hamming kernel specialized for the descriptor length,
+ * or by the generic one (DescriptorKernel<0>) for the lengths not produced by any CDVS mode.
+ */
+template<int NBYTES>
+struct DescriptorKernel
+{
+	static int nearest(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int nbytes, int * distances,
+			int & minDistance, int & secondMinDistance)
+	{
+		return HammingKernel::nearest<NBYTES>(query, refs, stride, nRefs, distances, minDistance, secondMinDistance);
+	}
+};
+
+template<>
+struct DescriptorKernel<0>
+{
+	static int nearest(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int nbytes, int * distances,
+			int & minDistance, int & secondMinDistance)
+	{
+		return HammingKernel::nearest(query, refs, stride, nRefs, nbytes, distances, minDistance, secondMinDistance);
+	}
+};
+
+
+int CompressedFeatureList::matchDescriptors_oneWay(PointPairs &pairs, const CompressedFeatureList & otherFeatureList, float ratioThreshold, MatchScratch & scratch, double minWeight) const
+{
+	// Check sizes of the descriptors, and select the matcher specialized for their length.
+	int matched_bytes = std::min(nDescLength, otherFeatureList.nDescLength);
+
+	switch (matched_bytes)
+	{
+		case 5:		return matchOneWay<5>(pairs, otherFeatureList, ratioThreshold, scratch, minWeight, matched_bytes);
+		case 10:	return matchOneWay<10>(pairs, otherFeatureList, ratioThreshold, scratch, minWeight, matched_bytes);
+		case 16:	return matchOneWay<16>(pairs, otherFeatureList, ratioThreshold, scratch, minWeight, matched_bytes);
+		case 20:	return matchOneWay<20>(pairs, otherFeatureList, ratioThreshold, scratch, minWeight, matched_bytes);
+		case 32:	return matchOneWay<32>(pairs, otherFeatureList, ratioThreshold, scratch, minWeight, matched_bytes);
+		default:	return matchOneWay<0>(pairs, otherFeatureList, ratioThreshold, scratch, minWeight, matched_bytes);
+	}
+}
+
+
+template<int NBYTES>
+int CompressedFeatureList::matchOneWay(PointPairs &pairs, const CompressedFeatureList & otherFeatureList, float ratioThreshold, MatchScratch & scratch, double minWeight, int matched_bytes) const
 {
 	pairs.nMatched = 0;
+	scratch.abandoned = false;
 
 	if((numFeatures > 1) && (otherFeatureList.numFeatures > 1))
 	{
 		ratioThreshold = ratioThreshold*ratioThreshold;
 
-		int distance;
 		int minDistance, secondMinDistance;
 		int minDistanceInd;
+		double matchedWeight = 0.0;		// total weight of the matches found so far
 
 		Match match;
-		std::vector<Match> matches;
-		std::vector<int> featureMatches;
+		std::vector<Match> & matches = scratch.matches1;
+		matches.clear();
 
-		// Check sizes of the descriptors.
-		int matched_bytes = std::min(nDescLength, otherFeatureList.nDescLength);
+		scratch.distances.resize(otherFeatureList.numFeatures);
 
 		//// Select the two nearest descriptors
 		for(int featureInd=0; featureInd < numFeatures; ++featureInd)
 		{
-			// Find the two nearest descriptors contained in otherFeatureList and the relative distances between f
-
-			minDistance = 65536;
-			secondMinDistance = 65536;
-			minDistanceInd = 0;
-
-			for(int otherFeatureInd = 0; otherFeatureInd < otherFeatureList.numFeatures; ++otherFeatureInd)
+			// Every weight is <= 1: stop if even the remaining features cannot reach minWeight
+			if ((minWeight > 0) && (featureInd % MatchScratch::TILE_ROWS == 0) && (matchedWeight + (numFeatures - featureInd) < minWeight))
 			{
-				distance = getDistance(features + featureInd*nDescLength, otherFeatureList.features + otherFeatureInd*otherFeatureList.nDescLength, matched_bytes);
+				scratch.abandoned = true;
+				return 0;
+			}
 
-				if(distance<minDistance)
-				{
-					secondMinDistance = minDistance;
-					minDistance = distance;
-					minDistanceInd = otherFeatureInd;
-				}
-				else
-				{
-					if(distance<secondMinDistance)
-					{
-						secondMinDistance = distance;
-					}
-				}
-			}	// end for otherFeatureInd
+			// Find the two nearest descriptors contained in otherFeatureList and the relative distances between f
+			minDistanceInd = DescriptorKernel<NBYTES>::nearest(features + featureInd*nDescLength, otherFeatureList.features, otherFeatureList.nDescLength,
+					otherFeatureList.numFeatures, matched_bytes, &scratch.distances[0], minDistance, secondMinDistance);
 
 			// If the ratio test is passed the indices of the features are saved
 			if ((minDistance <= ratioThreshold*secondMinDistance) && (secondMinDistance > 0))
@@ -1094,6 +1144,7 @@ int CompressedFeatureList::matchDescriptors_oneWay(PointPairs &pairs, const Comp
 				match.otherFeatureInd = minDistanceInd;
 				match.weight = std::cos(HALF_PI * std::sqrt((double)minDistance/(double)secondMinDistance));
 				matches.push_back(match);
+				matchedWeight += match.weight;
 			}
 		}	// end for featureInd
 
@@ -1125,14 +1176,34 @@ int CompressedFeatureList::matchDescriptors_oneWay(PointPairs &pairs, const Comp
 
 
 int CompressedFeatureList::matchDescriptors_twoWay(PointPairs &pairs, const CompressedFeatureList &otherFeatureList, float ratioThreshold) const
+{
+	MatchScratch scratch;
+	return matchDescriptors_twoWay(pairs, otherFeatureList, ratioThreshold, scratch);
+}
+
+
+int CompressedFeatureList::matchDescriptors_twoWay(PointPairs &pairs, const CompressedFeatureList &otherFeatureList, float ratioThreshold, MatchScratch & scratch, double minWeight) const
+{
+	// Check sizes of the descriptors, and select the matcher specialized for their length.
+	int matched_bytes = std::min(nDescLength, otherFeatureList.nDescLength);
+
+	switch (matched_bytes)
+	{
+		case 5:		return matchTwoWay<5>(pairs, otherFeatureList, ratioThreshold, scratch, minWeight, matched_bytes);
+		case 10:	return matchTwoWay<10>(pairs, otherFeatureList, ratioThreshold, scratch, minWeight, matched_bytes);
+		case 16:	return matchTwoWay<16>(pairs, otherFeatureList, ratioThreshold, scratch, minWeight, matched_bytes);
+		case 20:	return matchTwoWay<20>(pairs, otherFeatureList, ratioThreshold, scratch, minWeight, matched_bytes);
+		case 32:	return matchTwoWay<32>(pairs, otherFeatureList, ratioThreshold, scratch, minWeight, matched_bytes);
+		default:	return matchTwoWay<0>(pairs, otherFeatureList, ratioThreshold, scratch, minWeight, matched_bytes);
+	}
+}
+
+
+template<int NBYTES>
+int CompressedFeatureList::matchTwoWay(PointPairs &pairs, const CompressedFeatureList &otherFeatureList, float ratioThreshold, MatchScratch & scratch, double minWeight, int matched_bytes) const
 {
 	pairs.nMatched = 0;
-	std::vector<Match> matches;
-	Match match;
-	std::vector<Match> matches1;
-	std::vector<Match> matches1clean;
-	std::vector<Match> matches2;
-	std::vector<Match> matches2clean;
+	scratch.abandoned = false;
 
 	if(numFeatures>1 && otherFeatureList.numFeatures>1)
 	{
@@ -1142,162 +1213,161 @@ int CompressedFeatureList::matchDescriptors_twoWay(PointPairs &pairs, const Comp
 		// This requires to raise ratioThreshold to a power of two
 		ratioThreshold *= ratioThreshold;
 
-		int distance;
+		const int otherFeatures = otherFeatureList.numFeatures;
+		const int tileRows = MatchScratch::TILE_ROWS;
 		int minDistance, secondMinDistance;
 		int minDistanceInd;
+		Match match;
 
-		int** distanceMatrix = new int*[numFeatures];
-		if (distanceMatrix != NULL)
-		{
-			for (unsigned int i=0; i < numFeatures; i++)
-				distanceMatrix[i] = new int[otherFeatureList.numFeatures];
-		}
-
-		std::vector<int> featureMatches;
-
-		// Check sizes of the descriptors.
-		int matched_bytes = std::min(nDescLength, otherFeatureList.nDescLength);
+		// prepare the working memory (no allocation if the buffers are already large enough)
+		scratch.distances.resize(tileRows * otherFeatures);
+		scratch.minDistance.assign(otherFeatures, 65536);
+		scratch.secondMinDistance.assign(otherFeatures, 65536);
+		scratch.minDistanceInd.assign(otherFeatures, 0);
+		scratch.matches1.clear();
+		scratch.matches2.clear();
+		scratch.matches1clean.clear();
+		scratch.matches2clean.clear();
 
-		// Select the two nearest descriptors
+		// Select the two nearest descriptors in both directions, processing the distance matrix one tile of rows at a time
 
-		for(int featureInd = 0; featureInd < numFeatures; ++featureInd)
+		for (int tileStart = 0; tileStart < numFeatures; tileStart += tileRows)
 		{
-			// Find the two nearest descriptors contained in otherFeatureList and the relative distances between f
-			minDistance = 65536;
-			secondMinDistance = 65536;
-			minDistanceInd = 0;
+			int tileEnd = std::min(tileStart + tileRows, numFeatures);
 
-			for(int otherFeatureInd = 0; otherFeatureInd < otherFeatureList.numFeatures; ++otherFeatureInd)
+			// The final weight is at most twice the number of intersection matches (every weight is <= 1, and the disjoint
+			// matches are rescaled to weigh at most as many as the intersection ones), which cannot exceed the forward matches:
+			// stop if even matching all the remaining features cannot reach minWeight
+			if (minWeight > 0)
 			{
-				distance = getDistance(features + featureInd*nDescLength, otherFeatureList.features + otherFeatureInd*otherFeatureList.nDescLength, matched_bytes);
-				distanceMatrix[featureInd][otherFeatureInd] = distance;
+				int maxForward = std::min((int) scratch.matches1.size() + numFeatures - tileStart, otherFeatures);
+				if (2.0 * maxForward < minWeight)
+				{
+					scratch.abandoned = true;
+					return 0;
+				}
+			}
+
+			for(int featureInd = tileStart; featureInd < tileEnd; ++featureInd)
+			{
+				// Find the two nearest descriptors contained in otherFeatureList and the relative distances between f
+				minDistanceInd = DescriptorKernel<NBYTES>::nearest(features + featureInd*nDescLength, otherFeatureList.features, otherFeatureList.nDescLength,
+						otherFeatures, matched_bytes, &scratch.distances[(featureInd - tileStart) * otherFeatures], minDistance, secondMinDistance);
 
-				if(distance<minDistance)
+				// If the ratio test is passed the indices of the features are saved
+				if ((minDistance <= ratioThreshold*secondMinDistance) && (secondMinDistance>0))
 				{
-					secondMinDistance = minDistance;
-					minDistance = distance;
-					minDistanceInd = otherFeatureInd;
+					match.featureInd = featureInd;
+					match.otherFeatureInd = minDistanceInd;
+					match.weight = std::cos(HALF_PI * std::sqrt((float)minDistance/((float)secondMinDistance)));
+					scratch.matches1.push_back(match);
 				}
-				else
+			}	// end for featureInd
+
+			// Update the two nearest descriptors of each descriptor contained in otherFeatureList (rows are visited in ascending order)
+			for (int otherFeatureInd = 0; otherFeatureInd < otherFeatures; ++otherFeatureInd)
+			{
+				minDistance = scratch.minDistance[otherFeatureInd];
+				secondMinDistance = scratch.secondMinDistance[otherFeatureInd];
+				minDistanceInd = scratch.minDistanceInd[otherFeatureInd];
+
+				const int * column = &scratch.distances[otherFeatureInd];
+				for(int featureInd = tileStart; featureInd < tileEnd; ++featureInd, column += otherFeatures)
 				{
-					if(distance<secondMinDistance)
+					int distance = *column;
+
+					if(distance<minDistance)
 					{
-						secondMinDistance = distance;
+						secondMinDistance = minDistance;
+						minDistance = distance;
+						minDistanceInd = featureInd;
 					}
-				}
+					else
+					{
+						if(distance<secondMinDistance)
+						{
+							secondMinDistance = distance;
+						}
+					}
+				}	// end for featureInd
+
+				scratch.minDistance[otherFeatureInd] = minDistance;
+				scratch.secondMinDistance[otherFeatureInd] = secondMinDistance;
+				scratch.minDistanceInd[otherFeatureInd] = minDistanceInd;
 			}	// end for otherFeatureInd
+		}	// end for tileStart
+
+		for (int otherFeatureInd = 0; otherFeatureInd < otherFeatures; ++otherFeatureInd)
+		{
+			minDistance = scratch.minDistance[otherFeatureInd];
+			secondMinDistance = scratch.secondMinDistance[otherFeatureInd];
 
 			// If the ratio test is passed the indices of the features are saved
-			if ((minDistance <= ratioThreshold*secondMinDistance) && (secondMinDistance>0))
+			if ((minDistance < ratioThreshold*secondMinDistance) && (secondMinDistance > 0))
 			{
-				match.featureInd = featureInd;
-				match.otherFeatureInd = minDistanceInd;
+				match.featureInd = scratch.minDistanceInd[otherFeatureInd];
+				match.otherFeatureInd = otherFeatureInd;
 				match.weight = std::cos(HALF_PI * std::sqrt((float)minDistance/((float)secondMinDistance)));
-				matches1.push_back(match);
+				scratch.matches2.push_back(match);
 			}
-		}	// end for featureind
+		}	// end for otherFeatureInd
 
 		// Creation of a list on biunique matchings deleting possible repetitions in otherFeatureInd
-		if(matches1.size()>0)
+		if(scratch.matches1.size()>0)
 		{
 			// Ordering matches in accordance to otherFeatureInd
-			std::sort(matches1.begin(), matches1.end(), Match::sortMatchByWeight);
+			std::sort(scratch.matches1.begin(), scratch.matches1.end(), Match::sortMatchByWeight);
 			int lastFeatureIndex = -1;
 
 			// Look for repetitions
-			for(std::vector<Match>::const_iterator m=matches1.begin(); m<matches1.end(); ++m)
+			for(std::vector<Match>::const_iterator m=scratch.matches1.begin(); m<scratch.matches1.end(); ++m)
 			{
 				if(lastFeatureIndex != m->otherFeatureInd)
 				{
 					lastFeatureIndex = m->otherFeatureInd;
-					Match tempMatch;
-					tempMatch.featureInd = m->featureInd;
-					tempMatch.otherFeatureInd = m->otherFeatureInd;
-					tempMatch.weight = m->weight;
-					matches1clean.push_back(tempMatch);
+					scratch.matches1clean.push_back(*m);
 				}
 			}
 		}
-		matches1.clear();
-
-		// Select the two nearest descriptors
-
-		for (int otherFeatureInd = 0; otherFeatureInd < otherFeatureList.numFeatures; ++otherFeatureInd)
-		{
-			// Find the two nearest descriptors contained in otherFeatureList and the relative distances between f
-			minDistance = 65536;
-			secondMinDistance = 65536;
-			minDistanceInd = 0;
-
-			for(int featureInd = 0; featureInd < numFeatures; ++featureInd)
-			{
-				distance = distanceMatrix[featureInd][otherFeatureInd];
-
-				if(distance<minDistance)
-				{
-					secondMinDistance = minDistance;
-					minDistance = distance;
-					minDistanceInd = featureInd;
-				}
-				else
-				{
-					if(distance<secondMinDistance)
-					{
-						secondMinDistance = distance;
-					}
-				}
-			}	// end for featureInd
-
-			// If the ratio test is passed the indices of the features are saved
-			if ((minDistance < ratioThreshold*secondMinDistance) && (secondMinDistance > 0))
-			{
-				match.featureInd = minDistanceInd;
-				match.otherFeatureInd = otherFeatureInd;
-				match.weight = std::cos(HALF_PI * std::sqrt((float)minDistance/((float)secondMinDistance)));
-				matches2.push_back(match);
-			}
-		}	// end for otherFeatureInd
 
 		// Creations of a list on biunique matchings deleting possible repetitions in otherFeatureInd
-		if(matches2.size()>0)
+		if(scratch.matches2.size()>0)
 		{
 			// Ordering matches in accordance to otherFeatureInd
-			std::sort(matches2.begin(), matches2.end(), Match::sortMatchByWeight);
+			std::sort(scratch.matches2.begin(), scratch.matches2.end(), Match::sortMatchByWeight);
 			int lastFeatureIndex = -1;
 
 			// Look for repetitions
-			for(std::vector<Match>::const_iterator m=matches2.begin(); m<matches2.end(); ++m)
+			for(std::vector<Match>::const_iterator m=scratch.matches2.begin(); m<scratch.matches2.end(); ++m)
 			{
 				if(lastFeatureIndex != m->featureInd)
 				{
 					lastFeatureIndex = m->featureInd;
-					Match tempMatch;
-					tempMatch.featureInd = m->featureInd;
-					tempMatch.otherFeatureInd = m->otherFeatureInd;
-					tempMatch.weight = m->weight;
-					matches2clean.push_back(tempMatch);
+					scratch.matches2clean.push_back(*m);
 				}
 			}
 		}
-		matches2.clear();
 
-		for(std::vector<Match>::iterator m1 = matches1clean.begin(); m1 < matches1clean.end(); ++m1)
+		// Both clean lists contain at most one match per otherFeatureInd: index them to find the intersection
+		scratch.forwardIndex.assign(otherFeatures, -1);
+		scratch.reverseIndex.assign(otherFeatures, -1);
+		for (int k = 0; k < (int) scratch.matches1clean.size(); ++k)
+			scratch.forwardIndex[scratch.matches1clean[k].otherFeatureInd] = k;
+		for (int k = 0; k < (int) scratch.matches2clean.size(); ++k)
+			scratch.reverseIndex[scratch.matches2clean[k].otherFeatureInd] = k;
+
+		for(std::vector<Match>::const_iterator m1 = scratch.matches1clean.begin(); m1 < scratch.matches1clean.end(); ++m1)
 		{
-			int flag=0;
-			for(std::vector<Match>::iterator m2 = matches2clean.begin(); m2 < matches2clean.end(); ++m2)
+			int k = scratch.reverseIndex[m1->otherFeatureInd];
+			if((k >= 0) && (scratch.matches2clean[k].featureInd == m1->featureInd))
 			{
-				if(m1->featureInd == m2->featureInd && m1->otherFeatureInd == m2->otherFeatureInd)
-				{
-					pairs.addPair(Xcoord[m1->featureInd],
-						Ycoord[m1->featureInd],
-						otherFeatureList.Xcoord[m1->otherFeatureInd],
-						otherFeatureList.Ycoord[m1->otherFeatureInd],
-						(m1->weight+m2->weight)*0.5, match_2way_INTERSECTION);
-					flag=1;
-					break;
-				}
+				pairs.addPair(Xcoord[m1->featureInd],
+					Ycoord[m1->featureInd],
+					otherFeatureList.Xcoord[m1->otherFeatureInd],
+					otherFeatureList.Ycoord[m1->otherFeatureInd],
+					(m1->weight+scratch.matches2clean[k].weight)*0.5, match_2way_INTERSECTION);
 			}
-			if(flag==0)
+			else
 			{
 				pairs.addPair(Xcoord[m1->featureInd],
 					Ycoord[m1->featureInd],
@@ -1307,14 +1377,10 @@ int CompressedFeatureList::matchDescriptors_twoWay(PointPairs &pairs, const Comp
 			}
 		}
 
-		for(std::vector<Match>::iterator m2 = matches2clean.begin(); m2 < matches2clean.end(); ++m2)
+		for(std::vector<Match>::const_iterator m2 = scratch.matches2clean.begin(); m2 < scratch.matches2clean.end(); ++m2)
 		{
-			int flag=0;
-			for(std::vector<Match>::iterator m1 = matches1clean.begin(); m1 < matches1clean.end(); ++m1)
-			{
-				if(m1->featureInd == m2->featureInd && m1->otherFeatureInd == m2->otherFeatureInd){flag=1;break;}
-			}
-			if(flag==0)
+			int k = scratch.forwardIndex[m2->otherFeatureInd];
+			if((k < 0) || (scratch.matches1clean[k].featureInd != m2->featureInd))
 			{
 				pairs.addPair(Xcoord[m2->featureInd],
 					Ycoord[m2->featureInd],
@@ -1343,119 +1409,12 @@ int CompressedFeatureList::matchDescriptors_twoWay(PointPairs &pairs, const Comp
 					pairs.weights[i] *= disjoin_weigh;
 			}
 		}
-
-		if (distanceMatrix != NULL)
-		{
-			for (unsigned int i=0; i<numFeatures; i++)
-				if (distanceMatrix[i] != NULL) delete [] distanceMatrix[i];
-			delete [] distanceMatrix;
-		}
 	}
 	return pairs.nMatched;
 
 }
 
-/* Macro for enabling compiler-specific builtins, with default fallback */
-
-#if defined(_MSC_VER) && defined(USE_POPCNT)
-	#define POPCNT8(v) (__popcnt16((unsigned short) (v)))
-	#define POPCNT16(v) (__popcnt16(v))
-	#define POPCNT32(v) (__popcnt(v))
-	#define POPCNT64(v) (__popcnt64(v))
-#elif defined(__GNUC__) || defined(__GNUG__)
-	#define POPCNT8(v)  (__builtin_popcount((unsigned int) (v)))
-	#define POPCNT16(v) (__builtin_popcount((unsigned int) (v)))
-	#define POPCNT32(v) (__builtin_popcount(v))
-	#define POPCNT64(v) (__builtin_popcountll(v))
-#else
-
-// global lookup table used in POPCOUNT8
-static const int costTable[256] =
+int CompressedFeatureList::getDistance(const unsigned char * mine, const unsigned char * other, int nbytes)
 {
-  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
-  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
-  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
-  4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8
-};
-
-	#define POPCNT8(v) (costTable[(v)])
-#endif
-
-
-
-#ifdef POPCNT64
-inline int CompressedFeatureList::getDistance(const unsigned char * mine, const unsigned char * other, int nbytes)
-{
-	switch (nbytes)
-	{
-		case 5:
-		{
-			const unsigned int * mine32 = (unsigned int *) mine;
-			const unsigned int * other32 = (unsigned int *) other;
-			return POPCNT32(mine32[0] ^ other32[0]) + POPCNT8(mine[4] ^ other[4]);
-		}
-		case 10:
-		{
-			const unsigned long long * mine64 = (unsigned long long *) mine;
-			const unsigned long long * other64 = (unsigned long long *) other;
-			const unsigned short * mine16 = (unsigned short *) (mine + 8);
-			const unsigned short * other16 = (unsigned short *) (other + 8);
-			return POPCNT64(mine64[0] ^ other64[0]) + POPCNT16(mine16[0] ^ other16[0]);
-		}
-		case 16:
-		{
-			const unsigned long long * mine64 = (unsigned long long *) mine;
-			const unsigned long long * other64 = (unsigned long long *) other;
-			return POPCNT64(mine64[0] ^ other64[0]) + POPCNT64(mine64[1] ^ other64[1]);
-		}
-		case 20:
-		{
-			const unsigned long long * mine64 = (unsigned long long *) mine;
-			const unsigned long long * other64 = (unsigned long long *) other;
-			const unsigned int * mine32 = (unsigned int *) (mine + 16);
-			const unsigned int * other32 = (unsigned int *) (other + 16);
-			return POPCNT64(mine64[0] ^ other64[0]) + POPCNT64(mine64[1] ^ other64[1]) + POPCNT32(mine32[0] ^ other32[0]);
-		}
-		case 32:
-		{
-			const unsigned long long * mine64 = (unsigned long long *) mine;
-			const unsigned long long * other64 = (unsigned long long *) other;
-			return POPCNT64(mine64[0] ^ other64[0])
-				 + POPCNT64(mine64[1] ^ other64[1])
-				 + POPCNT64(mine64[2] ^ other64[2])
-				 + POPCNT64(mine64[3] ^ other64[3]);
-		}
-		default:	// just to allow experimenting with different values of the "numberOfElementGroups" parameter
-		{
-			int distance = 0;
-			for (int i=0; i<nbytes; ++i)
-			{
-				distance += POPCNT8(mine[i] ^ other[i]);
-			}
-			return distance;
-		}
-	}
+	return HammingKernel::distance(mine, other, nbytes);
 }
-#else
-inline int CompressedFeatureList::getDistance(const unsigned char * mine, const unsigned char * other, int nbytes)
-{
-	int distance = 0;
-	for (int i=0; i<nbytes; ++i)
-	{
-		distance += POPCNT8(mine[i] ^ other[i]);
-	}
-	return distance;
-}
-#endif
@@ -37,6 +37,7 @@
 #include "Parameters.h"
 #include "Feature.h"
 #include "PointPairs.h"
+#include "Match.h"
 #include "BitOutputStream.h"
 #include "BitInputStream.h"
 
@@ -234,6 +235,33 @@ private:
 };
 
 
+/**
+ * @class MatchScratch
+ * Reusable working memory of the matching of CompressedFeatureList.
+ * The buffers never shrink, so an instance reused across calls (e.g. one per thread in retrieval)
+ * avoids any heap allocation once it has grown to the size of the largest feature lists.
+ */
+class MatchScratch
+{
+public:
+	static const int TILE_ROWS = 16;		///< number of features whose distances are computed in the same tile
+
+	MatchScratch():abandoned(false) {}
+
+	bool abandoned;							///< true if the last matching was abandoned because it could not reach the requested minimum weight
+
+	std::vector<int> distances;				///< distances of TILE_ROWS features from all the other features
+	std::vector<int> minDistance;			///< distance of the nearest feature of each other feature
+	std::vector<int> secondMinDistance;		///< distance of the second nearest feature of each other feature
+	std::vector<int> minDistanceInd;		///< index of the nearest feature of each other feature
+	std::vector<int> forwardIndex;			///< position in matches1 of the forward match of each other feature (or -1)
+	std::vector<int> reverseIndex;			///< position in matches2 of the reverse match of each other feature (or -1)
+	std::vector<Match> matches1;			///< forward matches
+	std::vector<Match> matches2;			///< reverse matches
+	std::vector<Match> matches1clean;		///< forward matches without repetitions
+	std::vector<Match> matches2clean;		///< reverse matches without repetitions
+};
+
 /**
  * @class CompressedFeatureList
  * Container class for all compressed features of an image.
@@ -246,9 +274,25 @@ private:
 	void allocate(int nFeatures, int descLen);
 	void clear();
 
+	/**
+	 * One way matching specialized for descriptors of NBYTES bytes (NBYTES = 0: any length, given by matchedBytes).
+	 * See matchDescriptors_oneWay(pairs, otherList, ratioThreshold, scratch, minWeight).
+	 */
+	template<int NBYTES> int matchOneWay(PointPairs &pairs, const CompressedFeatureList &otherList, float ratioThreshold, MatchScratch & scratch,
+			double minWeight, int matchedBytes) const;
+
+	/**
+	 * Two way matching specialized for descriptors of NBYTES bytes (NBYTES = 0: any length, given by matchedBytes).
+	 * See matchDescriptors_twoWay(pairs, otherList, ratioThreshold, scratch, minWeight).
+	 */
+	template<int NBYTES> int matchTwoWay(PointPairs &pairs, const CompressedFeatureList &otherList, float ratioThreshold, MatchScratch & scratch,
+			double minWeight, int matchedBytes) const;
+
 protected:
 	int numFeatures;					///< number of features of this image
 	int nDescLength;					///< descriptor length in bytes.
+	int featureCapacity;				///< number of coordinates that the allocated buffers can hold
+	int byteCapacity;					///< number of descriptor bytes that the allocated buffer can hold
 
 public:
 	unsigned short *Ycoord;				  	///< the X coordinate of the ALP keypoint
@@ -287,6 +331,14 @@ public:
 	 */
 	void swap(CompressedFeatureList & other);
 
+	/**
+	 * Replace the content of this instance with the features of a FeatureList, optionally including relevance sorting.
+	 * The buffers are reallocated only if they are too small, so an instance reused across calls stops allocating memory.
+	 * @param other the FeatureList instance to copy
+	 * @param relevantOnly if true, only the features having the highest relevance are copied
+	 */
+	void assign(const FeatureList & other, bool relevantOnly = false);
+
 	/**
 	 * Get the number of features
 	 */
@@ -318,6 +370,20 @@ public:
 	 */
 	int matchDescriptors_oneWay(PointPairs &pairs, const CompressedFeatureList &otherList, float ratioThreshold) const;
 
+	/**
+	 * Match the features of the current list with the ones contained in otherList in a one way fashion, using the given working memory.
+	 * If minWeight is greater than zero, the matching is abandoned (scratch.abandoned is set and no pairs are returned)
+	 * as soon as the total weight of the pairs is proven to be lower than minWeight; otherwise the result is identical
+	 * to matchDescriptors_oneWay(pairs, otherList, ratioThreshold).
+	 * @param pairs computed matching pairs of points
+	 * @param otherList the other list.
+	 * @param ratioThreshold the threshold used in the ratio test.
+	 * @param scratch reusable working memory.
+	 * @param minWeight the minimum total weight of interest (0 = never abandon).
+	 * @return the number of matched features.
+	 */
+	int matchDescriptors_oneWay(PointPairs &pairs, const CompressedFeatureList &otherList, float ratioThreshold, MatchScratch & scratch, double minWeight = 0.0) const;
+
 	/**
 	 * Match the features of the current list with the ones contained in otherList in a two way fashion.
 	 * The coordinates of the matching points are stored in the pairs parameter.
@@ -328,6 +394,21 @@ public:
 	 */
 	int matchDescriptors_twoWay(PointPairs &pairs, const CompressedFeatureList &otherList, float ratioThreshold) const;
 
+	/**
+	 * Match the features of the current list with the ones contained in otherList in a two way fashion, using the given working memory.
+	 * Forward and reverse nearest features are computed in a single pass over tiles of the distance matrix.
+	 * If minWeight is greater than zero, the matching is abandoned (scratch.abandoned is set and no pairs are returned)
+	 * as soon as the total weight of the pairs is proven to be lower than minWeight; otherwise the result is identical
+	 * to matchDescriptors_twoWay(pairs, otherList, ratioThreshold).
+	 * @param pairs computed matching pairs of points
+	 * @param otherList the other list.
+	 * @param ratioThreshold the threshold used in the ratio test.
+	 * @param scratch reusable working memory.
+	 * @param minWeight the minimum total weight of interest (0 = never abandon).
+	 * @return the number of matched features.
+	 */
+	int matchDescriptors_twoWay(PointPairs &pairs, const CompressedFeatureList &otherList, float ratioThreshold, MatchScratch & scratch, double minWeight = 0.0) const;
+
 	/**
 	 * Get the distance of one feature from another feature.
 	 * @param mine my feature
@@ -0,0 +1,248 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Joint Open Lab VISIBLE (Telecom Italia)
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include "HammingKernel.h"
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define HAMMING_KERNEL_X86		// AVX2 and AVX-512 kernels are compiled with function-specific target attributes
+	#include <immintrin.h>
+#endif
+
+using namespace mpeg7cdvs;
+
+static int bestSupportedImplementation()
+{
+#ifdef HAMMING_KERNEL_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq"))
+		return HammingKernel::AVX512;
+	if (__builtin_cpu_supports("avx2"))
+		return HammingKernel::AVX2;
+#endif
+	return HammingKernel::SCALAR;
+}
+
+int HammingKernel::implementation = bestSupportedImplementation();
+
+int HammingKernel::getImplementation()
+{
+	return implementation;
+}
+
+int HammingKernel::setImplementation(int level)
+{
+	implementation = std::min(std::max(level, (int) SCALAR), bestSupportedImplementation());
+	return implementation;
+}
+
+/**
+ * Distance of two descriptors: NBYTES is the descriptor length if known at compile time, otherwise 0 and nbytes is used.
+ */
+template<int NBYTES>
+static inline int kernelDistance(const unsigned char * mine, const unsigned char * other, int nbytes)
+{
+	return (NBYTES > 0) ? HammingKernel::distance<NBYTES>(mine, other) : HammingKernel::distance(mine, other, nbytes);
+}
+
+template<int NBYTES>
+static void distances_scalar(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int nbytes, int * distances)
+{
+	for (int i = 0; i < nRefs; ++i)
+		distances[i] = kernelDistance<NBYTES>(query, refs + i*stride, nbytes);
+}
+
+#ifdef HAMMING_KERNEL_X86
+
+/*
+ * The SIMD kernels put each descriptor in a 64-bit lane, one 64-bit word at a time.
+ * The bytes of the last word beyond nbytes belong to the next descriptor (or to padding) and are masked out;
+ * the descriptors whose last word would be read beyond the end of the block are processed by the scalar code.
+ */
+
+static inline unsigned long long load64(const unsigned char * p)
+{
+	unsigned long long v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+/**
+ * Get the number of reference descriptors that can be safely read using whole 64-bit words.
+ */
+static inline int safeRefs(int stride, int nRefs, int words)
+{
+	long long total = (long long) nRefs * stride;
+	if (total < words * 8)
+		return 0;
+	return (int) ((total - words * 8) / stride) + 1;
+}
+
+template<int WORDS, int NBYTES>
+__attribute__((target("avx2")))
+static void distances_avx2(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int nbytes, int * distances)
+{
+	if (NBYTES > 0)
+		nbytes = NBYTES;
+	unsigned long long q[4] = {0, 0, 0, 0};
+	memcpy(q, query, nbytes);
+	const unsigned long long lastMask = (nbytes % 8 == 0) ? ~0ULL : ((1ULL << (8 * (nbytes % 8))) - 1);
+
+	const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+											0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i lowNibble = _mm256_set1_epi8(0x0f);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i mask = _mm256_set1_epi64x((long long) lastMask);
+	__m256i qv[WORDS];
+	for (int w = 0; w < WORDS; ++w)
+		qv[w] = _mm256_set1_epi64x((long long) q[w]);
+
+	const int nSafe = safeRefs(stride, nRefs, WORDS);
+	int i = 0;
+	for (; i + 4 <= nSafe; i += 4)
+	{
+		const unsigned char * r = refs + i*stride;
+		__m256i count = zero;
+		for (int w = 0; w < WORDS; ++w)
+		{
+			__m256i x = _mm256_set_epi64x((long long) load64(r + 3*stride + 8*w), (long long) load64(r + 2*stride + 8*w),
+										  (long long) load64(r + stride + 8*w), (long long) load64(r + 8*w));
+			x = _mm256_xor_si256(x, qv[w]);
+			if (w == WORDS - 1)
+				x = _mm256_and_si256(x, mask);
+			__m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(x, lowNibble));
+			__m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(x, 4), lowNibble));
+			count = _mm256_add_epi8(count, _mm256_add_epi8(lo, hi));		// at most 32 per byte
+		}
+		__m256i sums = _mm256_sad_epu8(count, zero);			// one sum per 64-bit lane
+		__m128i packed = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(sums, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+		_mm_storeu_si128((__m128i *) (distances + i), packed);
+	}
+
+	for (; i < nRefs; ++i)
+		distances[i] = kernelDistance<NBYTES>(query, refs + i*stride, nbytes);
+}
+
+template<int WORDS, int NBYTES>
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static void distances_avx512(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int nbytes, int * distances)
+{
+	if (NBYTES > 0)
+		nbytes = NBYTES;
+	unsigned long long q[4] = {0, 0, 0, 0};
+	memcpy(q, query, nbytes);
+	const unsigned long long lastMask = (nbytes % 8 == 0) ? ~0ULL : ((1ULL << (8 * (nbytes % 8))) - 1);
+
+	const __m512i mask = _mm512_set1_epi64((long long) lastMask);
+	__m512i qv[WORDS];
+	for (int w = 0; w < WORDS; ++w)
+		qv[w] = _mm512_set1_epi64((long long) q[w]);
+
+	const int nSafe = safeRefs(stride, nRefs, WORDS);
+	int i = 0;
+	for (; i + 8 <= nSafe; i += 8)
+	{
+		const unsigned char * r = refs + i*stride;
+		__m512i count = _mm512_setzero_si512();
+		for (int w = 0; w < WORDS; ++w)
+		{
+			__m512i x = _mm512_set_epi64((long long) load64(r + 7*stride + 8*w), (long long) load64(r + 6*stride + 8*w),
+										 (long long) load64(r + 5*stride + 8*w), (long long) load64(r + 4*stride + 8*w),
+										 (long long) load64(r + 3*stride + 8*w), (long long) load64(r + 2*stride + 8*w),
+										 (long long) load64(r + stride + 8*w), (long long) load64(r + 8*w));
+			x = _mm512_xor_si512(x, qv[w]);
+			if (w == WORDS - 1)
+				x = _mm512_and_si512(x, mask);
+			count = _mm512_add_epi64(count, _mm512_popcnt_epi64(x));
+		}
+		_mm256_storeu_si256((__m256i *) (distances + i), _mm512_maskz_cvtepi64_epi32(0xFF, count));	// the unmasked form reads an undefined source
+	}
+
+	for (; i < nRefs; ++i)
+		distances[i] = kernelDistance<NBYTES>(query, refs + i*stride, nbytes);
+}
+
+#endif	// HAMMING_KERNEL_X86
+
+void HammingKernel::distances(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int nbytes, int * distances)
+{
+#ifdef HAMMING_KERNEL_X86
+	if (implementation == AVX512)
+	{
+		switch ((nbytes + 7) / 8)
+		{
+			case 1: distances_avx512<1, 0>(query, refs, stride, nRefs, nbytes, distances); return;
+			case 2: distances_avx512<2, 0>(query, refs, stride, nRefs, nbytes, distances); return;
+			case 3: distances_avx512<3, 0>(query, refs, stride, nRefs, nbytes, distances); return;
+			case 4: distances_avx512<4, 0>(query, refs, stride, nRefs, nbytes, distances); return;
+			default: break;		// longer descriptors use the scalar code
+		}
+	}
+	else if (implementation == AVX2)
+	{
+		switch ((nbytes + 7) / 8)
+		{
+			case 1: distances_avx2<1, 0>(query, refs, stride, nRefs, nbytes, distances); return;
+			case 2: distances_avx2<2, 0>(query, refs, stride, nRefs, nbytes, distances); return;
+			case 3: distances_avx2<3, 0>(query, refs, stride, nRefs, nbytes, distances); return;
+			case 4: distances_avx2<4, 0>(query, refs, stride, nRefs, nbytes, distances); return;
+			default: break;		// longer descriptors use the scalar code
+		}
+	}
+#endif
+	distances_scalar<0>(query, refs, stride, nRefs, nbytes, distances);
+}
+
+template<int NBYTES>
+void HammingKernel::distances(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int * distances)
+{
+#ifdef HAMMING_KERNEL_X86
+	if (implementation == AVX512)
+	{
+		distances_avx512<(NBYTES + 7) / 8, NBYTES>(query, refs, stride, nRefs, NBYTES, distances);
+		return;
+	}
+	else if (implementation == AVX2)
+	{
+		distances_avx2<(NBYTES + 7) / 8, NBYTES>(query, refs, stride, nRefs, NBYTES, distances);
+		return;
+	}
+#endif
+	distances_scalar<NBYTES>(query, refs, stride, nRefs, NBYTES, distances);
+}
+
+// the descriptor lengths produced by the CDVS modes (numberOfElementGroups)
+template void HammingKernel::distances<5>(const unsigned char *, const unsigned char *, int, int, int *);
+template void HammingKernel::distances<10>(const unsigned char *, const unsigned char *, int, int, int *);
+template void HammingKernel::distances<16>(const unsigned char *, const unsigned char *, int, int, int *);
+template void HammingKernel::distances<20>(const unsigned char *, const unsigned char *, int, int, int *);
+template void HammingKernel::distances<32>(const unsigned char *, const unsigned char *, int, int, int *);
@@ -0,0 +1,300 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Joint Open Lab VISIBLE (Telecom Italia)
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#pragma once
+
+#include <cstring>
+
+/* Macro for enabling compiler-specific builtins, with default fallback */
+
+#if defined(_MSC_VER) && defined(USE_POPCNT)
+	#include <intrin.h>
+	#define POPCNT8(v) (__popcnt16((unsigned short) (v)))
+	#define POPCNT16(v) (__popcnt16(v))
+	#define POPCNT32(v) (__popcnt(v))
+	#define POPCNT64(v) (__popcnt64(v))
+#elif defined(__GNUC__) || defined(__GNUG__)
+	#define POPCNT8(v)  (__builtin_popcount((unsigned int) (v)))
+	#define POPCNT16(v) (__builtin_popcount((unsigned int) (v)))
+	#define POPCNT32(v) (__builtin_popcount(v))
+	#define POPCNT64(v) (__builtin_popcountll(v))
+#else
+
+// global lookup table used in POPCOUNT8
+static const int costTable[256] =
+{
+  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+  4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8
+};
+
+	#define POPCNT8(v) (costTable[(v)])
+#endif
+
+namespace mpeg7cdvs
+{
+
+/**
+ * @class HammingKernel
+ * Hamming distance kernels used to compare compressed local descriptors.
+ * The batched kernels compare one descriptor with a block of descriptors; they are implemented
+ * using AVX-512 VPOPCNTQ, AVX2 (nibble lookup with pshufb) or scalar popcount, and the fastest
+ * implementation supported by the CPU is selected at run time.
+ * All implementations produce exactly the same distances.
+ * @date 2016
+ */
+class HammingKernel
+{
+public:
+	enum {
+		SCALAR = 0,		///< scalar popcount
+		AVX2 = 1,		///< AVX2 nibble lookup popcount (4 descriptors per step)
+		AVX512 = 2		///< AVX-512 VPOPCNTQ (8 descriptors per step)
+	};
+
+	/**
+	 * Get the distance of one descriptor from another descriptor.
+	 * @param mine my descriptor
+	 * @param other the other descriptor
+	 * @param nbytes the number of bytes to use as input data
+	 * @return the distance
+	 */
+	static int distance(const unsigned char * mine, const unsigned char * other, int nbytes);
+
+	/**
+	 * Compute the distances of one descriptor from a block of descriptors.
+	 * @param query the query descriptor
+	 * @param refs the first of the reference descriptors
+	 * @param stride the distance in bytes between two consecutive reference descriptors
+	 * @param nRefs the number of reference descriptors
+	 * @param nbytes the number of bytes to compare in each descriptor (not greater than stride)
+	 * @param distances output buffer for nRefs distances
+	 */
+	static void distances(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int nbytes, int * distances);
+
+	/**
+	 * Compute the distances of one descriptor from a block of descriptors, and find the nearest and second nearest ones.
+	 * In case of equal distances, the descriptor having the lowest index is the nearest.
+	 * @param query the query descriptor
+	 * @param refs the first of the reference descriptors
+	 * @param stride the distance in bytes between two consecutive reference descriptors
+	 * @param nRefs the number of reference descriptors
+	 * @param nbytes the number of bytes to compare in each descriptor (not greater than stride)
+	 * @param distances output buffer for nRefs distances
+	 * @param minDistance output: the distance of the nearest descriptor (65536 if nRefs is 0)
+	 * @param secondMinDistance output: the distance of the second nearest descriptor (65536 if nRefs < 2)
+	 * @return the index of the nearest descriptor
+	 */
+	static int nearest(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int nbytes, int * distances,
+			int & minDistance, int & secondMinDistance);
+
+	/**
+	 * Get the distance of one descriptor from another descriptor of NBYTES bytes.
+	 * The length is known at compile time, so the distance is a fixed sequence of word popcounts.
+	 * @param mine my descriptor
+	 * @param other the other descriptor
+	 * @return the distance
+	 */
+	template<int NBYTES> static int distance(const unsigned char * mine, const unsigned char * other);
+
+	/**
+	 * Compute the distances of one descriptor from a block of descriptors of NBYTES bytes.
+	 * Only the descriptor lengths used by the CDVS modes (5, 10, 16, 20 and 32 bytes) are instantiated.
+	 * @param query the query descriptor
+	 * @param refs the first of the reference descriptors
+	 * @param stride the distance in bytes between two consecutive reference descriptors (not less than NBYTES)
+	 * @param nRefs the number of reference descriptors
+	 * @param distances output buffer for nRefs distances
+	 */
+	template<int NBYTES> static void distances(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int * distances);
+
+	/**
+	 * Compute the distances of one descriptor from a block of descriptors of NBYTES bytes, and find the nearest and second nearest ones.
+	 * Same as nearest(query, refs, stride, nRefs, NBYTES, distances, minDistance, secondMinDistance).
+	 * @param query the query descriptor
+	 * @param refs the first of the reference descriptors
+	 * @param stride the distance in bytes between two consecutive reference descriptors (not less than NBYTES)
+	 * @param nRefs the number of reference descriptors
+	 * @param distances output buffer for nRefs distances
+	 * @param minDistance output: the distance of the nearest descriptor (65536 if nRefs is 0)
+	 * @param secondMinDistance output: the distance of the second nearest descriptor (65536 if nRefs < 2)
+	 * @return the index of the nearest descriptor
+	 */
+	template<int NBYTES> static int nearest(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int * distances,
+			int & minDistance, int & secondMinDistance);
+
+	/**
+	 * Get the implementation currently used by the batched kernels.
+	 * @return SCALAR, AVX2 or AVX512
+	 */
+	static int getImplementation();
+
+	/**
+	 * Force the implementation used by the batched kernels (e.g. for testing or benchmarking).
+	 * If the CPU does not support the required implementation, the best supported one is used.
+	 * @param level SCALAR, AVX2 or AVX512
+	 * @return the implementation actually selected
+	 */
+	static int setImplementation(int level);
+
+private:
+	static int implementation;
+};
+
+template<int NBYTES>
+inline int HammingKernel::distance(const unsigned char * mine, const unsigned char * other)
+{
+#ifdef POPCNT64
+	int distance = 0;
+	for (int w = 0; w < NBYTES / 8; ++w)		// constant trip count: completely unrolled
+	{
+		unsigned long long a, b;
+		memcpy(&a, mine + 8*w, 8);
+		memcpy(&b, other + 8*w, 8);
+		distance += POPCNT64(a ^ b);
+	}
+	const int tail = (NBYTES / 8) * 8;		// the remaining bytes are compared 4, 2 and 1 at a time
+	if (NBYTES & 4)
+	{
+		unsigned int a, b;
+		memcpy(&a, mine + tail, 4);
+		memcpy(&b, other + tail, 4);
+		distance += POPCNT32(a ^ b);
+	}
+	if (NBYTES & 2)
+	{
+		unsigned short a, b;
+		memcpy(&a, mine + tail + (NBYTES & 4), 2);
+		memcpy(&b, other + tail + (NBYTES & 4), 2);
+		distance += POPCNT16(a ^ b);
+	}
+	if (NBYTES & 1)
+	{
+		distance += POPCNT8(mine[NBYTES - 1] ^ other[NBYTES - 1]);
+	}
+	return distance;
+#else
+	int distance = 0;
+	for (int i=0; i<NBYTES; ++i)
+	{
+		distance += POPCNT8(mine[i] ^ other[i]);
+	}
+	return distance;
+#endif
+}
+
+inline int HammingKernel::distance(const unsigned char * mine, const unsigned char * other, int nbytes)
+{
+	switch (nbytes)
+	{
+		case 5:		return distance<5>(mine, other);
+		case 10:	return distance<10>(mine, other);
+		case 16:	return distance<16>(mine, other);
+		case 20:	return distance<20>(mine, other);
+		case 32:	return distance<32>(mine, other);
+		default:	// just to allow experimenting with different values of the "numberOfElementGroups" parameter
+		{
+			int distance = 0;
+			for (int i=0; i<nbytes; ++i)
+			{
+				distance += POPCNT8(mine[i] ^ other[i]);
+			}
+			return distance;
+		}
+	}
+}
+
+inline int HammingKernel::nearest(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int nbytes, int * distances,
+		int & minDistance, int & secondMinDistance)
+{
+	HammingKernel::distances(query, refs, stride, nRefs, nbytes, distances);
+
+	int minDistanceInd = 0;
+	minDistance = 65536;
+	secondMinDistance = 65536;
+	for (int i = 0; i < nRefs; ++i)
+	{
+		int distance = distances[i];
+		if (distance < minDistance)
+		{
+			secondMinDistance = minDistance;
+			minDistance = distance;
+			minDistanceInd = i;
+		}
+		else if (distance < secondMinDistance)
+		{
+			secondMinDistance = distance;
+		}
+	}
+	return minDistanceInd;
+}
+
+template<int NBYTES>
+inline int HammingKernel::nearest(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int * distances,
+		int & minDistance, int & secondMinDistance)
+{
+	HammingKernel::distances<NBYTES>(query, refs, stride, nRefs, distances);
+
+	int minDistanceInd = 0;
+	minDistance = 65536;
+	secondMinDistance = 65536;
+	for (int i = 0; i < nRefs; ++i)
+	{
+		int distance = distances[i];
+		if (distance < minDistance)
+		{
+			secondMinDistance = minDistance;
+			minDistance = distance;
+			minDistanceInd = i;
+		}
+		else if (distance < secondMinDistance)
+		{
+			secondMinDistance = distance;
+		}
+	}
+	return minDistanceInd;
+}
+
+}  // end namespace
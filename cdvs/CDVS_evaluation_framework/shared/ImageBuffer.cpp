@@ -36,11 +36,13 @@
 #include <cmath>
 #include <cassert>
 #include <vector>
+#include <cstring>
 #include <algorithm>
 
 // Additional include needed to use the resampler library
 #define STBI_HEADER_FILE_ONLY
 #include "resampler.h"
+#include "Lanczos3Resampler.h"
 #include "stb_image.c"
 
 // exceptions
@@ -77,6 +79,13 @@ void ImageBuffer::read(int ext_width, int ext_height, const unsigned char * ext_
 	buffer.assign(ext_buffer, image_size);				// resize buffer and copy all data
 }
 
+void ImageBuffer::read(int ext_width, int ext_height, const unsigned char * ext_buffer, int ext_originalWidth, int ext_originalHeight)
+{
+	read(ext_width, ext_height, ext_buffer);
+	originalHeight = ext_originalHeight;
+	originalWidth = ext_originalWidth;
+}
+
 
 bool ImageBuffer::resize(int newheight, int newwidth)
 {
@@ -88,9 +97,11 @@ bool ImageBuffer::resize(int newheight, int newwidth)
 
 void ImageBuffer::resample(double rfactor)
 {
-	int resampled_height = (int) (height *  rfactor + 0.5);
-	int resampled_width = (int) (width *  rfactor + 0.5);
+	resample((int) (width *  rfactor + 0.5), (int) (height *  rfactor + 0.5));
+}
 
+void ImageBuffer::resample(int resampled_width, int resampled_height)
+{
 	Buffer resampled(resampled_height * resampled_width);
 	resampleImage(buffer.data() , width, height, 1,
 			resampled.data(), resampled_width, resampled_height, "lanczos3", 0);
@@ -119,11 +130,16 @@ void ImageBuffer::resample(ImageBuffer & dest) const
 
 void ImageBuffer::resampleIfGreater(int maxSize)
 {
-	int maxOriginalSize = (width > height? width : height);
+	int maxOriginalSize = (originalWidth > originalHeight? originalWidth : originalHeight);
 	if (maxOriginalSize > maxSize)
 	{
+		// the original image may have been decoded at a reduced resolution: the new size is computed from the original size
 		double rfactor = (double) maxSize / (double) maxOriginalSize;
-		resample(rfactor);	// resample image
+		int resampled_width = (int) (originalWidth * rfactor + 0.5);
+		int resampled_height = (int) (originalHeight * rfactor + 0.5);
+
+		if ((resampled_width != width) || (resampled_height != height))
+			resample(resampled_width, resampled_height);	// resample image
 	}
 }
 
@@ -160,6 +176,14 @@ void ImageBuffer::resampleImage(
 	   throw CdvsException("ImageBuffer.resampleImage: Image is too large");
    }
 
+   // luminance images: cached filter weights and SIMD filtering (the output differs by at most one grey level)
+
+   if ((n == 1) && (pFilter != NULL) && (strcmp(pFilter, "lanczos3") == 0) &&
+		   Lanczos3Resampler::resample(pSrc_image, src_width, src_height, dst_image, dst_width, dst_height))
+   {
+	   return;
+   }
+
    // Partial gamma correction looks better on mips. Set to 1.0 to disable gamma correction.
    //const float source_gamma = 1.75f;
    const float source_gamma = 1.0f;
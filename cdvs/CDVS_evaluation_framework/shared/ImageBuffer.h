@@ -70,6 +70,17 @@ public:
 	 */
 	void read(int width, int height, const unsigned char * buffer);
 
+	/**
+	 * Read a planar luminance image that has been decoded at a reduced resolution from a buffer.
+	 * The image will be processed as if it had been decoded at the original resolution.
+	 * @param width width of the decoded image
+	 * @param height height of the decoded image
+	 * @param buffer the buffer containing the luminance component of the decoded image
+	 * @param originalWidth width of the original image
+	 * @param originalHeight height of the original image
+	 */
+	void read(int width, int height, const unsigned char * buffer, int originalWidth, int originalHeight);
+
 	/**
 	 * Convert this image into a destination image having a different resolution by filtering and sampling the original image.
 	 * @param dest the destination image
@@ -85,7 +96,16 @@ public:
 	void resample(double rfactor);
 
 	/**
-	 * Resample this image if either the horizontal or the vertical dimension of the image is greater that the given maximum size.
+	 * Resample this image to the given resolution (the original image is discarded).
+	 * @param newWidth the new width
+	 * @param newHeight the new height
+	 * @throws CdvsException in case or error
+	 */
+	void resample(int newWidth, int newHeight);
+
+	/**
+	 * Resample this image if either the horizontal or the vertical dimension of the original image is greater that the given maximum size.
+	 * The new resolution is computed from the resolution of the original image, even if it has been decoded at a reduced resolution.
 	 * @param maxSize the maximum size to set
 	 * @throws CdvsException in case or error
 	 */
@@ -0,0 +1,383 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include "Lanczos3Resampler.h"
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <algorithm>
+#include "resampler.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define LANCZOS3_RESAMPLER_X86		// the AVX2 kernels are compiled with function-specific target attributes
+#endif
+
+#if defined(__SSE2__) || defined(LANCZOS3_RESAMPLER_X86)
+	#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace mpeg7cdvs;
+
+Lanczos3Resampler::Axis::Axis(int srcSize, int dstSize):srcSize(srcSize),dstSize(dstSize),stride(0),first(),weights()
+{
+	// the same contributor lists as in ImageBuffer::resampleImage(); the other axis is not used
+
+	Resampler resampler(srcSize, 1, dstSize, 1, Resampler::BOUNDARY_CLAMP, 0.0f, 1.0f, "lanczos3", NULL, NULL, 1.0f, 1.0f);
+	if (resampler.status() != Resampler::STATUS_OKAY)
+		return;				// let the resampler library handle (and report) this case: stride is 0
+
+	const Resampler::Contrib_List * clist = resampler.get_clist_x();
+
+	// the clamped contributors of a destination sample are merged into a window of consecutive source samples
+
+	int taps = 0;
+	first.resize(dstSize);
+	for (int i = 0; i < dstSize; ++i)
+	{
+		int lo = srcSize, hi = 0;
+		for (int k = 0; k < clist[i].n; ++k)
+		{
+			lo = min(lo, (int) clist[i].p[k].pixel);
+			hi = max(hi, (int) clist[i].p[k].pixel);
+		}
+		first[i] = lo;
+		taps = max(taps, hi - lo + 1);
+	}
+
+	int size = (taps + 7) & ~7;
+	if (size > srcSize)
+		return;				// too few source samples: stride is 0
+
+	stride = size;
+	weights.assign((size_t) dstSize * stride, 0.0f);
+	for (int i = 0; i < dstSize; ++i)
+	{
+		int lo = first[i];
+		first[i] = min(lo, srcSize - stride);		// the window must not read past the last source sample
+		float * w = &weights[(size_t) i * stride] + (lo - first[i]);
+		for (int k = 0; k < clist[i].n; ++k)
+			w[clist[i].p[k].pixel - lo] += clist[i].p[k].weight;
+	}
+}
+
+namespace mpeg7cdvs
+{
+
+/*
+ * The weights of the axes seen so far; they are never removed while the process runs, so a pointer
+ * given out by the cache stays valid without locking.
+ */
+class AxisCache
+{
+public:
+	static const size_t maxAxes = 64;		// beyond this number of sizes, the weights are not cached any more
+
+	std::map< std::pair<int, int>, Lanczos3Resampler::Axis * > axes;
+
+	~AxisCache()
+	{
+		for (std::map< std::pair<int, int>, Lanczos3Resampler::Axis * >::iterator it = axes.begin(); it != axes.end(); ++it)
+			delete it->second;
+	}
+};
+
+}	// end of namespace
+
+const Lanczos3Resampler::Axis * Lanczos3Resampler::Axis::get(int srcSize, int dstSize)
+{
+	static AxisCache cache;
+	std::pair<int, int> key(srcSize, dstSize);
+	Axis * axis = NULL;
+
+	#pragma omp critical (lanczos3_axis_cache)
+	{
+		std::map< std::pair<int, int>, Axis * >::const_iterator it = cache.axes.find(key);
+		if (it != cache.axes.end())
+			axis = it->second;
+	}
+
+	if (axis == NULL)
+	{
+		Axis * created = new Axis(srcSize, dstSize);		// built outside the lock; another thread may build the same axis
+		bool stored = false;
+
+		#pragma omp critical (lanczos3_axis_cache)
+		{
+			std::map< std::pair<int, int>, Axis * >::const_iterator it = cache.axes.find(key);
+			if (it != cache.axes.end())
+				axis = it->second;
+			else if (cache.axes.size() < AxisCache::maxAxes)
+			{
+				cache.axes[key] = created;
+				axis = created;
+				stored = true;
+			}
+		}
+
+		if (!stored)
+			delete created;		// already cached by another thread, or the cache is full (axis is NULL)
+	}
+
+	return axis;
+}
+
+// vertical pass: out[x] = sum of w[k] * rows[k][x], adding the products in the order of k
+
+static void resampleColumns_scalar(float * out, const unsigned char * const * rows, const float * w, int n, int begin, int width)
+{
+	for (int x = begin; x < width; ++x)
+	{
+		float acc = 0.0f;
+		for (int k = 0; k < n; ++k)
+			acc += w[k] * (float) rows[k][x];
+		out[x] = acc;
+	}
+}
+
+// horizontal pass: each output is the dot product of stride weights and samples, accumulated in 8 lanes (lane = k mod 8)
+// and reduced as ((l0 + l4) + (l2 + l6)) + ((l1 + l5) + (l3 + l7))
+
+#if defined(__SSE2__)
+
+static inline __m128 horizontalSum_sse(__m128 lo, __m128 hi)
+{
+	__m128 s = _mm_add_ps(lo, hi);						// s0 s1 s2 s3
+	__m128 t = _mm_add_ps(s, _mm_movehl_ps(s, s));		// s0 + s2, s1 + s3
+	return _mm_add_ss(t, _mm_shuffle_ps(t, t, 1));
+}
+
+static void resampleColumns_sse(float * out, const unsigned char * const * rows, const float * w, int n, int begin, int width)
+{
+	const __m128i zero = _mm_setzero_si128();
+	int x = begin;
+	for (; x + 8 <= width; x += 8)
+	{
+		__m128 acclo = _mm_setzero_ps(), acchi = _mm_setzero_ps();
+		for (int k = 0; k < n; ++k)
+		{
+			__m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (rows[k] + x)), zero);
+			__m128 weight = _mm_set1_ps(w[k]);
+			acclo = _mm_add_ps(acclo, _mm_mul_ps(weight, _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero))));
+			acchi = _mm_add_ps(acchi, _mm_mul_ps(weight, _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero))));
+		}
+		_mm_storeu_ps(out + x, acclo);
+		_mm_storeu_ps(out + x + 4, acchi);
+	}
+	resampleColumns_scalar(out, rows, w, n, x, width);
+}
+
+static void resampleRow_sse(float * out, const float * in, const Lanczos3Resampler::Axis & axis, int begin)
+{
+	for (int i = begin; i < axis.dstSize; ++i)
+	{
+		const float * w = &axis.weights[(size_t) i * axis.stride];
+		const float * p = in + axis.first[i];
+		__m128 acclo = _mm_setzero_ps(), acchi = _mm_setzero_ps();
+		for (int k = 0; k < axis.stride; k += 8)
+		{
+			acclo = _mm_add_ps(acclo, _mm_mul_ps(_mm_loadu_ps(w + k), _mm_loadu_ps(p + k)));
+			acchi = _mm_add_ps(acchi, _mm_mul_ps(_mm_loadu_ps(w + k + 4), _mm_loadu_ps(p + k + 4)));
+		}
+		_mm_store_ss(out + i, horizontalSum_sse(acclo, acchi));
+	}
+}
+
+#else
+
+static void resampleColumns_sse(float * out, const unsigned char * const * rows, const float * w, int n, int begin, int width)
+{
+	resampleColumns_scalar(out, rows, w, n, begin, width);
+}
+
+// scalar version of the SSE2 kernel, with the same lanes and reduction
+static void resampleRow_sse(float * out, const float * in, const Lanczos3Resampler::Axis & axis, int begin)
+{
+	for (int i = begin; i < axis.dstSize; ++i)
+	{
+		const float * w = &axis.weights[(size_t) i * axis.stride];
+		const float * p = in + axis.first[i];
+		float lane[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+		for (int k = 0; k < axis.stride; k += 8)
+		{
+			for (int j = 0; j < 8; ++j)
+				lane[j] += w[k + j] * p[k + j];
+		}
+		float s0 = lane[0] + lane[4], s1 = lane[1] + lane[5], s2 = lane[2] + lane[6], s3 = lane[3] + lane[7];
+		out[i] = (s0 + s2) + (s1 + s3);
+	}
+}
+
+#endif
+
+#ifdef LANCZOS3_RESAMPLER_X86
+
+// no FMA: the products are rounded before being added, as in the SSE2 and scalar kernels
+
+__attribute__((target("avx2")))
+static void resampleColumns_avx2(float * out, const unsigned char * const * rows, const float * w, int n, int width)
+{
+	int x = 0;
+	for (; x + 8 <= width; x += 8)
+	{
+		__m256 acc = _mm256_setzero_ps();
+		for (int k = 0; k < n; ++k)
+		{
+			__m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (rows[k] + x))));
+			acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(w[k]), v));
+		}
+		_mm256_storeu_ps(out + x, acc);
+	}
+	resampleColumns_sse(out, rows, w, n, x, width);
+}
+
+__attribute__((target("avx2")))
+static void resampleRow_avx2(float * out, const float * in, const Lanczos3Resampler::Axis & axis)
+{
+	for (int i = 0; i < axis.dstSize; ++i)
+	{
+		const float * w = &axis.weights[(size_t) i * axis.stride];
+		const float * p = in + axis.first[i];
+		__m256 acc = _mm256_setzero_ps();
+		for (int k = 0; k < axis.stride; k += 8)
+			acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(w + k), _mm256_loadu_ps(p + k)));
+
+		__m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+		__m128 t = _mm_add_ps(s, _mm_movehl_ps(s, s));
+		_mm_store_ss(out + i, _mm_add_ss(t, _mm_shuffle_ps(t, t, 1)));
+	}
+}
+
+static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+
+#endif
+
+static inline void resampleColumns(float * out, const unsigned char * const * rows, const float * w, int n, int width)
+{
+#ifdef LANCZOS3_RESAMPLER_X86
+	if (avx2)
+	{
+		resampleColumns_avx2(out, rows, w, n, width);
+		return;
+	}
+#endif
+	resampleColumns_sse(out, rows, w, n, 0, width);
+}
+
+static inline void resampleRow(float * out, const float * in, const Lanczos3Resampler::Axis & axis)
+{
+#ifdef LANCZOS3_RESAMPLER_X86
+	if (avx2)
+	{
+		resampleRow_avx2(out, in, axis);
+		return;
+	}
+#endif
+	resampleRow_sse(out, in, axis, 0);
+}
+
+/*
+ * The output conversion of ImageBuffer::resampleImage() (with source gamma 1): the samples, in the range [0, 1],
+ * are clamped and mapped to 8 bits through a table of 4096 entries.
+ */
+static const int tableSize = 4096;
+
+class LinearTo8bit
+{
+public:
+	unsigned char table[tableSize];
+
+	LinearTo8bit()
+	{
+		for (int i = 0; i < tableSize; ++i)
+			table[i] = (unsigned char) min(255, max(0, (int) (255.0f * (i * (1.0f / tableSize)) + .5f)));
+	}
+};
+
+bool Lanczos3Resampler::resample(const unsigned char * src, int srcWidth, int srcHeight, unsigned char * dst, int dstWidth, int dstHeight)
+{
+	std::vector<Axis> uncached;		// the weights that do not fit in the cache
+	uncached.reserve(2);
+
+	const Axis * ax = Axis::get(srcWidth, dstWidth);
+	if (ax == NULL)
+	{
+		uncached.push_back(Axis(srcWidth, dstWidth));
+		ax = &uncached.back();
+	}
+
+	const Axis * ay = Axis::get(srcHeight, dstHeight);
+	if (ay == NULL)
+	{
+		uncached.push_back(Axis(srcHeight, dstHeight));
+		ay = &uncached.back();
+	}
+
+	if ((ax->stride == 0) || (ay->stride == 0))
+		return false;
+
+	static const LinearTo8bit linear;
+	const unsigned char * table = linear.table;
+	std::vector<float> column(srcWidth);		// the source columns filtered at the current destination row
+	std::vector<float> row(dstWidth);			// the current destination row
+	std::vector<const unsigned char *> rows(ay->stride);
+	std::vector<float> w(ay->stride);
+
+	for (int y = 0; y < dstHeight; ++y)
+	{
+		// skip the zero weights of the window (there is no need to add zeros)
+
+		const float * wy = &ay->weights[(size_t) y * ay->stride];
+		int n = 0;
+		for (int k = 0; k < ay->stride; ++k)
+		{
+			if (wy[k] != 0.0f)
+			{
+				rows[n] = src + (size_t) (ay->first[y] + k) * srcWidth;
+				w[n++] = wy[k];
+			}
+		}
+
+		resampleColumns(column.data(), rows.data(), w.data(), n, srcWidth);
+		resampleRow(row.data(), column.data(), *ax);
+
+		unsigned char * out = dst + (size_t) y * dstWidth;
+		for (int x = 0; x < dstWidth; ++x)
+		{
+			float v = min(max(row[x] * (1.0f/255.0f), 0.0f), 1.0f);
+			int j = (int) (tableSize * v + .5f);
+			out[x] = table[min(j, tableSize - 1)];
+		}
+	}
+
+	return true;
+}
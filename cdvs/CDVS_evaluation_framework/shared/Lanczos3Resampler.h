@@ -0,0 +1,95 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#pragma once
+
+#include <vector>
+
+namespace mpeg7cdvs
+{
+
+/**
+ * @class Lanczos3Resampler
+ * Fast lanczos3 resampling of 8-bit single-channel images, equivalent to ImageBuffer::resampleImage().
+ * The filter weights of each axis are taken from the contributor lists of the resampler library and cached per
+ * (source size, destination size) pair, so images of the same resolution share them; the image is filtered
+ * vertically and then horizontally using SSE2 or AVX2 kernels, selected at run time.
+ * All kernels add the products in the same order, so the output does not depend on the CPU; it differs from the
+ * output of the resampler library (which adds them in another order) by at most one grey level.
+ */
+class Lanczos3Resampler
+{
+public:
+	/**
+	 * Resample an image.
+	 * @param src the source image
+	 * @param srcWidth the width of the source image
+	 * @param srcHeight the height of the source image
+	 * @param dst the destination image
+	 * @param dstWidth the width of the destination image
+	 * @param dstHeight the height of the destination image
+	 * @return false if the image is too small for this implementation (nothing has been written)
+	 */
+	static bool resample(const unsigned char * src, int srcWidth, int srcHeight, unsigned char * dst, int dstWidth, int dstHeight);
+
+	/**
+	 * The filter weights of one axis: destination sample i is the weighted sum of the source samples
+	 * first[i] ... first[i] + stride - 1; the unused weights are zero.
+	 */
+	class Axis
+	{
+	public:
+		int srcSize;					///< the number of source samples
+		int dstSize;					///< the number of destination samples
+		int stride;						///< the number of weights of each destination sample (a multiple of 8)
+		std::vector<int> first;			///< the first source sample of each destination sample
+		std::vector<float> weights;		///< dstSize * stride weights
+
+		/**
+		 * Get the weights of an axis from the cache, creating them if needed.
+		 * @param srcSize the number of source samples
+		 * @param dstSize the number of destination samples
+		 * @return the weights (owned by the cache), or NULL if the cache is full
+		 */
+		static const Axis * get(int srcSize, int dstSize);
+
+		/**
+		 * Build the weights of an axis; stride is 0 if srcSize is smaller than the filter support
+		 * or if the resampler library fails.
+		 * @param srcSize the number of source samples
+		 * @param dstSize the number of destination samples
+		 */
+		Axis(int srcSize, int dstSize);
+	};
+};
+
+}	// end of namespace
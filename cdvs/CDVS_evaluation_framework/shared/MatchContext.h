@@ -0,0 +1,80 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Joint Open Lab VISIBLE (Telecom Italia)
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include "FeatureList.h"
+#include "PointPairs.h"
+#include "CdvsPoint.h"
+#include "DistratEigen.h"
+
+namespace mpeg7cdvs
+{
+
+/**
+ * @class MatchContext
+ * Per-thread working memory of matching and retrieval.
+ * All the buffers needed to match a query with its reference images are kept here, and they only grow:
+ * a thread that keeps serving queries stops allocating memory once it has processed the largest descriptors.
+ * The per-query members are used by the thread that runs the query; the per-candidate members are used
+ * by each thread that verifies candidates, so the calling thread can use both at the same time.
+ */
+class MatchContext
+{
+public:
+	// per query members
+
+	CompressedFeatureList query;			///< the compressed query features
+	CompressedFeatureList reference;		///< the compressed reference features (pair-wise matching only)
+	std::vector< std::pair<double,unsigned int> > candidates;		///< retrieval candidates, as (global score, image index)
+	std::vector< std::pair<double,unsigned int> > localCandidates;	///< retrieval candidates selected by the local descriptor indices
+	std::vector<float> bestScores;			///< heap of the best scores found in retrieval
+	std::vector< std::pair<float,unsigned int> > ranking;			///< sort keys of the retrieval results, as (-score, position)
+	std::vector<RetrievalData> sortedResults;	///< sorted retrieval results
+
+	// per candidate members
+
+	PointPairs pairs;						///< the pairs of matching features
+	MatchScratch scratch;					///< working memory of the feature matching
+	DistratEigen distrat;					///< geometric consistency check
+
+	/**
+	 * Get the context of the calling thread.
+	 * The context is created at the first call in each thread, and destroyed when the thread ends.
+	 * @return the context of the calling thread.
+	 */
+	static MatchContext & threadLocal();
+};
+
+}	// end of namespace
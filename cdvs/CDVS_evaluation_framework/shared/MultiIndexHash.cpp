@@ -0,0 +1,358 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Joint Open Lab VISIBLE (Telecom Italia)
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include "MultiIndexHash.h"
+#include "HammingKernel.h"
+#include "CdvsException.h"
+#include <cstdio>
+#include <algorithm>
+
+using namespace mpeg7cdvs;
+using namespace std;
+
+static const size_t LARGE_INDEX_FEATURES = 4096;		// above this number of features two byte substrings are used
+
+template<class T> static void writeVector(FILE * file, const vector<T> & v)
+{
+	unsigned int n = (unsigned int) v.size();
+	if ((fwrite(&n, sizeof(n), 1, file) != 1) || ((n > 0) && (fwrite(&v[0], sizeof(T), n, file) != n)))
+		throw CdvsException("MultiIndexHash::write - Error writing file");
+}
+
+template<class T> static void readVector(FILE * file, vector<T> & v)
+{
+	unsigned int n = 0;
+	if (fread(&n, sizeof(n), 1, file) != 1)
+		throw CdvsException("MultiIndexHash::read - Error reading file");
+	v.resize(n);
+	if ((n > 0) && (fread(&v[0], sizeof(T), n, file) != n))
+		throw CdvsException("MultiIndexHash::read - Error reading file");
+}
+
+static bool cmpScoreIndexDescend(const pair<double,unsigned int> & pair1, const pair<double,unsigned int> & pair2)
+{
+	return (pair1.first > pair2.first) || ((pair1.first == pair2.first) && (pair1.second < pair2.second));
+}
+
+MultiIndexHash::MultiIndexHash():nBytes(0), substringBytes(1), nTables(0), numImages(0)
+{}
+
+int MultiIndexHash::keyBits(int table) const
+{
+	return 8 * std::min(substringBytes, nBytes - table * substringBytes);
+}
+
+unsigned int MultiIndexHash::key(const unsigned char * code, int table) const
+{
+	const unsigned char * substring = code + table * substringBytes;
+	unsigned int value = substring[0];
+	if (keyBits(table) > 8)
+		value |= ((unsigned int) substring[1]) << 8;
+	return value;
+}
+
+int MultiIndexHash::prefixTables(int bytes) const
+{
+	// the last table may be shorter than substringBytes: it is used only if the whole descriptor is compared
+	return (bytes >= nBytes) ? nTables : std::min(nTables, bytes / substringBytes);
+}
+
+void MultiIndexHash::clear()
+{
+	nBytes = 0;
+	nTables = 0;
+	numImages = 0;
+	codes.clear();
+	featureImage.clear();
+	imageFirst.assign(1, 0);
+	bucketFirst.clear();
+	bucketIds.clear();
+}
+
+void MultiIndexHash::build(const vector<CompressedFeatureList> & images, int substringBytes)
+{
+	clear();
+
+	// copy all descriptors in a single array
+	size_t nFeatures = 0;
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		if (images[i].nFeatures() > 0)
+		{
+			if ((nBytes > 0) && (images[i].descrBytes() != nBytes))
+				throw CdvsException("MultiIndexHash::build - all images must have the same descriptor size");
+			nBytes = images[i].descrBytes();
+			nFeatures += images[i].nFeatures();
+		}
+	}
+
+	numImages = (unsigned int) images.size();
+	codes.reserve(nFeatures * nBytes);
+	featureImage.reserve(nFeatures);
+	imageFirst.reserve(numImages + 1);
+	for (unsigned int i = 0; i < numImages; ++i)
+	{
+		codes.insert(codes.end(), images[i].features, images[i].features + images[i].nFeatures() * nBytes);
+		featureImage.insert(featureImage.end(), images[i].nFeatures(), i);
+		imageFirst.push_back((unsigned int) featureImage.size());
+	}
+
+	if (nFeatures == 0)
+		return;
+
+	// searches are fastest when each bucket contains a few descriptors, i.e. when substrings have about log2(nFeatures) bits
+	if (substringBytes <= 0)
+		substringBytes = (nFeatures > LARGE_INDEX_FEATURES) ? 2 : 1;
+	this->substringBytes = std::min(std::min(substringBytes, 2), nBytes);
+	nTables = (nBytes + this->substringBytes - 1) / this->substringBytes;
+
+	// fill the hash tables with a counting sort of the descriptors by key
+	bucketFirst.resize(nTables);
+	bucketIds.resize(nTables);
+	for (int t = 0; t < nTables; ++t)
+	{
+		vector<unsigned int> & first = bucketFirst[t];
+		first.assign((1 << keyBits(t)) + 1, 0);
+		for (size_t f = 0; f < nFeatures; ++f)
+			first[key(&codes[f * nBytes], t) + 1]++;
+
+		for (size_t b = 1; b < first.size(); ++b)
+			first[b] += first[b - 1];
+
+		vector<unsigned int> next(first.begin(), first.end() - 1);
+		bucketIds[t].resize(nFeatures);
+		for (size_t f = 0; f < nFeatures; ++f)
+			bucketIds[t][next[key(&codes[f * nBytes], t)]++] = (unsigned int) f;
+	}
+}
+
+void MultiIndexHash::searchLevel(const unsigned char * query, int bytes, int level, int maxDistance, vector< pair<int,unsigned int> > & found) const
+{
+	// probe, in each table within the compared prefix, all the buckets whose key differs from the query substring in exactly "level" bits
+	int tables = prefixTables(bytes);
+	for (int t = 0; t < tables; ++t)
+	{
+		int bits = keyBits(t);
+		if (level > bits)
+			continue;
+
+		unsigned int queryKey = key(query, t);
+		unsigned int end = 1u << bits;
+		unsigned int mask = (1u << level) - 1;		// the lowest permutation of "level" bits
+		while (mask < end)
+		{
+			const vector<unsigned int> & first = bucketFirst[t];
+			unsigned int bucket = queryKey ^ mask;
+			for (unsigned int b = first[bucket]; b < first[bucket + 1]; ++b)
+			{
+				unsigned int id = bucketIds[t][b];
+				int distance = HammingKernel::distance(query, &codes[(size_t) id * nBytes], bytes);
+				if (distance <= maxDistance)
+					found.push_back(make_pair(distance, id));
+			}
+
+			if (mask == 0)
+				break;
+
+			// next permutation of the same number of bits
+			unsigned int lowest = mask & (0u - mask);
+			unsigned int ripple = mask + lowest;
+			mask = (((ripple ^ mask) >> 2) / lowest) | ripple;
+		}
+	}
+}
+
+void MultiIndexHash::toNeighbors(const vector< pair<int,unsigned int> > & found, size_t n, vector<Neighbor> & neighbors) const
+{
+	neighbors.resize(n);
+	for (size_t k = 0; k < n; ++k)
+	{
+		unsigned int id = found[k].second;
+		neighbors[k].image = featureImage[id];
+		neighbors[k].feature = id - imageFirst[featureImage[id]];
+		neighbors[k].distance = found[k].first;
+	}
+}
+
+int MultiIndexHash::radiusSearch(const unsigned char * query, int radius, vector<Neighbor> & neighbors, int queryBytes) const
+{
+	vector< pair<int,unsigned int> > found;
+	int bytes = searchBytes((queryBytes > 0) ? queryBytes : nBytes);
+	int tables = prefixTables(bytes);
+
+	// a descriptor within radius has at least one of the probed substrings within radius/tables
+	if (bytes > 0)
+	{
+		for (int level = 0; level <= radius / tables; ++level)
+			searchLevel(query, bytes, level, radius, found);
+	}
+
+	// a descriptor is found once for each table in which it is near enough
+	sort(found.begin(), found.end());
+	found.erase(unique(found.begin(), found.end()), found.end());
+
+	toNeighbors(found, found.size(), neighbors);
+	return (int) neighbors.size();
+}
+
+int MultiIndexHash::knnSearch(const unsigned char * query, int k, int maxDistance, vector<Neighbor> & neighbors, int queryBytes) const
+{
+	vector< pair<int,unsigned int> > found;
+	int bytes = searchBytes((queryBytes > 0) ? queryBytes : nBytes);
+	if ((k <= 0) || (bytes == 0))
+	{
+		neighbors.clear();
+		return 0;
+	}
+
+	int tables = prefixTables(bytes);
+	int maxLevel = std::min(8 * substringBytes, maxDistance / tables);
+
+	for (int level = 0; level <= maxLevel; ++level)
+	{
+		searchLevel(query, bytes, level, maxDistance, found);
+		sort(found.begin(), found.end());
+		found.erase(unique(found.begin(), found.end()), found.end());
+
+		// after probing this level, every descriptor within (level+1)*tables-1 has been found
+		int covered = (level + 1) * tables - 1;
+		if (((int) found.size() >= k) && (found[k - 1].first <= covered))
+			break;
+	}
+
+	toNeighbors(found, std::min(found.size(), (size_t) k), neighbors);
+	return (int) neighbors.size();
+}
+
+void MultiIndexHash::vote(const CompressedFeatureList & query, int k, int maxDistance, vector< pair<double,unsigned int> > & vImageScoresNumbers, size_t numRankedOutput) const
+{
+	vImageScoresNumbers.clear();
+	if ((nTables == 0) || (searchBytes(query.descrBytes()) == 0))
+		return;
+
+	vector<unsigned int> votes(numImages, 0);
+	vector<unsigned int> lastVoter(numImages, (unsigned int) -1);		// each query feature votes at most once for each image
+	vector<Neighbor> neighbors;
+
+	for (int f = 0; f < query.nFeatures(); ++f)
+	{
+		knnSearch(query.features + f * query.descrBytes(), k, maxDistance, neighbors, query.descrBytes());
+		for (size_t n = 0; n < neighbors.size(); ++n)
+		{
+			unsigned int image = neighbors[n].image;
+			if (lastVoter[image] != (unsigned int) f)
+			{
+				lastVoter[image] = f;
+				votes[image]++;
+			}
+		}
+	}
+
+	for (unsigned int i = 0; i < numImages; ++i)
+	{
+		if (votes[i] > 0)
+			vImageScoresNumbers.push_back(make_pair((double) votes[i], i));
+	}
+
+	size_t numOut = min(numRankedOutput, vImageScoresNumbers.size());
+	partial_sort(vImageScoresNumbers.begin(), vImageScoresNumbers.begin() + numOut, vImageScoresNumbers.end(), cmpScoreIndexDescend);
+	vImageScoresNumbers.resize(numOut);
+}
+
+void MultiIndexHash::write(string sIndexName) const
+{
+	FILE * file = fopen(sIndexName.c_str(), "wb");
+	if (file == NULL)
+		throw CdvsException(string("MultiIndexHash::write - Error opening ").append(sIndexName));
+
+	try {
+		int header[4] = { nBytes, substringBytes, nTables, (int) numImages };
+		if (fwrite(header, sizeof(int), 4, file) != 4)
+			throw CdvsException("MultiIndexHash::write - Error writing file");
+
+		writeVector(file, codes);
+		writeVector(file, featureImage);
+		writeVector(file, imageFirst);
+		for (int t = 0; t < nTables; ++t)
+		{
+			writeVector(file, bucketFirst[t]);
+			writeVector(file, bucketIds[t]);
+		}
+	}
+	catch(...)
+	{
+		fclose(file);
+		throw;
+	}
+
+	fclose(file);
+}
+
+void MultiIndexHash::read(string sIndexName)
+{
+	FILE * file = fopen(sIndexName.c_str(), "rb");
+	if (file == NULL)
+		throw CdvsException(string("MultiIndexHash::read - Error opening ").append(sIndexName));
+
+	try {
+		int header[4];
+		if (fread(header, sizeof(int), 4, file) != 4)
+			throw CdvsException("MultiIndexHash::read - Error reading file");
+
+		nBytes = header[0];
+		substringBytes = header[1];
+		nTables = header[2];
+		numImages = (unsigned int) header[3];
+
+		readVector(file, codes);
+		readVector(file, featureImage);
+		readVector(file, imageFirst);
+		bucketFirst.resize(nTables);
+		bucketIds.resize(nTables);
+		for (int t = 0; t < nTables; ++t)
+		{
+			readVector(file, bucketFirst[t]);
+			readVector(file, bucketIds[t]);
+		}
+
+		if ((codes.size() != featureImage.size() * nBytes) || (imageFirst.size() != numImages + 1))
+			throw CdvsException(string("MultiIndexHash::read - Invalid file ").append(sIndexName));
+	}
+	catch(...)
+	{
+		fclose(file);
+		clear();			// the index is not usable
+		throw;
+	}
+
+	fclose(file);
+}
@@ -0,0 +1,172 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Joint Open Lab VISIBLE (Telecom Italia)
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include "FeatureList.h"
+
+namespace mpeg7cdvs
+{
+
+/**
+ * @class MultiIndexHash
+ * A DB-wide index of the compressed local descriptors, supporting exact Hamming distance searches (multi-index hashing).
+ * Each descriptor is split into substrings of one or two bytes, and each substring is the key of a separate hash table.
+ * If two descriptors are within distance r, at least one of their m substrings is within distance r/m (pigeonhole principle),
+ * so all the neighbors of a query are found by probing the buckets near the query substrings, and checking only those descriptors.
+ * All descriptors in the index must have the same size. A query of a different size is compared with the DB descriptors
+ * on their common prefix, as done by the local matchers; only the substrings contained in that prefix are probed.
+ */
+class MultiIndexHash
+{
+public:
+	/**
+	 * A DB feature found by a search.
+	 */
+	struct Neighbor
+	{
+		unsigned int image;		///< index of the image in the DB
+		unsigned int feature;	///< index of the feature in the image
+		int distance;			///< Hamming distance from the query
+	};
+
+private:
+	int nBytes;								///< size of each descriptor in bytes
+	int substringBytes;						///< size of each substring in bytes (the last one may be shorter)
+	int nTables;							///< number of substrings (hash tables)
+	unsigned int numImages;					///< number of indexed images
+	std::vector<unsigned char> codes;		///< all descriptors, nBytes each
+	std::vector<unsigned int> featureImage;	///< image of each descriptor
+	std::vector<unsigned int> imageFirst;	///< index of the first descriptor of each image (plus the total number of descriptors)
+	std::vector< std::vector<unsigned int> > bucketFirst;	///< for each table, index of the first descriptor of each bucket in bucketIds
+	std::vector< std::vector<unsigned int> > bucketIds;		///< for each table, all descriptors ordered by bucket
+
+	int keyBits(int table) const;
+	unsigned int key(const unsigned char * code, int table) const;
+	int prefixTables(int bytes) const;
+	void searchLevel(const unsigned char * query, int bytes, int level, int maxDistance, std::vector< std::pair<int,unsigned int> > & found) const;
+	void toNeighbors(const std::vector< std::pair<int,unsigned int> > & found, size_t n, std::vector<Neighbor> & neighbors) const;
+
+public:
+	MultiIndexHash();		// constructor
+	//	default destructor, copy-constructor, assignment op are ok
+
+	/**
+	 * Build the index of all the features of the given images, replacing the current one.
+	 * @param images the images to index (all must have the same descriptor size)
+	 * @param substringBytes size of the substrings (1 or 2 bytes; 0 = choose it according to the number of features)
+	 */
+	void build(const std::vector<CompressedFeatureList> & images, int substringBytes = 0);
+
+	/**
+	 * Remove all images from the index.
+	 */
+	void clear();
+
+	/**
+	 * Get the number of images contained in this index.
+	 * @return the number of images.
+	 */
+	size_t numberImages() const
+	{
+		return numImages;
+	}
+
+	/**
+	 * Get the number of features contained in this index.
+	 * @return the number of features.
+	 */
+	size_t numberFeatures() const
+	{
+		return featureImage.size();
+	}
+
+	/**
+	 * Get the size of the indexed descriptors.
+	 * @return the size in bytes of each descriptor (0 if the index is empty).
+	 */
+	int descrBytes() const
+	{
+		return nBytes;
+	}
+
+	/**
+	 * Find all the DB features within the given distance from a query descriptor.
+	 * @param query the query descriptor
+	 * @param radius the max Hamming distance
+	 * @param neighbors the output features, in ascending order of distance (then of position in the DB)
+	 * @param queryBytes size of the query descriptor (0 = descrBytes()); distances are computed on the first min(queryBytes, descrBytes()) bytes
+	 * @return the number of neighbors found
+	 */
+	int radiusSearch(const unsigned char * query, int radius, std::vector<Neighbor> & neighbors, int queryBytes = 0) const;
+
+	/**
+	 * Find the k nearest DB features of a query descriptor, within the given distance.
+	 * @param query the query descriptor
+	 * @param k the max number of neighbors
+	 * @param maxDistance the max Hamming distance of the neighbors
+	 * @param neighbors the output features, in ascending order of distance (then of position in the DB)
+	 * @param queryBytes size of the query descriptor (0 = descrBytes()); distances are computed on the first min(queryBytes, descrBytes()) bytes
+	 * @return the number of neighbors found
+	 */
+	int knnSearch(const unsigned char * query, int k, int maxDistance, std::vector<Neighbor> & neighbors, int queryBytes = 0) const;
+
+	/**
+	 * Get the number of bytes on which a query descriptor is compared with the DB descriptors.
+	 * @param queryBytes size of the query descriptor
+	 * @return the size of the common prefix, or 0 if it does not contain any whole substring (the index cannot be searched)
+	 */
+	int searchBytes(int queryBytes) const
+	{
+		int bytes = std::min(queryBytes, nBytes);
+		return (prefixTables(bytes) > 0) ? bytes : 0;
+	}
+
+	/**
+	 * Rank the DB images by the number of query features having them among their k nearest neighbors.
+	 * @param query the query features (compared with the DB features on their common prefix, see searchBytes())
+	 * @param k number of nearest neighbors of each query feature
+	 * @param maxDistance the max Hamming distance of the neighbors, measured on the common prefix
+	 * @param vImageScoresNumbers the output list of (votes, image index) pairs, in descending order of votes
+	 * @param numRankedOutput the max number of output images
+	 */
+	void vote(const CompressedFeatureList & query, int k, int maxDistance, std::vector< std::pair<double,unsigned int> > & vImageScoresNumbers, size_t numRankedOutput) const;
+
+	void write(std::string sIndexName) const;		///< write the index to file
+	void read(std::string sIndexName);				///< read the index from file (replacing the current one)
+};
+
+}	// end of namespace
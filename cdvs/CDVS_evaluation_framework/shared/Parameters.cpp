@@ -67,12 +67,20 @@ Parameters::Parameters(void)
 	wmMixed2Way				= 1.8;
 	ransacNumTests			= 10; 
     ransacThreshold 		= 8.0f;
+	ransacSeed				= 1;
 	modeId					= 0;
 	chiSquarePercentile     = 99;
+	prefilterThreshold		= 0.0f;
     retrievalLoops			= 2500;
 	wmRetrieval				= 4;
 	wmRetrieval2Way			= 2.2;
     queryExpansionLoops     = 0;
+	retrievalThreads		= 1;
+	retrievalCascade		= false;
+	vocabularyTreeCandidates = 0;
+	multiIndexHashCandidates = 0;
+	multiIndexHashNeighbors	= 10;
+	multiIndexHashRadius	= 0.125f;
 	scfvThreshold			= 0.0f;
 	locationBits			= 4.5;
 	hasVar					= false;
@@ -80,6 +88,10 @@ Parameters::Parameters(void)
 	gdThreshold				= 0.0f;
 	gdThresholdMixed		= 0.0f;
 	numberOfElementGroups	= 10;
+	lazyGradients			= false;
+	extractionThreads		= 1;
+	lowMemStrips			= 4;
+	fftwWisdom[0]			= 0;
 #ifdef USE_MBIT
 	MBIT_threshold			=3;
 #endif
@@ -373,10 +385,18 @@ int Parameters::setParameter(const char *paramName, const char *paramValue)
 	{
 		ransacThreshold = (float) atof(paramValue);
 	}
+	else if (strcmp(paramName, "ransacSeed")==0)
+	{
+		ransacSeed = atoi(paramValue);
+	}
 	else if (strcmp(paramName, "chiSquarePercentile")==0)
 	{
 		chiSquarePercentile = atoi(paramValue);
 	}
+	else if (strcmp(paramName, "prefilterThreshold")==0)
+	{
+		prefilterThreshold = (float) atof(paramValue);
+	}
 	else if (strcmp(paramName, "retrievalLoops")==0)
 	{
 		retrievalLoops = atoi(paramValue);
@@ -413,6 +433,47 @@ int Parameters::setParameter(const char *paramName, const char *paramValue)
 	{
 		queryExpansionLoops = atoi(paramValue);
 	}
+	else if (strcmp(paramName, "retrievalThreads")==0)
+	{
+		retrievalThreads = atoi(paramValue);
+	}
+	else if (strcmp(paramName, "vocabularyTreeCandidates")==0)
+	{
+		vocabularyTreeCandidates = atoi(paramValue);
+	}
+	else if (strcmp(paramName, "multiIndexHashCandidates")==0)
+	{
+		multiIndexHashCandidates = atoi(paramValue);
+	}
+	else if (strcmp(paramName, "multiIndexHashNeighbors")==0)
+	{
+		multiIndexHashNeighbors = atoi(paramValue);
+	}
+	else if (strcmp(paramName, "multiIndexHashRadius")==0)
+	{
+		multiIndexHashRadius = atof(paramValue);
+	}
+	else if (strcmp(paramName, "lazyGradients")==0)
+	{
+		lazyGradients = (atoi(paramValue) == 1);
+	}
+	else if (strcmp(paramName, "extractionThreads")==0)
+	{
+		extractionThreads = atoi(paramValue);
+	}
+	else if (strcmp(paramName, "lowMemStrips")==0)
+	{
+		lowMemStrips = atoi(paramValue);
+	}
+	else if (strcmp(paramName, "fftwWisdom")==0)
+	{
+		strncpy(fftwWisdom, paramValue, sizeof(fftwWisdom) - 1);
+		fftwWisdom[sizeof(fftwWisdom) - 1] = 0;
+	}
+	else if (strcmp(paramName, "retrievalCascade")==0)
+	{
+		retrievalCascade = (atoi(paramValue) == 1);
+	}
 	else if (strcmp(paramName, "scfvThreshold")==0)
 	{
 		scfvThreshold = atof(paramValue);
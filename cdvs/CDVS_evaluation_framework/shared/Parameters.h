@@ -65,6 +65,10 @@ public:
 	unsigned int selectMaxPoints;	///< feature extraction: max number of points used to describe an image
 	unsigned int numRelevantPoints;	///< feature extraction: number of points considered relevant in the retrieval process
 	int numberOfElementGroups;		///< feature compression: number of element groups in a compressed local feature descriptor
+	bool lazyGradients;				///< feature extraction: compute the gradients only around the keypoints that are actually described (false = whole Gaussian levels)
+	int extractionThreads;			///< feature extraction: max number of threads used to process a single image (1 = serial)
+	int lowMemStrips;				///< low-memory feature extraction: number of horizontal strips of the first octave (processed in parallel if extractionThreads > 1)
+	char fftwWisdom[256];			///< BFLOG feature extraction: FFTW wisdom file where the measured FFT plans are kept for the next runs (empty = estimate the plans)
 
 	float ratioThreshold;			///< DISTRAT: threshold for descriptor matching 
 	unsigned int minNumInliers;		///< DISTRAT: min number of inliers after the geometric check
@@ -77,16 +81,24 @@ public:
 	// execution parameters
 	int debugLevel;					///< 0 = off, 1 = on (quiet), 2 = on (verbose), 3 = verbose + dump files 
 
-	int ransacNumTests; 			///< RANSAC: number of iterations in RANSAC 
+	int ransacNumTests; 			///< RANSAC: max number of iterations in RANSAC (it stops earlier when the observed inlier ratio is high)
 	float ransacThreshold;			///< RANSAC: distortion threshold to be used by RANSAC
+	unsigned int ransacSeed;		///< RANSAC: seed of the random number generator (restarted for every localization, so results are reproducible)
 
 	unsigned int chiSquarePercentile;///< percentile used in DISTRAT for Chi-square computation
+	float prefilterThreshold;		///< DISTRAT runs only if the weight of the matches agreeing on scale and rotation reaches this fraction of the local threshold (0 = disabled, the default; 0.7 was safe on the validation pairs)
     int retrievalLoops;				///< number of loops performed in the final stage of the retrieval process
 	double wmRetrieval;				///< Weighted matching threshold for retrieval
 	double wmRetrieval2Way;			///< Two way weighted matching threshold for retrieval
 
 	int retrievalMaxPoints;			///< max number of points used in the retrieval experiment
 	int queryExpansionLoops;		///< number of query expansion loops to perform in the retrieval experiment
+	int retrievalThreads;			///< max number of threads used to verify the candidates of a single query (1 = serial)
+	int vocabularyTreeCandidates;	///< number of candidates selected by the vocabulary tree index and merged with the global descriptor candidates (0 = disabled)
+	int multiIndexHashCandidates;	///< number of candidates selected by the votes of the multi-index hash of the DB local descriptors (0 = disabled)
+	int multiIndexHashNeighbors;	///< number of nearest DB features of each query feature voting for their images
+	float multiIndexHashRadius;		///< max Hamming distance of the voting DB features, as a fraction of the descriptor bits
+	bool retrievalCascade;			///< indicates if retrieval skips the candidates (or the DISTRAT checks) that cannot change the list of results (off by default; when on, the nMatched and nInliers of the skipped candidates are lower than when they are verified)
 
 	float scfvThreshold;			///< threshold value to control the sparsity of scfv vector -- add by linjie
 	bool hasVar;					///< indicates if using the gradient vector w.r.t the variance of Gaussian function -- add by linjie
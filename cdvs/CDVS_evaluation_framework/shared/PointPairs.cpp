@@ -31,6 +31,8 @@
 
 
 #include <cstring>
+#include <cmath>
+#include <utility>
 #include "PointPairs.h"
 #include "CdvsException.h"
 
@@ -95,11 +97,8 @@ PointPairs::PointPairs(const PointPairs& other )	// copy constructor
 	}
 }
 
-PointPairs& PointPairs::operator=( PointPairs other )		// assignment operator
+void PointPairs::swap(PointPairs & other)
 {
-	//  copy-swap idiom
-	// "other" is a local copy (passed by value), so it can be swapped safely
-
 	std::swap(local_score, other.local_score);
 	std::swap(global_score, other.global_score);
 	std::swap(score, other.score);
@@ -115,9 +114,35 @@ PointPairs& PointPairs::operator=( PointPairs other )		// assignment operator
 	std::swap(weights, other.weights);
 	std::swap(match_dirs, other.match_dirs);
 	std::swap(inlierIndexes, other.inlierIndexes);
+}
+
+PointPairs& PointPairs::operator=( PointPairs other )		// assignment operator
+{
+	//  copy-swap idiom
+	// "other" is a local copy (passed by value), so it can be swapped safely;
+	// it is move-constructed if the argument is a temporary, so no buffer is copied in that case
+
+	swap(other);
 	return *this;
 }
 
+void PointPairs::reset(int maxPairs)
+{
+	if (maxPairs > size)
+	{
+		PointPairs bigger(maxPairs);
+		swap(bigger);			// the old buffers are released by bigger
+	}
+
+	nMatched = 0;
+	nInliers = 0;
+	local_score = 0;
+	global_score = 0;
+	score = 0;
+	local_threshold = 0;
+	global_threshold = 0;
+}
+
 PointPairs::~PointPairs()
 {
 	delete[] x1;
@@ -202,3 +227,95 @@ double PointPairs::getInlierWeight() const
 	return weight;
 }
 
+
+
+double PointPairs::getConsistentWeight(double enough) const
+{
+	static const int kReferences = 8;				// number of strongest matches used as a reference
+	static const int kScaleBins = 12;				// bins of the distance ratio (each one is a factor sqrt(2) wide)
+	static const int kAngleBins = 12;				// bins of the rotation angle
+	static const float kMinDistance = 4.0f;			// shorter segments give unreliable votes
+
+	// select the strongest matches (sorted by decreasing weight)
+	int references[kReferences];
+	int nReferences = 0;
+	for (int i=0; i<nMatched; ++i)
+	{
+		int k = nReferences;
+		while ((k > 0) && (weights[i] > weights[references[k-1]]))
+		{
+			if (k < kReferences)
+				references[k] = references[k-1];
+			--k;
+		}
+
+		if (k < kReferences)
+		{
+			references[k] = i;
+			if (nReferences < kReferences)
+				++nReferences;
+		}
+	}
+
+	const float minSqDistance = kMinDistance * kMinDistance;
+	double best = 0.0;
+	double hist[kScaleBins][kAngleBins];
+
+	for (int r=0; (r < nReferences) && (best < enough); ++r)
+	{
+		const int ref = references[r];
+		memset(hist, 0, sizeof(hist));
+
+		for (int i=0; i<nMatched; ++i)
+		{
+			float dx1 = x1[i] - x1[ref];
+			float dy1 = x2[i] - x2[ref];
+			float dx2 = y1[i] - y1[ref];
+			float dy2 = y2[i] - y2[ref];
+			float sqDistance1 = dx1*dx1 + dy1*dy1;
+			float sqDistance2 = dx2*dx2 + dy2*dy2;
+			if ((sqDistance1 < minSqDistance) || (sqDistance2 < minSqDistance))
+				continue;			// also skips the reference itself
+
+			// the binary exponent of the squared distance ratio is the log distance ratio, in units of log(sqrt(2))
+			int exponent;
+			std::frexp(sqDistance1 / sqDistance2, &exponent);		// the mantissa is in [0.5, 1), so exponent - 1 is the binary exponent
+			int scaleBin = exponent - 1 + kScaleBins/2;
+			scaleBin = (scaleBin < 0) ? 0 : ((scaleBin >= kScaleBins) ? kScaleBins - 1 : scaleBin);
+
+			// rotation angle between the two segments, measured as a "diamond angle" in [0, 4) (monotonic with the angle and
+			// cheaper than atan2); each bin is a third of a quadrant
+			float c = dx2*dx1 + dy2*dy1;
+			float s = dx2*dy1 - dy2*dx1;
+			float angle;
+			if (s >= 0)
+				angle = (c >= 0) ? s / (c + s) : 1.0f - c / (s - c);
+			else
+				angle = (c < 0) ? 2.0f - s / (-c - s) : 3.0f + c / (c - s);
+
+			int angleBin = (int) (angle * (kAngleBins / 4));
+			if (angleBin >= kAngleBins)
+				angleBin = kAngleBins - 1;
+
+			hist[scaleBin][angleBin] += weights[i];
+		}
+
+		// dominant cell of 2x2 bins, so that a cluster of votes is not split by a bin edge (angles wrap around)
+		double dominant = 0.0;
+		for (int s=0; s<kScaleBins-1; ++s)
+		{
+			for (int a=0; a<kAngleBins; ++a)
+			{
+				int next = (a + 1) % kAngleBins;
+				double cell = hist[s][a] + hist[s][next] + hist[s+1][a] + hist[s+1][next];
+				if (cell > dominant)
+					dominant = cell;
+			}
+		}
+
+		if (weights[ref] + dominant > best)
+			best = weights[ref] + dominant;
+	}
+
+	return best;
+}
@@ -31,6 +31,7 @@
 
 #pragma once
 
+#include <cfloat>
 
 namespace mpeg7cdvs
 {
@@ -80,6 +81,19 @@ public:
 
 	virtual ~PointPairs();			///< destructor
 
+	/**
+	 * Swap this instance with another.
+	 * @param other the other instance to swap with
+	 */
+	void swap(PointPairs & other);
+
+	/**
+	 * Prepare this instance for a new matching: clear all pairs and scores, and make room for at least maxPairs pairs.
+	 * The buffers are reallocated only if they are smaller than maxPairs, so an instance reused across calls stops allocating memory.
+	 * @param maxPairs the maximum number of pairs of the new matching.
+	 */
+	void reset(int maxPairs);
+
 	/**
 	 * Return true if the PointPairs instance contains localization information.
 	 */
@@ -118,6 +132,17 @@ public:
 	 * @return the weight of inlier points.
 	 */
 	double getInlierWeight() const;
+
+	/**
+	 * Get the weight of the largest group of matched points that agree on the same scale and rotation.
+	 * Each of the strongest matches is used as a reference: the other matches vote (with their weight) in a coarse histogram
+	 * of the log distance ratio and the rotation angle of the segments joining them to the reference in the two images.
+	 * The cost is linear in the number of matches, so this is a cheap pre-filter of the candidates of the geometric verification:
+	 * the weight of the true inliers is seldom much higher than the returned value.
+	 * @param enough the search stops as soon as a group reaches this weight.
+	 * @return the weight of the reference match plus the weight of the dominant histogram cell.
+	 */
+	double getConsistentWeight(double enough = DBL_MAX) const;
 };
 
 }	// end of namespace
@@ -44,12 +44,6 @@ using std::istream;
 
 namespace
 {
-	inline int randint(int start, int end)
-	{
-		return rand() % (end - start) + start;
-	}
-
-
 	void removeSeparators(string &line, string const& separators)
 	{
 		size_t found = line.find_first_of(separators);
@@ -132,17 +126,3 @@ void preconditionTransform(Eigen::Matrix3f & transform, Point2DArray const& poin
 	transform.block(0,0,2,2) =   sqrt(2.0f) * Matrix2f::Identity() / ball.radius;
 	transform.block(0,2,2,1) = - sqrt(2.0f) * ball.center / ball.radius;
 }
-
-void randomSubset(vector<int> & indices, int nPoints, int subsetSize)
-{
-	indices.resize(nPoints);
-	for (int i = 0; i < nPoints; ++i)
-		indices[i] = i;
-
-	for (int i = 0; i < subsetSize; ++i)
-	{
-		int index = randint(i, nPoints);
-		std::swap(indices[i], indices[index]);
-	}
-	indices.resize(subsetSize);
-}
@@ -102,7 +102,4 @@ inline Eigen::Matrix3f preconditionTransform(Point2DArray const& points)
 }
 
 
-void randomSubset(std::vector<int> & indices, int nPoints, int subsetSize);
-
-
 #endif // POINTS_H_
@@ -32,9 +32,32 @@
 #include "Projective2D.h"
 
 #include <eigen3/Eigen/SVD>
+#include <eigen3/Eigen/LU>
+#include <algorithm>
+#include <cmath>
 
 using namespace Eigen;
 
+namespace {
+
+/*
+ * Order the matches by descending weight.
+ */
+class HeavierMatch
+{
+	const float * weights;
+
+public:
+	HeavierMatch(const float * weights):weights(weights) {}
+
+	bool operator()(int i, int j) const
+	{
+		return weights[i] > weights[j];
+	}
+};
+
+}	// end of anonymous namespace
+
 void Projective2D::directLinearTransform(Matrix3f &H, HomPoint2DArray const& fromPoints, HomPoint2DArray const& toPoints)
 {
 	/*
@@ -76,6 +99,14 @@ void Projective2D::directLinearTransform(Matrix3f &H, HomPoint2DArray const& fro
 Projective2D::Projective2D()
 {
 	 m_Homography.setIdentity();
+	 setSeed(kDefaultSeed);
+}
+
+void Projective2D::setSeed(unsigned int seed)
+{
+	m_RandomState = (int) (seed % (unsigned int) kRandomModulus);
+	if (m_RandomState == 0)			// 0 is a fixed point of the generator
+		m_RandomState = 1;
 }
 
 
@@ -105,20 +136,6 @@ void Projective2D::moveByHomography(Point2DArray &outCoordinates, Point2DArray c
 }
 
 
-// modelFit //
-void Projective2D::modelFit(VectorXf &distances, Point2DArray const& fromPoints,
-							Point2DArray const& toPoints, Matrix3f const& H) const
-{
-	Point2DArray approxToX(fromPoints.rows(), 2);
-	moveByHomography(approxToX, fromPoints, H);
-
-	ArrayXXf sqDiffTo = (approxToX-toPoints).array().square();
-	VectorXf sqDistTo = sqDiffTo.matrix().rowwise().sum();
-
-	distances = sqDistTo.array().sqrt();
-}
-
-
 // makeHomography //
 void Projective2D::makeHomography(Matrix3f &H, Point2DArray const& fromX,
 											   Point2DArray const& toX) const
@@ -149,53 +166,145 @@ void Projective2D::makeHomography(Point2DArray const& fromX, Point2DArray const&
 }
 
 
+bool Projective2D::minimalHomography(Matrix3f &H, Point2DArray const& fromX, Point2DArray const& toX, const int * subset)
+{
+	// with H(2,2) = 1, each pair of points gives two linear equations in the other eight elements of H
+	Matrix<float, 8, 8> A;
+	Matrix<float, 8, 1> b;
+	for (int n = 0; n < kMinimalSetSize; ++n)
+	{
+		float x = fromX(subset[n],0);
+		float y = fromX(subset[n],1);
+		float u = toX(subset[n],0);
+		float v = toX(subset[n],1);
+		A.row(2*n)   << x, y, 1, 0, 0, 0, -x*u, -y*u;
+		A.row(2*n+1) << 0, 0, 0, x, y, 1, -x*v, -y*v;
+		b(2*n)   = u;
+		b(2*n+1) = v;
+	}
+
+	FullPivLU< Matrix<float, 8, 8> > lu(A);
+	if (!lu.isInvertible())
+		return false;
+
+	Matrix<float, 8, 1> h = lu.solve(b);
+	H << h(0), h(1), h(2),
+		 h(3), h(4), h(5),
+		 h(6), h(7), 1.0f;
+	return true;
+}
+
+
+int Projective2D::consensus(VectorXi &consensusSet, Matrix3f const& H, Point2DArray const& fromX, Point2DArray const& toX, float sqThreshold)
+{
+	int nPoints = fromX.rows();
+	int count = 0;
+	for (int k = 0; k < nPoints; ++k)
+	{
+		consensusSet(k) = isInlier(H, fromX, toX, k, sqThreshold) ? 1 : 0;
+		count += consensusSet(k);
+	}
+	return count;
+}
+
+
 bool Projective2D::unconditionedRansac(VectorXi & outConsensusSet,
 									   HomPoint2DArray const& fromPoints, HomPoint2DArray const& toPoints,
-									   int nTests, float threshold)
+									   int nTests, float threshold, const float * weights)
 {
-	int biggestYet = -1;
+	static const double kConfidence = 0.99;		// probability of drawing at least one all-inlier sample before stopping
+
+	int nPoints = fromPoints.rows();
+	outConsensusSet.setZero(nPoints);
+	if (nPoints < kMinimalSetSize)
+		return false;
 
 	Point2DArray inhFromPoints;
 	inhomogeneousPoints(inhFromPoints, fromPoints);
 	Point2DArray inhToPoints;
 	inhomogeneousPoints(inhToPoints, toPoints);
 
-	std::vector<int> subset;
-	Matrix<float, kMinimalSetSize, 3> sampleMatrixFrom;
-	Matrix<float, kMinimalSetSize, 3> sampleMatrixTo;
+	const float sqThreshold = threshold * threshold;
 
-	Matrix3f Hhyp;
+	// PROSAC: the samples are drawn from a pool of the best matches, which grows so that it includes all matches at the last of the nTests samples.
+	// The pool at each sample is the smallest one in which uniform RANSAC would have drawn that many samples, on average, in nTests samples.
+	std::vector<int> order(nPoints);
+	for (int k = 0; k < nPoints; ++k)
+		order[k] = k;
 
-	int nPoints = fromPoints.rows();
-	VectorXf distances(nPoints);
+	if (weights != NULL)
+		std::stable_sort(order.begin(), order.end(), HeavierMatch(weights));
+
+	int poolSize = kMinimalSetSize;			// number of matches the samples are drawn from
+	double poolSamples = nTests;			// expected number of samples drawn only from the current pool in uniform RANSAC
+	for (int i = 0; i < kMinimalSetSize; ++i)
+		poolSamples *= (double) (poolSize - i) / (double) (nPoints - i);
+
+	int subset[kMinimalSetSize];
+	Matrix3f Hhyp;
 	VectorXi hypoteticConsensusSet(nPoints);
-	outConsensusSet.resize(nPoints);
+	int biggestYet = 0;
+	int maxTests = nTests;
 
-	for (int sampleNo = 0; sampleNo < nTests; ++sampleNo)
+	for (int sampleNo = 1; sampleNo <= maxTests; ++sampleNo)
 	{
-		randomSubset(subset, nPoints, kMinimalSetSize);
-		for (int k = 0; k < kMinimalSetSize; ++k)
+		// grow the pool
+		bool grown = (sampleNo == 1);
+		while ((poolSamples < sampleNo) && (poolSize < nPoints))
 		{
-			sampleMatrixFrom.row(k) = fromPoints.row(subset[k]);
-			sampleMatrixTo.row(k)	= toPoints.row(subset[k]);
+			poolSamples *= (double) (poolSize + 1) / (double) (poolSize + 1 - kMinimalSetSize);
+			++poolSize;
+			grown = true;
+		}
+
+		// draw the sample: when the pool has just grown, its worst match is always included
+		int nDrawn = 0;
+		int drawFrom = poolSize;
+		if (grown)
+		{
+			subset[nDrawn++] = order[poolSize - 1];
+			drawFrom = poolSize - 1;
+		}
+
+		while (nDrawn < kMinimalSetSize)
+		{
+			int index = order[randomIndex(drawFrom)];
+			if (std::find(subset, subset + nDrawn, index) == subset + nDrawn)
+				subset[nDrawn++] = index;
 		}
 
 		// estimation of model parameters
-		directLinearTransform(Hhyp, sampleMatrixFrom,  sampleMatrixTo);
+		if (!minimalHomography(Hhyp, inhFromPoints, inhToPoints, subset))
+			continue;
 
-		// get the consensus set
-		modelFit(distances, inhFromPoints, inhToPoints, Hhyp);
-		for (int k = 0; k < nPoints; ++k)
+		// check the hypothesis on a few random matches before scoring it on all of them
+		if (biggestYet > 0)
 		{
-			hypoteticConsensusSet(k) = (distances(k) < threshold) ? 1 : 0;
+			bool passed = true;
+			for (int k = 0; passed && (k < kPreCheckSize); ++k)
+				passed = isInlier(Hhyp, inhFromPoints, inhToPoints, randomIndex(nPoints), sqThreshold);
+
+			if (!passed)
+				continue;
 		}
 
+		// get the consensus set
+		int consensusSize = consensus(hypoteticConsensusSet, Hhyp, inhFromPoints, inhToPoints, sqThreshold);
 
 		// is it the biggest so far?
-		if (hypoteticConsensusSet.sum() > biggestYet)
+		if (consensusSize > biggestYet)
 		{
-			outConsensusSet = hypoteticConsensusSet;
-			biggestYet		= hypoteticConsensusSet.sum();
+			outConsensusSet.swap(hypoteticConsensusSet);
+			biggestYet = consensusSize;
+
+			// update the number of iterations needed to find an all-inlier sample that also passes the pre-check, with the given confidence
+			double allInliers = std::pow((double) biggestYet / (double) nPoints, kMinimalSetSize + kPreCheckSize);
+			if (allInliers >= 1.0)
+				break;
+
+			double needed = std::ceil(std::log(1.0 - kConfidence) / std::log(1.0 - allInliers));
+			if (needed < maxTests)
+				maxTests = (int) needed;
 		}
 	}
 
@@ -217,10 +326,7 @@ bool Projective2D::unconditionedRansac(VectorXi & outConsensusSet,
 		}
 
 		directLinearTransform(m_Homography, consensusFrom,  consensusTo);
-		modelFit(distances, inhFromPoints, inhToPoints, m_Homography);
-
-		for (int k = 0; k < nPoints; ++k)
-			outConsensusSet(k) = (distances(k) < threshold) ? 1 : 0;
+		consensus(outConsensusSet, m_Homography, inhFromPoints, inhToPoints, sqThreshold);
 
 		return true;
 	}
@@ -233,7 +339,7 @@ bool Projective2D::unconditionedRansac(VectorXi & outConsensusSet,
 // ransac //
 void Projective2D::ransac(VectorXi &outConsensusSet,
 						  Point2DArray const& fromPoints, Point2DArray const& toPoints,
-						  int nTests, float threshold)
+						  int nTests, float threshold, const float * weights)
 {
 	Matrix3f Tfrom;
 	preconditionTransform(Tfrom, fromPoints);
@@ -247,15 +353,15 @@ void Projective2D::ransac(VectorXi &outConsensusSet,
 	homogeneousPoints(toXh, toPoints);
 	HomPoint2DArray toXprec = toXh * Tto.transpose();
 
-	if (unconditionedRansac(outConsensusSet, fromXprec, toXprec, nTests, threshold))
+	if (unconditionedRansac(outConsensusSet, fromXprec, toXprec, nTests, threshold, weights))
 		m_Homography = Tto.inverse() * m_Homography * Tfrom;
 	else
 		m_Homography.setIdentity();
 }
 
 
-void Projective2D::ransac(Point2DArray const& fromPoints, Point2DArray const& toPoints, int nTests, float threshold)
+void Projective2D::ransac(Point2DArray const& fromPoints, Point2DArray const& toPoints, int nTests, float threshold, const float * weights)
 {
 	VectorXi consensusSet;
-	ransac(consensusSet, fromPoints, toPoints, nTests, threshold);
+	ransac(consensusSet, fromPoints, toPoints, nTests, threshold, weights);
 }
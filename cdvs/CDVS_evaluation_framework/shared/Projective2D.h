@@ -46,6 +46,12 @@ class Projective2D
 public:
 	Projective2D();
 
+	/**
+	 * Restart the random number generator used by RANSAC from the given seed, to make its results reproducible.
+	 * @param seed the new seed.
+	 */
+	void setSeed(unsigned int seed);
+
 	/**
 	 * Check if the projectivity is the identity.
 	 * @return true if the projectivity is the identity.
@@ -69,16 +75,6 @@ public:
 	 */	
 	void moveByHomography(Point2DArray & outCoordinates, Point2DArray const& inCoordinates) const;
 
-	/**
-	 * Computes the error when approximating a target set of points by transforming another set of points through a homography.
-	 * @param distances output approximation errors.
-	 * @param fromPoints input list of points to be tranformed.
-	 * @param toPoints input target list of points.
-	 * @param H homography to be used.
-	 */
-	void modelFit(Eigen::VectorXf &distances, Point2DArray const& fromPoints,
-				  Point2DArray const& toPoints, const Eigen::Matrix3f &H) const;
-
 	/**
 	 * Computes a homography that approximates one set of points by transforming another set of points.
 	 * Uses the direct linear transformation method with normalization described by Hartley & Zisserman: Multiview Geometry 2nd edition, Alg. 4.2 page 109.
@@ -99,36 +95,102 @@ public:
 	/**
 	 * Identifies correct matches as a subset of matches represented by two sets of points using the RANSAC algorithm.
 	 * The transformation between the two sets is a homography.
+	 * The samples are drawn PROSAC-style (from the matches with the highest weights first, progressively widening to all matches by the last iteration),
+	 * every hypothesis is checked on a few random matches before being scored on all of them, and the iterations stop as soon
+	 * as the observed inlier ratio makes it unlikely that a larger consensus set exists.
 	 * @param consensusSet output binary vector indicating the correct matches.
 	 * @param fromPoints input list of matched points of the first image.
 	 * @param toPoints input list of matched points of the second image.
-	 * @param nTests input number of iterations to use in RANSAC (typically 10).
+	 * @param nTests input maximum number of iterations to use in RANSAC (typically 10).
 	 * @param threshold input maximum distance in order to judge a match as correct.
+	 * @param weights input weights of the matches (higher is better); if NULL, the samples are drawn uniformly.
 	 */
 	void ransac(Eigen::VectorXi &consensusSet,
 				Point2DArray const& fromPoints, Point2DArray const& toPoints,
-				int nTests, float threshold);
+				int nTests, float threshold, const float * weights = NULL);
 	
 	
 	/**
 	 * Builds a new homography through the RANSAC algorithm and saves it internally.
 	 * @param fromPoints input list of matched points of the first image.
 	 * @param toPoints input list of matched points of the second image.
-	 * @param nTests input number of iterations to use in RANSAC (typically 10).
+	 * @param nTests input maximum number of iterations to use in RANSAC (typically 10).
 	 * @param threshold input maximum distance in order to judge a match as correct.
+	 * @param weights input weights of the matches (higher is better); if NULL, the samples are drawn uniformly.
 	 */	
 	void ransac(Point2DArray const& fromPoints, Point2DArray const& toPoints,
-				int nTests, float threshold);
+				int nTests, float threshold, const float * weights = NULL);
 
 	
 private:
 	static const int kMinimalSetSize = 4;
+	static const int kPreCheckSize = 2;		///< number of random matches that must fit a hypothesis before it is scored on all matches
+	static const unsigned int kDefaultSeed = 1;
+	static const int kRandomModulus = 2147483647;	///< modulus of the "minimal standard" generator of Park and Miller (2^31 - 1)
+	static const int kRandomMultiplier = 48271;		///< multiplier of the generator (the same as std::minstd_rand)
 
 	Eigen::Matrix3f m_Homography;	///< 3x3 matrix defining a homography.
+	int m_RandomState;				///< state of the random number generator used by RANSAC, in [1, kRandomModulus).
+
+	/**
+	 * Draw a random integer in [0, n).
+	 * @param n the number of possible values.
+	 * @return the random integer.
+	 */
+	int randomIndex(int n)
+	{
+		// Schrage's method computes kRandomMultiplier * m_RandomState % kRandomModulus without overflowing 32 bits
+		const int q = kRandomModulus / kRandomMultiplier;
+		const int r = kRandomModulus % kRandomMultiplier;
+		m_RandomState = kRandomMultiplier * (m_RandomState % q) - r * (m_RandomState / q);
+		if (m_RandomState <= 0)
+			m_RandomState += kRandomModulus;
+		return m_RandomState % n;
+	}
 
 	bool unconditionedRansac(Eigen::VectorXi & consensusSet,
 							 HomPoint2DArray const& fromPoints, HomPoint2DArray const& toPoints,
-							 int nTests, float threshold);
+							 int nTests, float threshold, const float * weights);
+
+	/**
+	 * Computes the homography exactly mapping four points into four other points.
+	 * @param H output homography (with H(2,2) = 1).
+	 * @param fromX input points to be transformed.
+	 * @param toX input points to be approximated.
+	 * @param subset indexes of the four points.
+	 * @return false if the points are in a degenerate configuration.
+	 */
+	static bool minimalHomography(Eigen::Matrix3f &H, Point2DArray const& fromX, Point2DArray const& toX, const int * subset);
+
+	/**
+	 * Check if a transformed point is closer than a threshold to its target point.
+	 * @param H homography to be used.
+	 * @param fromX input list of points to be transformed.
+	 * @param toX input target list of points.
+	 * @param k index of the point.
+	 * @param sqThreshold the squared threshold.
+	 * @return true if the point is an inlier.
+	 */
+	static bool isInlier(Eigen::Matrix3f const& H, Point2DArray const& fromX, Point2DArray const& toX, int k, float sqThreshold)
+	{
+		float x = fromX(k,0);
+		float y = fromX(k,1);
+		float w = H(2,0)*x + H(2,1)*y + H(2,2);
+		float dx = (H(0,0)*x + H(0,1)*y + H(0,2)) / w - toX(k,0);
+		float dy = (H(1,0)*x + H(1,1)*y + H(1,2)) / w - toX(k,1);
+		return dx*dx + dy*dy < sqThreshold;
+	}
+
+	/**
+	 * Find the points that a homography transforms closer than a threshold to their target points.
+	 * @param consensusSet output binary vector indicating the inliers.
+	 * @param H homography to be used.
+	 * @param fromX input list of points to be transformed.
+	 * @param toX input target list of points.
+	 * @param sqThreshold the squared threshold.
+	 * @return the number of inliers.
+	 */
+	static int consensus(Eigen::VectorXi &consensusSet, Eigen::Matrix3f const& H, Point2DArray const& fromX, Point2DArray const& toX, float sqThreshold);
 
 	static void directLinearTransform(Eigen::Matrix3f &H, HomPoint2DArray const& fromPoints, HomPoint2DArray const& toPoints);
 };
@@ -566,7 +566,7 @@ void SCFVIndex::query_bitselection(const SCFVSignature& querySignature, vector<
 	unsigned int h;
 	int nImage = 0;
 
-	unsigned int *bitsOfQuery = new unsigned int[numberCentroids];
+	unsigned int bitsOfQuery[numberCentroids];
 
 	for(int i = 0 ; i < numberCentroids ; i ++)
 		bitsOfQuery[i] = compressToOriginal( querySignature.m_vWordBlock[i] , i );
@@ -612,7 +612,6 @@ void SCFVIndex::query_bitselection(const SCFVSignature& querySignature, vector<
 
 	} // pImage
 
-	delete[] bitsOfQuery;
 	// Sort scores  was: sort(vDatabaseScoresIndices.begin(), vDatabaseScoresIndices.end(), cmpDoubleUintAscend);
 	// Sort scores and produce the final ranking of numRankedOuput images (without sorting all images)
 	size_t numOut = min(numRankedOuput, nNumDatabaseImages);
@@ -1513,7 +1512,7 @@ void SCFVIndex::query_sort_bit_selection(const SCFVSignature& querySignature, ve
 	}
 
 
-	unsigned int *bitsOfQuery = new unsigned int[numberCentroids];
+	unsigned int bitsOfQuery[numberCentroids];
 
 	for(int i = 0 ; i < numberCentroids ; i ++)
 		bitsOfQuery[i] = compressToOriginal( querySignature.m_vWordBlock[i] , i );
@@ -1568,7 +1567,6 @@ void SCFVIndex::query_sort_bit_selection(const SCFVSignature& querySignature, ve
 		vDatabaseScoresIndices[nImage++].first = 2 - 2*fCorrelation;
 	} // nImage
 
-	delete[] bitsOfQuery;
 	// Sort scores  was: sort(vDatabaseScoresIndices.begin(), vDatabaseScoresIndices.end(), cmpDoubleUintAscend);
 	// Sort scores and produce the final ranking of numRankedOuput images (without sorting all images)
 	size_t numOut = min(numRankedOuput, nNumDatabaseImages);
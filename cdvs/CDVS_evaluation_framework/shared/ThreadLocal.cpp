@@ -0,0 +1,102 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Joint Open Lab VISIBLE (Telecom Italia)
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include "ThreadLocal.h"
+#include "CdvsException.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#endif
+
+using namespace mpeg7cdvs;
+
+#if defined(_WIN32) || defined(_WIN64)
+
+// fiber local storage (unlike TlsAlloc) calls back when a thread ends
+
+static void WINAPI deleteSlot(PVOID slot)
+{
+	delete (ThreadLocalKey::Slot *) slot;
+}
+
+ThreadLocalKey::ThreadLocalKey()
+{
+	key = FlsAlloc(deleteSlot);
+	if (key == FLS_OUT_OF_INDEXES)
+		throw CdvsException("ThreadLocalKey: cannot allocate a fiber local storage index");
+}
+
+ThreadLocalKey::~ThreadLocalKey()
+{
+	FlsFree(key);		// deletes the objects of all threads still running
+}
+
+ThreadLocalKey::Slot * ThreadLocalKey::get() const
+{
+	return (Slot *) FlsGetValue(key);
+}
+
+void ThreadLocalKey::set(Slot * slot)
+{
+	FlsSetValue(key, slot);
+}
+
+#else
+
+extern "C" void mpeg7cdvs_deleteSlot(void * slot)
+{
+	delete (ThreadLocalKey::Slot *) slot;
+}
+
+ThreadLocalKey::ThreadLocalKey()
+{
+	if (pthread_key_create(&key, mpeg7cdvs_deleteSlot) != 0)
+		throw CdvsException("ThreadLocalKey: cannot create a thread-specific data key");
+}
+
+ThreadLocalKey::~ThreadLocalKey()
+{
+	delete get();			// the objects of the other threads still running are not deleted
+	pthread_key_delete(key);
+}
+
+ThreadLocalKey::Slot * ThreadLocalKey::get() const
+{
+	return (Slot *) pthread_getspecific(key);
+}
+
+void ThreadLocalKey::set(Slot * slot)
+{
+	pthread_setspecific(key, slot);
+}
+
+#endif
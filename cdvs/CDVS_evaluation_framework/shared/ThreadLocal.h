@@ -0,0 +1,112 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Joint Open Lab VISIBLE (Telecom Italia)
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <pthread.h>
+#endif
+
+namespace mpeg7cdvs
+{
+
+/**
+ * @class ThreadLocalKey
+ * A key selecting one object of each thread, implemented on the native thread-local storage of the platform.
+ * The object of a thread is deleted when the thread ends.
+ */
+class ThreadLocalKey
+{
+public:
+	/**
+	 * @class Slot
+	 * Base class of the objects stored with a key.
+	 */
+	class Slot
+	{
+	public:
+		virtual ~Slot() {}
+	};
+
+	ThreadLocalKey();			///< constructor; throws CdvsException if the key cannot be allocated
+	~ThreadLocalKey();			///< destructor; deletes the object of the calling thread
+
+	Slot * get() const;			///< return the object of the calling thread, or NULL if it has not been set
+	void set(Slot * slot);		///< set the object of the calling thread; the key takes ownership of it
+
+private:
+#if defined(_WIN32) || defined(_WIN64)
+	unsigned long key;			// the fiber local storage index
+#else
+	pthread_key_t key;
+#endif
+
+	ThreadLocalKey(const ThreadLocalKey &);				// not copyable
+	ThreadLocalKey & operator=(const ThreadLocalKey &);
+};
+
+/**
+ * @class ThreadLocal
+ * One instance of T for each thread, created at the first call of get() in the thread and destroyed when the thread ends.
+ * Instances of this class must have static storage duration.
+ */
+template<class T> class ThreadLocal
+{
+private:
+	class Holder: public ThreadLocalKey::Slot
+	{
+	public:
+		T value;
+	};
+
+	ThreadLocalKey key;
+
+public:
+	/**
+	 * Get the instance of the calling thread.
+	 * @return the instance of the calling thread.
+	 */
+	T & get()
+	{
+		Holder * holder = static_cast<Holder *>(key.get());
+		if (holder == NULL)
+		{
+			holder = new Holder();
+			key.set(holder);
+		}
+		return holder->value;
+	}
+};
+
+}	// end of namespace
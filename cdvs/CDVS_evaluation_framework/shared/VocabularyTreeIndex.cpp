@@ -0,0 +1,402 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Joint Open Lab VISIBLE (Telecom Italia)
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include "VocabularyTreeIndex.h"
+#include "CdvsException.h"
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+#include "vl/hikmeans.h"		// vl_feat library
+
+using namespace mpeg7cdvs;
+using namespace std;
+
+static const int TRAINING_ITERATIONS = 25;		// max number of k-means iterations at each node of the tree
+
+// unpack the bits of a compressed descriptor (0 or 255 per bit, so that the squared L2 distance is 255^2 times the Hamming distance)
+template<class T> static void unpackBits(const unsigned char * descriptor, int nDims, T * out)
+{
+	for (int i = 0; i < nDims; ++i)
+		out[i] = ((descriptor[i >> 3] >> (i & 7)) & 1) ? 255 : 0;
+}
+
+// copy a node of the vlfeat tree (and all its descendants) into the flat representation; return the index of the node
+static int flattenNode(const VlHIKMNode * node, int nDims, vector<int> & nodeFirst, vector<int> & nodeCount, vector<int> & centerNext, vector<int> & centers, int & nWords)
+{
+	int K = vl_ikm_get_K(node->filter);
+	int nodeIndex = (int) nodeFirst.size();
+	int first = (int) centerNext.size();
+	nodeFirst.push_back(first);
+	nodeCount.push_back(K);
+	centerNext.resize(first + K);
+
+	const vl_ikm_acc * nodeCenters = vl_ikm_get_centers(node->filter);
+	centers.insert(centers.end(), nodeCenters, nodeCenters + K * nDims);
+
+	for (int k = 0; k < K; ++k)
+	{
+		const VlHIKMNode * child = (node->children != NULL) ? node->children[k] : NULL;
+		if ((child != NULL) && (vl_ikm_get_K(child->filter) > 0))		// a child trained with no data is not a node
+			centerNext[first + k] = flattenNode(child, nDims, nodeFirst, nodeCount, centerNext, centers, nWords);
+		else
+			centerNext[first + k] = -1 - (nWords++);
+	}
+
+	return nodeIndex;
+}
+
+template<class T> static void writeVector(FILE * file, const vector<T> & v)
+{
+	unsigned int n = (unsigned int) v.size();
+	if ((fwrite(&n, sizeof(n), 1, file) != 1) || ((n > 0) && (fwrite(&v[0], sizeof(T), n, file) != n)))
+		throw CdvsException("VocabularyTreeIndex::write - Error writing file");
+}
+
+template<class T> static void readVector(FILE * file, vector<T> & v)
+{
+	unsigned int n = 0;
+	if (fread(&n, sizeof(n), 1, file) != 1)
+		throw CdvsException("VocabularyTreeIndex::read - Error reading file");
+	v.resize(n);
+	if ((n > 0) && (fread(&v[0], sizeof(T), n, file) != n))
+		throw CdvsException("VocabularyTreeIndex::read - Error reading file");
+}
+
+VocabularyTreeIndex::VocabularyTreeIndex():nDims(0), nWords(0), numImages(0)
+{}
+
+void VocabularyTreeIndex::train(const vector<CompressedFeatureList> & images, int branching, int depth, size_t maxTrainingFeatures)
+{
+	if ((branching < 2) || (depth < 1))
+		throw CdvsException("VocabularyTreeIndex::train - invalid branching or depth");
+
+	// count the features available for training
+	size_t totalFeatures = 0;
+	int nBytes = 0;
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		if (images[i].nFeatures() > 0)
+		{
+			if ((nBytes > 0) && (images[i].descrBytes() != nBytes))
+				throw CdvsException("VocabularyTreeIndex::train - all images must have the same descriptor size");
+			nBytes = images[i].descrBytes();
+			totalFeatures += images[i].nFeatures();
+		}
+	}
+
+	size_t nTraining = min(totalFeatures, maxTrainingFeatures);
+	if (nTraining < (size_t) branching)
+		throw CdvsException("VocabularyTreeIndex::train - not enough features to train the vocabulary tree");
+
+	// unpack the training features, evenly sampled from all images
+	int dims = 8 * nBytes;
+	vector<vl_uint8> data(nTraining * dims);
+	size_t next = 0;			// index of the next training feature
+	size_t offset = 0;			// index of the first feature of the current image among all features
+	for (size_t i = 0; (i < images.size()) && (next < nTraining); ++i)
+	{
+		size_t n = images[i].nFeatures();
+		size_t sample;
+		while ((next < nTraining) && ((sample = (next * totalFeatures) / nTraining) < offset + n))
+		{
+			unpackBits(images[i].features + (sample - offset) * nBytes, dims, &data[next * dims]);
+			++next;
+		}
+		offset += n;
+	}
+
+	// train the tree with hierarchical integer k-means, then copy it
+	VlHIKMTree * tree = vl_hikm_new(VL_IKM_LLOYD);
+	vl_hikm_set_max_niters(tree, TRAINING_ITERATIONS);
+	vl_hikm_init(tree, dims, branching, depth);
+	vl_hikm_train(tree, &data[0], (int) nTraining);
+
+	nDims = dims;
+	nWords = 0;
+	nodeFirst.clear();
+	nodeCount.clear();
+	centerNext.clear();
+	centers.clear();
+	flattenNode(vl_hikm_get_root(tree), nDims, nodeFirst, nodeCount, centerNext, centers, nWords);
+	vl_hikm_delete(tree);
+
+	clear();
+}
+
+void VocabularyTreeIndex::quantize(const CompressedFeatureList & features, vector< pair<int,unsigned int> > & histogram) const
+{
+	histogram.clear();
+
+	int dims = min(nDims, 8 * features.descrBytes());		// a shorter query descriptor is compared with the first part of the centers
+	vector<int> bits(dims);
+	vector<int> words(features.nFeatures());
+
+	for (int f = 0; f < features.nFeatures(); ++f)
+	{
+		unpackBits(features.features + f * features.descrBytes(), dims, &bits[0]);
+
+		// descend the tree choosing the nearest center at each level
+		int next = 0;
+		while (next >= 0)
+		{
+			int best = nodeFirst[next];
+			int bestDistance = -1;
+			for (int c = nodeFirst[next]; c < nodeFirst[next] + nodeCount[next]; ++c)
+			{
+				const int * center = &centers[(size_t) c * nDims];
+				int distance = 0;
+				for (int i = 0; i < dims; ++i)
+				{
+					int d = center[i] - bits[i];
+					distance += d * d;
+				}
+
+				if ((bestDistance < 0) || (distance < bestDistance))
+				{
+					bestDistance = distance;
+					best = c;
+				}
+			}
+			next = centerNext[best];
+		}
+
+		words[f] = -1 - next;
+	}
+
+	// count the occurrences of each word
+	sort(words.begin(), words.end());
+	for (size_t k = 0; k < words.size(); ++k)
+	{
+		if (histogram.empty() || (histogram.back().first != words[k]))
+			histogram.push_back(make_pair(words[k], 0u));
+		histogram.back().second++;
+	}
+}
+
+void VocabularyTreeIndex::addImage(const CompressedFeatureList & features)
+{
+	if (!isTrained())
+		throw CdvsException("VocabularyTreeIndex::addImage - the vocabulary tree has not been trained");
+
+	vector< pair<int,unsigned int> > histogram;
+	quantize(features, histogram);
+
+	for (size_t k = 0; k < histogram.size(); ++k)
+	{
+		Posting posting = { numImages, histogram[k].second };
+		postings[histogram[k].first].push_back(posting);
+	}
+
+	imageNorms.push_back(0.0f);
+	numImages++;
+}
+
+void VocabularyTreeIndex::removePostings(unsigned int index)
+{
+	for (size_t w = 0; w < postings.size(); ++w)
+	{
+		for (vector<Posting>::iterator p = postings[w].begin(); p < postings[w].end(); ++p)
+		{
+			if (p->image == index)
+			{
+				postings[w].erase(p);
+				break;
+			}
+		}
+	}
+}
+
+void VocabularyTreeIndex::replaceImage(unsigned int index, const CompressedFeatureList & features)
+{
+	if (index >= numImages)
+		throw CdvsException("VocabularyTreeIndex::replaceImage - index out of range");
+
+	vector< pair<int,unsigned int> > histogram;
+	quantize(features, histogram);
+	removePostings(index);
+
+	// posting lists are sorted by image index
+	for (size_t k = 0; k < histogram.size(); ++k)
+	{
+		vector<Posting> & list = postings[histogram[k].first];
+		vector<Posting>::iterator p = list.begin();
+		while ((p < list.end()) && (p->image < index))
+			++p;
+
+		Posting posting = { index, histogram[k].second };
+		list.insert(p, posting);
+	}
+
+	imageNorms[index] = 0.0f;
+}
+
+void VocabularyTreeIndex::update()
+{
+	idf.assign(nWords, 0.0f);
+	imageNorms.assign(numImages, 0.0f);
+
+	for (int w = 0; w < nWords; ++w)
+	{
+		if (postings[w].size() > 0)
+			idf[w] = (float) log((double) numImages / (double) postings[w].size());
+
+		for (vector<Posting>::const_iterator p = postings[w].begin(); p < postings[w].end(); ++p)
+		{
+			float weight = p->count * idf[w];
+			imageNorms[p->image] += weight * weight;
+		}
+	}
+
+	for (unsigned int i = 0; i < numImages; ++i)
+		imageNorms[i] = sqrt(imageNorms[i]);
+}
+
+void VocabularyTreeIndex::clear()
+{
+	numImages = 0;
+	postings.assign(nWords, vector<Posting>());
+	idf.assign(nWords, 0.0f);
+	imageNorms.clear();
+}
+
+static bool cmpScoreIndexDescend(const pair<double,unsigned int> & pair1, const pair<double,unsigned int> & pair2)
+{
+	return (pair1.first > pair2.first) || ((pair1.first == pair2.first) && (pair1.second < pair2.second));
+}
+
+void VocabularyTreeIndex::query(const CompressedFeatureList & query, vector< pair<double,unsigned int> > & vImageScoresNumbers, size_t numRankedOutput) const
+{
+	vImageScoresNumbers.clear();
+	if (!isTrained() || (numImages == 0))
+		return;
+
+	vector< pair<int,unsigned int> > histogram;
+	quantize(query, histogram);
+
+	// accumulate the dot products of the tf-idf histograms, visiting only the images that share a word with the query
+	vector<float> scores(numImages, 0.0f);
+	double queryNorm = 0.0;
+	for (size_t k = 0; k < histogram.size(); ++k)
+	{
+		int w = histogram[k].first;
+		float queryWeight = histogram[k].second * idf[w];
+		queryNorm += queryWeight * queryWeight;
+
+		for (vector<Posting>::const_iterator p = postings[w].begin(); p < postings[w].end(); ++p)
+			scores[p->image] += queryWeight * (p->count * idf[w]);
+	}
+
+	if (queryNorm <= 0.0)
+		return;
+
+	queryNorm = sqrt(queryNorm);
+	for (unsigned int i = 0; i < numImages; ++i)
+	{
+		if ((scores[i] > 0) && (imageNorms[i] > 0))
+			vImageScoresNumbers.push_back(make_pair(scores[i] / (imageNorms[i] * queryNorm), i));
+	}
+
+	size_t numOut = min(numRankedOutput, vImageScoresNumbers.size());
+	partial_sort(vImageScoresNumbers.begin(), vImageScoresNumbers.begin() + numOut, vImageScoresNumbers.end(), cmpScoreIndexDescend);
+	vImageScoresNumbers.resize(numOut);
+}
+
+void VocabularyTreeIndex::write(string sIndexName) const
+{
+	FILE * file = fopen(sIndexName.c_str(), "wb");
+	if (file == NULL)
+		throw CdvsException(string("VocabularyTreeIndex::write - Error opening ").append(sIndexName));
+
+	try {
+		int header[2] = { nDims, nWords };
+		if (fwrite(header, sizeof(int), 2, file) != 2)
+			throw CdvsException("VocabularyTreeIndex::write - Error writing file");
+
+		writeVector(file, nodeFirst);
+		writeVector(file, nodeCount);
+		writeVector(file, centerNext);
+		writeVector(file, centers);
+
+		if (fwrite(&numImages, sizeof(numImages), 1, file) != 1)
+			throw CdvsException("VocabularyTreeIndex::write - Error writing file");
+
+		for (int w = 0; w < nWords; ++w)
+			writeVector(file, postings[w]);
+	}
+	catch(...)
+	{
+		fclose(file);
+		throw;
+	}
+
+	fclose(file);
+}
+
+void VocabularyTreeIndex::read(string sIndexName)
+{
+	FILE * file = fopen(sIndexName.c_str(), "rb");
+	if (file == NULL)
+		throw CdvsException(string("VocabularyTreeIndex::read - Error opening ").append(sIndexName));
+
+	try {
+		int header[2];
+		if (fread(header, sizeof(int), 2, file) != 2)
+			throw CdvsException("VocabularyTreeIndex::read - Error reading file");
+
+		nDims = header[0];
+		nWords = header[1];
+		readVector(file, nodeFirst);
+		readVector(file, nodeCount);
+		readVector(file, centerNext);
+		readVector(file, centers);
+
+		if ((nodeFirst.size() != nodeCount.size()) || (centers.size() != centerNext.size() * nDims))
+			throw CdvsException(string("VocabularyTreeIndex::read - Invalid file ").append(sIndexName));
+
+		if (fread(&numImages, sizeof(numImages), 1, file) != 1)
+			throw CdvsException("VocabularyTreeIndex::read - Error reading file");
+
+		postings.resize(nWords);
+		for (int w = 0; w < nWords; ++w)
+			readVector(file, postings[w]);
+	}
+	catch(...)
+	{
+		fclose(file);
+		nWords = 0;			// the index is not usable
+		throw;
+	}
+
+	fclose(file);
+	update();
+}
@@ -0,0 +1,144 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Joint Open Lab VISIBLE (Telecom Italia)
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <utility>
+#include "FeatureList.h"
+
+namespace mpeg7cdvs
+{
+
+/**
+ * @class VocabularyTreeIndex
+ * An inverted index of the local descriptors of the DB images, built on a vocabulary tree.
+ * The compressed descriptors are quantized into visual words by a tree trained with hierarchical integer k-means
+ * (vlfeat hikmeans) on their bits, where the L2 distance between unpacked bits is proportional to the Hamming distance.
+ * Images are scored against a query by the cosine similarity of their tf-idf weighted histograms of visual words.
+ * Images can be added to a trained index at any time; the weights are recomputed by update().
+ */
+class VocabularyTreeIndex
+{
+private:
+	/**
+	 * A posting of the inverted index: an image containing a visual word, and how many times.
+	 */
+	struct Posting
+	{
+		unsigned int image;		///< index of the image in the DB
+		unsigned int count;		///< number of features of the image quantized into the word
+	};
+
+	int nDims;								///< number of dimensions of the centers (descriptor bits)
+	int nWords;								///< number of visual words (leaves of the tree)
+	std::vector<int> nodeFirst;				///< index of the first center of each node
+	std::vector<int> nodeCount;				///< number of centers of each node
+	std::vector<int> centerNext;			///< child node of each center (>= 0), or its visual word w (as -1-w) if it is a leaf
+	std::vector<int> centers;				///< all centers, nDims values each
+
+	unsigned int numImages;					///< number of indexed images
+	std::vector< std::vector<Posting> > postings;		///< for each visual word, the images containing it
+	std::vector<float> idf;					///< inverse document frequency of each visual word
+	std::vector<float> imageNorms;			///< norm of the tf-idf histogram of each image
+
+	void quantize(const CompressedFeatureList & features, std::vector< std::pair<int,unsigned int> > & histogram) const;
+	void removePostings(unsigned int index);
+
+public:
+	VocabularyTreeIndex();		// constructor
+	//	default destructor, copy-constructor, assignment op are ok
+
+	/**
+	 * Train the vocabulary tree, discarding any previous vocabulary and indexed image.
+	 * @param images the images whose features are used for training (all must have the same descriptor size)
+	 * @param branching number of children of each node of the tree
+	 * @param depth number of levels of the tree; the vocabulary contains up to branching^depth visual words
+	 * @param maxTrainingFeatures max number of features used for training, evenly sampled from all images
+	 */
+	void train(const std::vector<CompressedFeatureList> & images, int branching, int depth, size_t maxTrainingFeatures);
+
+	/**
+	 * Tell if a vocabulary is available, i.e. if images can be added and queried.
+	 * @return true if the vocabulary tree has been trained or read from file.
+	 */
+	bool isTrained() const
+	{
+		return nWords > 0;
+	}
+
+	/**
+	 * Add an image at the end of the index. Its score is zero until update() is called.
+	 * @param features the compressed features of the image
+	 */
+	void addImage(const CompressedFeatureList & features);
+
+	/**
+	 * Replace the image at the given index. Its score is zero until update() is called.
+	 * @param index index of the image to replace
+	 * @param features the compressed features of the new image
+	 */
+	void replaceImage(unsigned int index, const CompressedFeatureList & features);
+
+	/**
+	 * Recompute the idf weights and the image norms after adding or replacing images.
+	 */
+	void update();
+
+	/**
+	 * Remove all images from the index, keeping the vocabulary.
+	 */
+	void clear();
+
+	/**
+	 * Get the number of images contained in this index.
+	 * @return the number of images.
+	 */
+	size_t numberImages() const
+	{
+		return numImages;
+	}
+
+	/**
+	 * Use the local descriptors of a query to retrieve a ranked list of the images containing the same visual words.
+	 * @param query the query features
+	 * @param vImageScoresNumbers the output list of (score, image index) pairs, in descending order of score
+	 * @param numRankedOutput the max number of output images
+	 */
+	void query(const CompressedFeatureList & query, std::vector< std::pair<double,unsigned int> > & vImageScoresNumbers, size_t numRankedOutput) const;
+
+	void write(std::string sIndexName) const;		///< write the vocabulary tree and the inverted index to file
+	void read(std::string sIndexName);				///< read the vocabulary tree and the inverted index from file (replacing the current ones)
+};
+
+}	// end of namespace
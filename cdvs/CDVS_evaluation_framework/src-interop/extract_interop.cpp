@@ -205,6 +205,7 @@ protected:
 	SCFVFactory g_factory;	///< global descriptor factory for the query
 	Parameters params;		///< parameters used by this client
 	int modeId;				///< the mode ID used by this client
+	std::vector<Parameters> modeParams;	///< parameters of all modes, used by encodeMulti()
 
 public:
 	SiftClient(const CdvsConfiguration * config, int mode) {
@@ -217,20 +218,47 @@ public:
 		params = config->getParameters(mode);
 		modeId = mode;
 		g_factory.init(params);					// initialize the global descriptor factory
+		for (int m = 0; m <= 6; ++m)
+			modeParams.push_back(config->getParameters(m));
 	}
 
 	virtual ~SiftClient() {};
 
 	virtual unsigned int encode(CdvsDescriptor & cdvsDescriptor, int width, int height, const unsigned char * buffer) const
+	{
+		return encode(cdvsDescriptor, width, height, buffer, width, height);
+	}
+
+	virtual unsigned int encode(CdvsDescriptor & cdvsDescriptor, int width, int height, const unsigned char * buffer, int originalWidth, int originalHeight) const
 	{
 		cdvsDescriptor.clear();		// erase old data
 
 		SiftDetector imagebuffer;
-		imagebuffer.read(width, height, buffer);
+		imagebuffer.read(width, height, buffer, originalWidth, originalHeight);
 		imagebuffer.resampleIfGreater(params.resizeMaxSize);
 		return cdvsDescriptor.encode(params, imagebuffer, g_factory);		// encode global and local descriptors
 	}
 
+	virtual unsigned int encodeMulti(std::vector<CdvsDescriptor> & outputs, const std::vector<int> & modes, int width, int height, const unsigned char * buffer, int originalWidth, int originalHeight) const
+	{
+		outputs.clear();
+		outputs.resize(modes.size());
+		unsigned int total = 0;
+		for (size_t i = 0; i < modes.size(); ++i)		// the SIFT detector is simply run once for each mode
+		{
+			if ((modes[i] < 0) || (modes[i] > 6))
+				throw CdvsException("Mode ID out of range! must be in the range [0..6]");
+
+			SCFVFactory factory;
+			factory.init(modeParams[modes[i]]);
+			SiftDetector imagebuffer;
+			imagebuffer.read(width, height, buffer, originalWidth, originalHeight);
+			imagebuffer.resampleIfGreater(modeParams[modes[i]].resizeMaxSize);
+			total += outputs[i].encode(modeParams[modes[i]], imagebuffer, factory);
+		}
+		return total;
+	}
+
 };
 
 
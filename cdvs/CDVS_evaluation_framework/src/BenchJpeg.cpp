@@ -0,0 +1,89 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy,
+ * distribute, and make derivative works of this software module or modifications thereof
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may
+ * infringe existing patents. ISO/IEC have no liability for use of this software module
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own
+ * purposes, assign or donate the code to a third party and to inhibit third parties
+ * from using the code for products that do not conform to MPEG-related
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2011.
+ *
+ */
+
+#include "BenchJpeg.h"
+#include <stdio.h>
+#include <string>
+#include <jpeglib.h>
+#include "CdvsException.h"
+
+using namespace std;
+using namespace mpeg7cdvs;
+
+/*
+ * Called by the JPEG library in case of error: throw an exception instead of exiting.
+ */
+static void jpegErrorExit(jpeg_common_struct * cinfo)
+{
+	throw CdvsException("JPEG decoding failed");
+}
+
+void readGrayJpeg(const char * fname, vector<unsigned char> & pixels, int & width, int & height)
+{
+	FILE * file = fopen(fname, "rb");
+	if (file == NULL)
+		throw CdvsException(string("cannot open image ").append(fname));
+
+	struct jpeg_decompress_struct cinfo;
+	struct jpeg_error_mgr jerr;
+	cinfo.err = jpeg_std_error(&jerr);
+	jerr.error_exit = jpegErrorExit;
+
+	try {
+		jpeg_create_decompress(&cinfo);
+		jpeg_stdio_src(&cinfo, file);
+		jpeg_read_header(&cinfo, TRUE);
+		if (cinfo.jpeg_color_space == JCS_CMYK)
+			throw CdvsException(string("CMYK color space not supported"));
+
+		cinfo.out_color_space = JCS_GRAYSCALE;
+		jpeg_start_decompress(&cinfo);
+		width = cinfo.output_width;
+		height = cinfo.output_height;
+		pixels.resize((size_t) width * height);
+		while (cinfo.output_scanline < cinfo.output_height)
+		{
+			JSAMPROW row = &pixels[(size_t) cinfo.output_scanline * width];
+			jpeg_read_scanlines(&cinfo, &row, 1);
+		}
+		jpeg_finish_decompress(&cinfo);
+	}
+	catch (...)
+	{
+		jpeg_destroy_decompress(&cinfo);
+		fclose(file);
+		throw;
+	}
+
+	jpeg_destroy_decompress(&cinfo);
+	fclose(file);
+}
@@ -0,0 +1,380 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as 
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy, 
+ * distribute, and make derivative works of this software module or modifications thereof 
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may 
+ * infringe existing patents. ISO/IEC have no liability for use of this software module 
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own 
+ * purposes, assign or donate the code to a third party and to inhibit third parties 
+ * from using the code for products that do not conform to MPEG-related 
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <vector>
+#include "CdvsInterface.h"
+#include "FileManager.h"
+#include "map.h"
+#include "CdvsException.h"
+#include "BenchJpeg.h"
+
+#if !defined(__GLIBC__)
+#error benchAllocations interposes the allocator of the GNU C library
+#endif
+
+using namespace std;
+using namespace mpeg7cdvs;
+
+static volatile unsigned long numAllocations = 0;		// number of heap allocations since the start of the program
+static volatile unsigned long numAllocatedBytes = 0;	// number of bytes allocated since the start of the program
+
+static inline void countAllocation(size_t size)
+{
+	__sync_fetch_and_add(&numAllocations, 1UL);
+	__sync_fetch_and_add(&numAllocatedBytes, (unsigned long) size);
+}
+
+// Count every heap allocation of the process (including Eigen and the C library) by interposing the glibc allocator
+// (this program is built only if the C library is glibc).
+
+extern "C" {
+
+void * __libc_malloc(size_t size);
+void * __libc_calloc(size_t n, size_t size);
+void * __libc_realloc(void * ptr, size_t size);
+void * __libc_memalign(size_t alignment, size_t size);
+
+void * malloc(size_t size)
+{
+	countAllocation(size);
+	return __libc_malloc(size);
+}
+
+void * calloc(size_t n, size_t size)
+{
+	countAllocation(n * size);
+	return __libc_calloc(n, size);
+}
+
+void * realloc(void * ptr, size_t size)
+{
+	countAllocation(size);
+	return __libc_realloc(ptr, size);
+}
+
+void * memalign(size_t alignment, size_t size)
+{
+	countAllocation(size);
+	return __libc_memalign(alignment, size);
+}
+
+void * aligned_alloc(size_t alignment, size_t size)
+{
+	countAllocation(size);
+	return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void ** ptr, size_t alignment, size_t size)
+{
+	countAllocation(size);
+	*ptr = __libc_memalign(alignment, size);
+	return (*ptr == NULL) ? ENOMEM : 0;
+}
+
+}	// extern "C"
+
+/**
+ * Allocation counters of a group of calls.
+ */
+class AllocationStats {
+public:
+	unsigned long calls;		///< number of calls
+	unsigned long count;		///< number of heap allocations
+	unsigned long bytes;		///< number of allocated bytes
+
+	AllocationStats():calls(0), count(0), bytes(0) {}
+
+	void print(const char * name) const
+	{
+		printf ("%-28s %8lu %14.1f %16.1f\n", name, calls, (double) count / std::max(calls, 1UL), (double) bytes / std::max(calls, 1UL));
+	}
+};
+
+/**
+ * Helper class counting the allocations done during its lifetime.
+ */
+class AllocationCounter {
+private:
+	AllocationStats & stats;
+	unsigned long count;
+	unsigned long bytes;
+
+public:
+	AllocationCounter(AllocationStats & s):stats(s), count(numAllocations), bytes(numAllocatedBytes) {}
+
+	~AllocationCounter()
+	{
+		stats.calls++;
+		stats.count += numAllocations - count;
+		stats.bytes += numAllocatedBytes - bytes;
+	}
+};
+
+int numRounds = 3;		// default number of times each query is repeated
+
+/**
+ * Count the heap allocations of descriptor extraction.
+ * Each image is decoded outside of the measured call, so only CdvsClient::encode() is counted.
+ * @param client the CDVS client
+ * @param manager the file manager, with the query annotation loaded
+ * @param nqueries the number of query images
+ */
+void bench_encode_allocations(const CdvsClient * client, FileManager & manager, size_t nqueries)
+{
+	vector<unsigned char> pixels;
+	int width = 0, height = 0;
+
+	printf ("%-28s %8s %14s %16s\n", "", "calls", "allocs/call", "bytes/call");
+
+	for (int round = 0; round < numRounds; ++round)
+	{
+		AllocationStats encodeStats;
+
+		for (size_t q = 0; q < nqueries; ++q)
+		{
+			readGrayJpeg(manager.getAbsolutePathname(q).c_str(), pixels, width, height);
+
+			CdvsDescriptor descriptor;
+			{
+				AllocationCounter counter(encodeStats);
+				client->encode(descriptor, width, height, pixels.data());
+			}
+		}
+
+		printf ("round %d:\n", round + 1);
+		encodeStats.print("  encode");
+	}
+}
+
+/**
+ * Count the heap allocations of retrieval and matching.
+ * @param server the CDVS server, with the DB loaded
+ * @param queries the query descriptors
+ */
+void bench_allocations(const CdvsServer * server, const vector<CdvsDescriptor> & queries)
+{
+	vector<RetrievalData> results;
+	results.reserve(MAX_MATCHES);
+	PointPairs reusedPairs;
+	CDVSPOINT proj_bbox[4];
+
+	printf ("%-28s %8s %14s %16s\n", "", "calls", "allocs/call", "bytes/call");
+
+	for (int round = 0; round < numRounds; ++round)
+	{
+		AllocationStats retrieveStats, matchStats, reusedMatchStats, localizeStats;
+
+		for (size_t q = 0; q < queries.size(); ++q)
+		{
+			results.clear();
+			{
+				AllocationCounter counter(retrieveStats);
+				server->retrieve(results, queries[q], MAX_MATCHES);
+			}
+
+			if (results.empty())
+				continue;
+
+			{
+				AllocationCounter counter(matchStats);
+				PointPairs pairs = server->match(queries[q], results[0].index, NULL, NULL, MATCH_TYPE_LOCAL);
+			}
+
+			{
+				AllocationCounter counter(reusedMatchStats);
+				server->match(reusedPairs, queries[q], results[0].index, NULL, NULL, MATCH_TYPE_LOCAL);
+			}
+
+			{
+				AllocationCounter counter(localizeStats);
+				server->match(reusedPairs, queries[q], results[0].index, NULL, proj_bbox, MATCH_TYPE_LOCAL);
+			}
+		}
+
+		printf ("round %d:\n", round + 1);
+		retrieveStats.print("  retrieve");
+		matchStats.print("  match (returned pairs)");
+		reusedMatchStats.print("  match (reused pairs)");
+		localizeStats.print("  match + localization");
+	}
+}
+
+void usage()
+{
+	fprintf (stdout,
+		"CDVS allocation counting module.\n"
+		"usage:\n"
+		"  benchAllocations <index> <queries> <mode> <datasetPath> <annotationPath> [-o] [-e] [-p paramfile] [-rounds n] [-h]\n"
+		"where:\n"
+		"  index - database index file to be used for retrieval\n"
+		"  queries - text file containing the query images (the first image of each line is used)\n"
+		"  mode (0..n) - sets the encoding mode of the query descriptors\n"
+		"  dataset path - the root dir of the CDVS dataset of images\n"
+		"  annotation path - the root dir of the CDVS annotation files\n"
+		"options:\n"
+		"  -o: use one-way matching (instead of two-way matching which is the default)\n"
+		"  -e: also count the allocations of the extraction of the query descriptors from the query images\n"
+		"  -p paramfile: text file containing initialization parameters for all modes\n"
+		"  -rounds n: number of times all queries are repeated (default 3)\n"
+		"  -help or -h: help\n");
+	exit (1);
+}
+
+/**
+ * @file
+ * benchAllocations: CDVS allocation counting module.
+ * Counts the heap allocations made by each retrieval and matching call, repeating all queries several times:
+ * the last rounds show the steady state of a server that keeps answering queries.
+ * Optionally, the allocations of the extraction of the query descriptors are counted in the same way.
+ * @verbatim
+
+  CDVS allocation counting module.
+	usage:
+		benchAllocations <index> <queries> <mode> <datasetPath> <annotationPath> [-o] [-e] [-p paramfile] [-rounds n] [-h]
+	where:
+		index - database index file to be used for retrieval
+		queries - text file containing the query images (the first image of each line is used)
+		mode (0..n) - sets the encoding mode of the query descriptors
+		dataset path - the root dir of the CDVS dataset of images
+		annotation path - the root dir of the CDVS annotation files
+	options:
+		-o: use one-way matching (instead of two-way matching which is the default)
+		-e: also count the allocations of the extraction of the query descriptors from the query images
+		-p paramfile: text file containing initialization parameters for all modes
+		-rounds n: number of times all queries are repeated (default 3)
+		-help or -h: help
+
+ @endverbatim
+ */
+
+int run_bench_allocations(int argc, char *argv[])
+{
+	// argv 0             1        2        3         4              5
+	// benchAllocations <index> <queries> <mode> <datasetPath> <annotationPath> [-o] [-e] [-p paramfile] [-rounds n] [-h]
+
+	const char * paramfile = NULL;	// default: no parameters file
+	bool useTwoWayMatching = true;
+	bool benchEncode = false;
+
+	/* check if sufficient # of arguments were provided: */
+	if (argc < 6)
+		usage();
+
+	for (int i=6; i<argc; i++)
+	{
+		if (argv[i][0] != '-')
+		{
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+		/* check option names: */
+		if (!strcmp (argv[i]+1,"help") || !strcmp (argv[i]+1,"h") || !strcmp (argv[i]+1,"H")) {
+			usage();		/* display help: */
+		}
+		else if (!strcmp (argv[i]+1,"o")) {
+			useTwoWayMatching = false;
+		}
+		else if (!strcmp (argv[i]+1,"e")) {
+			benchEncode = true;
+		}
+		else if (!strcmp (argv[i]+1,"p") && (i+1 < argc)) {
+			paramfile = argv[++i];
+		}
+		else if (!strcmp (argv[i]+1,"rounds") && (i+1 < argc)) {
+			numRounds = std::max(1, atoi(argv[++i]));
+		}
+		else {
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+	}
+
+	const char * dbname = argv[1];
+	const char * queriesname = argv[2];
+	int mode = atoi(argv[3]);
+	const char * datasetPath = argv[4];
+	const char * annotationPath = argv[5];
+
+	FileManager manager;
+	manager.setAnnotationPath(annotationPath);
+	size_t nqueries = manager.readAnnotation(queriesname);
+	manager.setDatasetPath(datasetPath);
+
+	/* create an instance of CdvsServer */
+	CdvsConfiguration * cdvsconfig = CdvsConfiguration::cdvsConfigurationFactory(paramfile);	// if paramfile == NULL use default values
+	CdvsServer * cdvsserver = CdvsServer::cdvsServerFactory(cdvsconfig, useTwoWayMatching);
+	const char * ext = cdvsconfig->getParameters(mode).modeExt;
+
+	string databasename = string(datasetPath) + "/" + dbname;
+	cdvsserver->loadDB(string(databasename).append(".local").c_str(), string(databasename).append(".global").c_str());
+	cout << cdvsserver->sizeofDB() << " images loaded." << endl;
+
+	/* decode all queries in advance: only retrieval and matching are measured */
+	vector<CdvsDescriptor> queries(nqueries);
+	for (size_t i = 0; i < nqueries; ++i)
+		cdvsserver->decode(queries[i], manager.replaceExt(manager.getAbsolutePathname(i), ext).c_str());
+
+	bench_allocations(cdvsserver, queries);
+
+	if (benchEncode)
+	{
+		CdvsClient * cdvsclient = CdvsClient::cdvsClientFactory(cdvsconfig, mode);
+		bench_encode_allocations(cdvsclient, manager, nqueries);
+		delete cdvsclient;
+	}
+
+	delete cdvsserver;
+	delete cdvsconfig;
+
+	return 0;
+}
+
+//  ----- main -------
+
+int main(int argc, char *argv[])
+{
+	try {
+		run_bench_allocations(argc, argv);		// run "benchAllocations" catching any exception
+	}
+	catch(exception & ex)				// catch any exception, including CdvsException
+	{
+		cerr << argv[0] << " exception: " << ex.what() << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,278 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as 
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy, 
+ * distribute, and make derivative works of this software module or modifications thereof 
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may 
+ * infringe existing patents. ISO/IEC have no liability for use of this software module 
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own 
+ * purposes, assign or donate the code to a third party and to inhibit third parties 
+ * from using the code for products that do not conform to MPEG-related 
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "CdvsInterface.h"
+#include "AlpDetector.h"
+#include "AlpOctave.h"
+#include "FileManager.h"
+#include "CdvsException.h"
+#include "BenchJpeg.h"
+#include "HiResTimer.h"
+
+using namespace std;
+using namespace mpeg7cdvs;
+
+int numRounds = 3;				// default number of times each image is processed with each implementation
+
+static const char * implementationNames[] = {"scalar", "sse2", "avx", "avx2"};
+
+/**
+ * Detect and describe the keypoints of an image.
+ * @param pixels the grayscale image
+ * @param width the image width
+ * @param height the image height
+ * @param params the parameters of the encoding mode
+ * @param features the output features, in descending order of importance
+ * @return the detection and description time in seconds
+ */
+double describe(const vector<unsigned char> & pixels, int width, int height, const Parameters & params, vector<Feature> & features)
+{
+	HiResTimer timer;
+	timer.start();
+
+	AlpDetector detector;
+	detector.read(width, height, pixels.data());
+	detector.resampleIfGreater(params.resizeMaxSize);
+
+	FeatureList featurelist;
+	detector.detect(featurelist, params);
+	detector.extract(featurelist, params.selectMaxPoints);
+
+	timer.stop();
+	features.swap(featurelist.features);
+	return timer.elapsed();
+}
+
+/**
+ * Check if two features are identical (position, scale, orientation, peak, curvatures and descriptor).
+ * @param a the first feature
+ * @param b the second feature
+ * @return true if they are identical
+ */
+bool sameFeature(const Feature & a, const Feature & b)
+{
+	return (a.x == b.x) && (a.y == b.y) && (a.scale == b.scale) && (a.orientation == b.orientation)
+		&& (a.peak == b.peak) && (a.curvRatio == b.curvRatio) && (a.curvSigma == b.curvSigma) && (a.pdf == b.pdf)
+		&& (memcmp(a.descr, b.descr, sizeof(a.descr)) == 0);
+}
+
+/**
+ * Count the features that differ between two lists (features are compared in order).
+ * @param reference the reference features
+ * @param test the test features
+ * @return the number of differences (the missing or extra features count as differences)
+ */
+size_t countDifferences(const vector<Feature> & reference, const vector<Feature> & test)
+{
+	size_t common = std::min(reference.size(), test.size());
+	size_t differences = std::max(reference.size(), test.size()) - common;
+	for (size_t i = 0; i < common; ++i)
+		if (! sameFeature(reference[i], test[i]))
+			++differences;
+	return differences;
+}
+
+/**
+ * Compare the keypoints and the speed of the scalar and SIMD implementations of the AlpOctave smoothing (conv2) and gradient kernels.
+ * @param manager the file manager, with the image annotation loaded
+ * @param nImages the number of images
+ * @param params the parameters of the encoding mode
+ * @return the number of images whose keypoints differ from the scalar ones with at least one implementation
+ */
+size_t bench_alp_octave(const FileManager & manager, size_t nImages, const Parameters & params)
+{
+	const int best = AlpOctave::getImplementation();
+	const int nImpl = best + 1;
+	vector<unsigned char> pixels;
+	int width = 0, height = 0;
+	vector<Feature> reference, features;
+	vector<double> times(nImpl, 0.0);
+	vector<size_t> differences(nImpl, 0);
+	size_t numFeatures = 0, failedImages = 0;
+
+	for (size_t i = 0; i < nImages; ++i)
+	{
+		readGrayJpeg(manager.getAbsolutePathname(i).c_str(), pixels, width, height);
+		bool failed = false;
+
+		for (int impl = AlpOctave::SCALAR; impl < nImpl; ++impl)
+		{
+			AlpOctave::setImplementation(impl);
+			for (int round = 0; round < numRounds; ++round)
+				times[impl] += describe(pixels, width, height, params, (impl == AlpOctave::SCALAR) ? reference : features);
+
+			if (impl != AlpOctave::SCALAR)
+			{
+				size_t diff = countDifferences(reference, features);
+				if (diff > 0)
+				{
+					fprintf(stderr, "%s: %s keypoints differ from the scalar ones (%zu of %zu)\n", manager.getRelativePathname(i).c_str(), implementationNames[impl], diff, reference.size());
+					differences[impl] += diff;
+					failed = true;
+				}
+			}
+		}
+
+		numFeatures += reference.size();
+		if (failed)
+			++failedImages;
+	}
+
+	AlpOctave::setImplementation(best);
+
+	double runs = (double) std::max(nImages * numRounds, (size_t) 1);
+	printf ("%-10s %12s %12s %16s\n", "kernels", "total ms", "speedup", "differences");
+	for (int impl = AlpOctave::SCALAR; impl < nImpl; ++impl)
+		printf ("%-10s %12.2f %12.2f %16zu\n", implementationNames[impl], 1e3 * times[impl] / runs, times[AlpOctave::SCALAR] / std::max(times[impl], 1e-9), differences[impl]);
+	printf ("%zu features/image, %zu of %zu images differ from the scalar kernels\n", numFeatures / std::max(nImages, (size_t) 1), failedImages, nImages);
+
+	return failedImages;
+}
+
+void usage()
+{
+	fprintf (stdout,
+		"CDVS ALP octave kernels check and benchmark module.\n"
+		"usage:\n"
+		"  benchAlpOctave <images> <mode> <datasetPath> <annotationPath> [-p paramfile] [-rounds n] [-h]\n"
+		"where:\n"
+		"  images - text file containing the images (the first image of each line is used)\n"
+		"  mode (0..n) - sets the encoding mode (resize and number of features)\n"
+		"  dataset path - the root dir of the CDVS dataset of images\n"
+		"  annotation path - the root dir of the CDVS annotation files\n"
+		"options:\n"
+		"  -p paramfile: text file containing initialization parameters for all modes\n"
+		"  -rounds n: number of times each image is processed with each implementation (default 3)\n"
+		"  -help or -h: help\n");
+	exit (1);
+}
+
+/**
+ * @file
+ * benchAlpOctave: CDVS ALP octave kernels check and benchmark module.
+ * Extracts the keypoints of the given images with every implementation of the AlpOctave smoothing (conv2)
+ * and gradient kernels supported by the CPU, checks that they are identical to the keypoints extracted with the scalar
+ * kernels, and compares the extraction times. The exit status is 1 if any keypoint differs.
+ * @verbatim
+
+  CDVS ALP octave kernels check and benchmark module.
+	usage:
+		benchAlpOctave <images> <mode> <datasetPath> <annotationPath> [-p paramfile] [-rounds n] [-h]
+	where:
+		images - text file containing the images (the first image of each line is used)
+		mode (0..n) - sets the encoding mode (resize and number of features)
+		dataset path - the root dir of the CDVS dataset of images
+		annotation path - the root dir of the CDVS annotation files
+	options:
+		-p paramfile: text file containing initialization parameters for all modes
+		-rounds n: number of times each image is processed with each implementation (default 3)
+		-help or -h: help
+
+ @endverbatim
+ */
+
+int run_bench_alp_octave(int argc, char *argv[])
+{
+	// argv 0           1        2        3             4
+	// benchAlpOctave <images> <mode> <datasetPath> <annotationPath> [-p paramfile] [-rounds n] [-h]
+
+	const char * paramfile = NULL;	// default: no parameters file
+
+	/* check if sufficient # of arguments were provided: */
+	if (argc < 5)
+		usage();
+
+	for (int i=5; i<argc; i++)
+	{
+		if (argv[i][0] != '-')
+		{
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+		/* check option names: */
+		if (!strcmp (argv[i]+1,"help") || !strcmp (argv[i]+1,"h") || !strcmp (argv[i]+1,"H")) {
+			usage();		/* display help: */
+		}
+		else if (!strcmp (argv[i]+1,"p") && (i+1 < argc)) {
+			paramfile = argv[++i];
+		}
+		else if (!strcmp (argv[i]+1,"rounds") && (i+1 < argc)) {
+			numRounds = std::max(1, atoi(argv[++i]));
+		}
+		else {
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+	}
+
+	const char * imagesname = argv[1];
+	int mode = atoi(argv[2]);
+	const char * datasetPath = argv[3];
+	const char * annotationPath = argv[4];
+
+	FileManager manager;
+	manager.setAnnotationPath(annotationPath);
+	size_t nImages = manager.readAnnotation(imagesname);
+	manager.setDatasetPath(datasetPath);
+
+	CdvsConfiguration * cdvsconfig = CdvsConfiguration::cdvsConfigurationFactory(paramfile);	// if paramfile == NULL use default values
+	Parameters params = cdvsconfig->getParameters(mode);
+	params.extractionThreads = 1;		// time the serial extraction
+
+	size_t failedImages = bench_alp_octave(manager, nImages, params);
+
+	delete cdvsconfig;
+
+	return (failedImages > 0) ? 1 : 0;
+}
+
+//  ----- main -------
+
+int main(int argc, char *argv[])
+{
+	try {
+		return run_bench_alp_octave(argc, argv);		// run "benchAlpOctave" catching any exception
+	}
+	catch(exception & ex)				// catch any exception, including CdvsException
+	{
+		cerr << argv[0] << " exception: " << ex.what() << endl;
+	}
+
+	return 1;
+}
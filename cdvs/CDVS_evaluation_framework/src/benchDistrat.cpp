@@ -0,0 +1,281 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as 
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy, 
+ * distribute, and make derivative works of this software module or modifications thereof 
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may 
+ * infringe existing patents. ISO/IEC have no liability for use of this software module 
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own 
+ * purposes, assign or donate the code to a third party and to inhibit third parties 
+ * from using the code for products that do not conform to MPEG-related 
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "DistratEigen.h"
+#include "DistratReference.h"
+#include "CdvsException.h"
+#include "HiResTimer.h"
+
+using namespace std;
+
+int numRounds = 1000;				// default number of random sets of matched points
+int maxPoints = 300;				// default max number of matched points in a set
+unsigned int seed = 1;				// default seed of the random points
+
+static const unsigned int percentiles[] = {99, 98, 97, 96, 95};
+
+/**
+ * Get a random number uniformly distributed in [low, high).
+ */
+static float uniform(float low, float high)
+{
+	return low + (high - low) * (float) rand() / ((float) RAND_MAX + 1.0f);
+}
+
+/**
+ * Get a random number normally distributed (Box-Muller).
+ */
+static float gaussian(float sigma)
+{
+	float u1 = uniform(1e-6f, 1.0f);
+	float u2 = uniform(0.0f, 1.0f);
+	return sigma * sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+/**
+ * Create a random set of matched points: a random fraction of the pairs is related by a similarity transform
+ * (the inliers) and the other pairs are random. Some sets have integer coordinates or repeated points,
+ * which produce zero distances and equal ratios.
+ */
+static void randomPairs(int nPoints, vector<float> & x1, vector<float> & x2, vector<float> & y1, vector<float> & y2)
+{
+	x1.resize(nPoints);
+	x2.resize(nPoints);
+	y1.resize(nPoints);
+	y2.resize(nPoints);
+
+	float inlierRatio = uniform(0.0f, 1.0f);
+	float scale = uniform(0.5f, 2.0f);
+	float angle = uniform(-3.1415926f, 3.1415926f);
+	float tx = uniform(-200.0f, 200.0f);
+	float ty = uniform(-200.0f, 200.0f);
+	float sigma = uniform(0.0f, 3.0f);
+	bool integer = (rand() % 4 == 0);
+	bool repeated = (rand() % 4 == 0);
+
+	for (int i = 0; i < nPoints; ++i)
+	{
+		x1[i] = uniform(0.0f, 640.0f);
+		x2[i] = uniform(0.0f, 480.0f);
+		if (uniform(0.0f, 1.0f) < inlierRatio)
+		{
+			y1[i] = scale * (cosf(angle) * x1[i] - sinf(angle) * x2[i]) + tx + gaussian(sigma);
+			y2[i] = scale * (sinf(angle) * x1[i] + cosf(angle) * x2[i]) + ty + gaussian(sigma);
+		}
+		else
+		{
+			y1[i] = uniform(0.0f, 640.0f);
+			y2[i] = uniform(0.0f, 480.0f);
+		}
+
+		if (repeated && (i > 0) && (rand() % 8 == 0))
+		{
+			int j = rand() % i;		// repeat a point of either image, or a whole pair
+			switch (rand() % 3)
+			{
+				case 0:	x1[i] = x1[j]; x2[i] = x2[j]; break;
+				case 1:	y1[i] = y1[j]; y2[i] = y2[j]; break;
+				default: x1[i] = x1[j]; x2[i] = x2[j]; y1[i] = y1[j]; y2[i] = y2[j]; break;
+			}
+		}
+
+		if (integer)
+		{
+			x1[i] = floorf(x1[i]);
+			x2[i] = floorf(x2[i]);
+			y1[i] = floorf(y1[i]);
+			y2[i] = floorf(y2[i]);
+		}
+	}
+}
+
+/**
+ * Compare speed and results of DistratEigen and of the reference implementation on random sets of matched points.
+ * @return the number of mismatches
+ */
+size_t bench_distrat()
+{
+	vector<float> x1, x2, y1, y2;
+	vector<int> referenceIndexes(maxPoints), fastIndexes(maxPoints);
+	DistratEigen fast;						// reused, as in retrieval
+	double referenceTime[2] = {0, 0}, fastTime[2] = {0, 0};
+	size_t numRuns[2] = {0, 0}, numPoints[2] = {0, 0}, numInliers = 0, mismatches = 0;
+	float maxGoFDifference = 0;
+	HiResTimer timer;
+
+	srand(seed);
+	for (int round = 0; round < numRounds; ++round)
+	{
+		int nPoints = 1 + rand() % maxPoints;
+		randomPairs(nPoints, x1, x2, y1, y2);
+
+		for (int parametric = 0; parametric < 2; ++parametric)
+		{
+			unsigned int percentile = percentiles[rand() % (sizeof(percentiles) / sizeof(percentiles[0]))];
+
+			timer.start();
+			DistratReference reference(&x1[0], &x2[0], &y1[0], &y2[0], nPoints);
+			int referenceInliers = reference.estimateInliers(parametric != 0, true, percentile, &referenceIndexes[0]);
+			timer.stop();
+			referenceTime[parametric] += timer.elapsed();
+
+			timer.start();
+			fast.setPoints(&x1[0], &x2[0], &y1[0], &y2[0], nPoints);
+			int fastInliers = fast.estimateInliers(parametric != 0, true, percentile, &fastIndexes[0]);
+			timer.stop();
+			fastTime[parametric] += timer.elapsed();
+
+			++numRuns[parametric];
+			numPoints[parametric] += nPoints;
+			numInliers += referenceInliers;
+
+			if ((fastInliers != referenceInliers) || !equal(referenceIndexes.begin(), referenceIndexes.begin() + referenceInliers, fastIndexes.begin()))
+			{
+				++mismatches;
+				fprintf (stderr, "round %d: %d points, %s, percentile %u: %d inliers instead of %d\n", round, nPoints,
+						parametric ? "parametric" : "nonparametric", percentile, fastInliers, referenceInliers);
+			}
+			else if ((nPoints >= 5) && (fast.m_bFitIsGood != reference.m_bFitIsGood))
+			{
+				++mismatches;
+				fprintf (stderr, "round %d: %d points, %s, percentile %u: different goodness of fit\n", round, nPoints,
+						parametric ? "parametric" : "nonparametric", percentile);
+			}
+
+			if (nPoints >= 5)
+				maxGoFDifference = std::max(maxGoFDifference, fabsf(fast.m_c - reference.m_c));
+		}
+	}
+
+	static const char * names[] = {"nonparam", "param"};
+	printf ("%-12s %12s %12s %12s %10s\n", "distrat", "avg points", "ref us/call", "new us/call", "speedup");
+	for (int p = 0; p < 2; ++p)
+	{
+		double runs = (double) std::max(numRuns[p], (size_t) 1);
+		printf ("%-12s %12.1f %12.1f %12.1f %10.2f\n", names[p], numPoints[p] / runs, 1e6 * referenceTime[p] / runs, 1e6 * fastTime[p] / runs,
+				referenceTime[p] / std::max(fastTime[p], 1e-9));
+	}
+	printf ("%zu inliers found, max difference of the goodness of fit statistic: %g\n", numInliers, maxGoFDifference);
+	printf ("%s: %zu mismatches\n", (mismatches == 0) ? "passed" : "FAILED", mismatches);
+	return mismatches;
+}
+
+void usage()
+{
+	fprintf (stdout,
+		"CDVS DISTRAT check and benchmark module.\n"
+		"usage:\n"
+		"  benchDistrat [-rounds n] [-points n] [-seed n] [-h]\n"
+		"options:\n"
+		"  -rounds n: number of random sets of matched points (default 1000)\n"
+		"  -points n: max number of matched points in a set (default 300)\n"
+		"  -seed n: seed of the random points (default 1)\n"
+		"  -help or -h: help\n");
+	exit (1);
+}
+
+/**
+ * @file
+ * benchDistrat: CDVS DISTRAT check and benchmark module.
+ * Compares DistratEigen with the scalar implementation it replaced (DistratReference) on random sets of matched points,
+ * with a random fraction of inliers, in the parametric and nonparametric versions: time per call, number and indexes of the inliers,
+ * and result of the goodness of fit. Exits with status 1 if any mismatch is found.
+ * @verbatim
+
+  CDVS DISTRAT check and benchmark module.
+	usage:
+		benchDistrat [-rounds n] [-points n] [-seed n] [-h]
+	options:
+		-rounds n: number of random sets of matched points (default 1000)
+		-points n: max number of matched points in a set (default 300)
+		-seed n: seed of the random points (default 1)
+		-help or -h: help
+
+ @endverbatim
+ */
+
+int run_bench_distrat(int argc, char *argv[])
+{
+	// argv 0
+	// benchDistrat [-rounds n] [-points n] [-seed n] [-h]
+
+	for (int i=1; i<argc; i++)
+	{
+		if (argv[i][0] != '-')
+		{
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+		/* check option names: */
+		if (!strcmp (argv[i]+1,"help") || !strcmp (argv[i]+1,"h") || !strcmp (argv[i]+1,"H")) {
+			usage();		/* display help: */
+		}
+		else if (!strcmp (argv[i]+1,"rounds") && (i+1 < argc)) {
+			numRounds = std::max(1, atoi(argv[++i]));
+		}
+		else if (!strcmp (argv[i]+1,"points") && (i+1 < argc)) {
+			maxPoints = std::max(1, atoi(argv[++i]));
+		}
+		else if (!strcmp (argv[i]+1,"seed") && (i+1 < argc)) {
+			seed = (unsigned int) atoi(argv[++i]);
+		}
+		else {
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+	}
+
+	return (bench_distrat() == 0) ? 0 : 1;
+}
+
+//  ----- main -------
+
+int main(int argc, char *argv[])
+{
+	try {
+		return run_bench_distrat(argc, argv);		// run "benchDistrat" catching any exception
+	}
+	catch(exception & ex)				// catch any exception, including CdvsException
+	{
+		cerr << argv[0] << " exception: " << ex.what() << endl;
+	}
+
+	return 1;
+}
@@ -0,0 +1,285 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as 
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy, 
+ * distribute, and make derivative works of this software module or modifications thereof 
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may 
+ * infringe existing patents. ISO/IEC have no liability for use of this software module 
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own 
+ * purposes, assign or donate the code to a third party and to inhibit third parties 
+ * from using the code for products that do not conform to MPEG-related 
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "CdvsInterface.h"
+#include "AlpDetector.h"
+#include "AlpDetectorFixed.h"
+#include "FileManager.h"
+#include "CdvsException.h"
+#include "BenchJpeg.h"
+#include "HiResTimer.h"
+
+using namespace std;
+using namespace mpeg7cdvs;
+
+int numRounds = 3;				// default number of times each image is processed by each detector
+float maxDistance = 1.5f;		// default max distance (in pixels) of repeated keypoints
+float maxScaleRatio = 1.25f;	// default max ratio of the scales of repeated keypoints
+
+/**
+ * Detect and describe the keypoints of an image.
+ * @param detector the detector, with the image already read and resampled
+ * @param params the parameters of the encoding mode
+ * @param features the output features, in descending order of importance
+ * @param detectTime the detection time in seconds (incremented)
+ * @param extractTime the description time in seconds (incremented)
+ */
+void describe(AbstractDetector & detector, const Parameters & params, vector<Feature> & features, double & detectTime, double & extractTime)
+{
+	FeatureList featurelist;
+	HiResTimer timer;
+	timer.start();
+	detector.detect(featurelist, params);
+	timer.stop();
+	detectTime += timer.elapsed();
+
+	timer.start();
+	detector.extract(featurelist, params.selectMaxPoints);
+	timer.stop();
+	extractTime += timer.elapsed();
+
+	features.swap(featurelist.features);
+}
+
+/**
+ * Count the reference features that are repeated in the test features (same position and scale, within the tolerances).
+ * @param reference the reference features
+ * @param test the test features
+ * @param positionError the sum of the position errors of the repeated features (incremented)
+ * @return the number of repeated features
+ */
+size_t countRepeated(const vector<Feature> & reference, const vector<Feature> & test, double & positionError)
+{
+	size_t repeated = 0;
+	for (size_t i = 0; i < reference.size(); ++i)
+	{
+		const Feature & r = reference[i];
+		float best = maxDistance * maxDistance;
+		bool found = false;
+		for (size_t j = 0; j < test.size(); ++j)
+		{
+			const Feature & t = test[j];
+			float ratio = t.scale / r.scale;
+			float d2 = (t.x - r.x) * (t.x - r.x) + (t.y - r.y) * (t.y - r.y);
+			if ((d2 <= best) && (ratio <= maxScaleRatio) && (ratio * maxScaleRatio >= 1.0f))
+			{
+				best = d2;
+				found = true;
+			}
+		}
+
+		if (found)
+		{
+			++repeated;
+			positionError += sqrt(best);
+		}
+	}
+	return repeated;
+}
+
+/**
+ * Compare speed and keypoints of the floating point and of the fixed-point ALP detectors.
+ * @param manager the file manager, with the image annotation loaded
+ * @param nImages the number of images
+ * @param params the parameters of the encoding mode
+ */
+void bench_fixed_point(const FileManager & manager, size_t nImages, const Parameters & params)
+{
+	vector<unsigned char> pixels;
+	int width = 0, height = 0;
+	vector<Feature> floatFeatures, fixedFeatures;
+
+	double floatDetect = 0, floatExtract = 0, fixedDetect = 0, fixedExtract = 0, positionError = 0;
+	size_t numFloat = 0, numFixed = 0, numRepeated = 0;
+
+	for (size_t i = 0; i < nImages; ++i)
+	{
+		readGrayJpeg(manager.getAbsolutePathname(i).c_str(), pixels, width, height);
+
+		for (int round = 0; round < numRounds; ++round)
+		{
+			AlpDetector floatDetector;
+			floatDetector.read(width, height, pixels.data());
+			floatDetector.resampleIfGreater(params.resizeMaxSize);
+			describe(floatDetector, params, floatFeatures, floatDetect, floatExtract);
+
+			AlpDetectorFixed fixedDetector;
+			fixedDetector.read(width, height, pixels.data());
+			fixedDetector.resampleIfGreater(params.resizeMaxSize);
+			describe(fixedDetector, params, fixedFeatures, fixedDetect, fixedExtract);
+		}
+
+		numFloat += floatFeatures.size();
+		numFixed += fixedFeatures.size();
+		numRepeated += countRepeated(floatFeatures, fixedFeatures, positionError);
+	}
+
+	double runs = (double) std::max(nImages * numRounds, (size_t) 1);
+	double images = (double) std::max(nImages, (size_t) 1);
+	double floatTime = floatDetect + floatExtract;
+	double fixedTime = fixedDetect + fixedExtract;
+	printf ("%-10s %12s %12s %12s %12s %16s\n", "detector", "detect ms", "extract ms", "total ms", "images/s", "features/image");
+	printf ("%-10s %12.2f %12.2f %12.2f %12.1f %16.1f\n", "float", 1e3 * floatDetect / runs, 1e3 * floatExtract / runs, 1e3 * floatTime / runs, runs / std::max(floatTime, 1e-9), numFloat / images);
+	printf ("%-10s %12.2f %12.2f %12.2f %12.1f %16.1f\n", "fixed", 1e3 * fixedDetect / runs, 1e3 * fixedExtract / runs, 1e3 * fixedTime / runs, runs / std::max(fixedTime, 1e-9), numFixed / images);
+	printf ("speedup: detect %.2f, total %.2f\n", floatDetect / std::max(fixedDetect, 1e-9), floatTime / std::max(fixedTime, 1e-9));
+	printf ("repeatability: %.2f%% of the float features (max distance %.2f pixels, max scale ratio %.2f), mean position error %.3f pixels\n",
+			100.0 * numRepeated / std::max(numFloat, (size_t) 1), maxDistance, maxScaleRatio, positionError / std::max(numRepeated, (size_t) 1));
+}
+
+void usage()
+{
+	fprintf (stdout,
+		"CDVS fixed-point detector benchmark module.\n"
+		"usage:\n"
+		"  benchFixedPoint <images> <mode> <datasetPath> <annotationPath> [-p paramfile] [-rounds n] [-distance d] [-scale s] [-h]\n"
+		"where:\n"
+		"  images - text file containing the images (the first image of each line is used)\n"
+		"  mode (0..n) - sets the encoding mode (resize and number of features)\n"
+		"  dataset path - the root dir of the CDVS dataset of images\n"
+		"  annotation path - the root dir of the CDVS annotation files\n"
+		"options:\n"
+		"  -p paramfile: text file containing initialization parameters for all modes\n"
+		"  -rounds n: number of times each image is processed by each detector (default 3)\n"
+		"  -distance d: max distance in pixels of a repeated keypoint (default 1.5)\n"
+		"  -scale s: max scale ratio of a repeated keypoint (default 1.25)\n"
+		"  -help or -h: help\n");
+	exit (1);
+}
+
+/**
+ * @file
+ * benchFixedPoint: CDVS fixed-point detector benchmark module.
+ * Compares the experimental fixed-point ALP detector (AlpDetectorFixed) with the floating point one (AlpDetector):
+ * detection and description time, and repeatability of the floating point features in the fixed-point ones.
+ * @verbatim
+
+  CDVS fixed-point detector benchmark module.
+	usage:
+		benchFixedPoint <images> <mode> <datasetPath> <annotationPath> [-p paramfile] [-rounds n] [-distance d] [-scale s] [-h]
+	where:
+		images - text file containing the images (the first image of each line is used)
+		mode (0..n) - sets the encoding mode (resize and number of features)
+		dataset path - the root dir of the CDVS dataset of images
+		annotation path - the root dir of the CDVS annotation files
+	options:
+		-p paramfile: text file containing initialization parameters for all modes
+		-rounds n: number of times each image is processed by each detector (default 3)
+		-distance d: max distance in pixels of a repeated keypoint (default 1.5)
+		-scale s: max scale ratio of a repeated keypoint (default 1.25)
+		-help or -h: help
+
+ @endverbatim
+ */
+
+int run_bench_fixed_point(int argc, char *argv[])
+{
+	// argv 0            1        2        3             4
+	// benchFixedPoint <images> <mode> <datasetPath> <annotationPath> [-p paramfile] [-rounds n] [-distance d] [-scale s] [-h]
+
+	const char * paramfile = NULL;	// default: no parameters file
+
+	/* check if sufficient # of arguments were provided: */
+	if (argc < 5)
+		usage();
+
+	for (int i=5; i<argc; i++)
+	{
+		if (argv[i][0] != '-')
+		{
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+		/* check option names: */
+		if (!strcmp (argv[i]+1,"help") || !strcmp (argv[i]+1,"h") || !strcmp (argv[i]+1,"H")) {
+			usage();		/* display help: */
+		}
+		else if (!strcmp (argv[i]+1,"p") && (i+1 < argc)) {
+			paramfile = argv[++i];
+		}
+		else if (!strcmp (argv[i]+1,"rounds") && (i+1 < argc)) {
+			numRounds = std::max(1, atoi(argv[++i]));
+		}
+		else if (!strcmp (argv[i]+1,"distance") && (i+1 < argc)) {
+			maxDistance = atof(argv[++i]);
+		}
+		else if (!strcmp (argv[i]+1,"scale") && (i+1 < argc)) {
+			maxScaleRatio = std::max(1.0, atof(argv[++i]));
+		}
+		else {
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+	}
+
+	const char * imagesname = argv[1];
+	int mode = atoi(argv[2]);
+	const char * datasetPath = argv[3];
+	const char * annotationPath = argv[4];
+
+	FileManager manager;
+	manager.setAnnotationPath(annotationPath);
+	size_t nImages = manager.readAnnotation(imagesname);
+	manager.setDatasetPath(datasetPath);
+
+	CdvsConfiguration * cdvsconfig = CdvsConfiguration::cdvsConfigurationFactory(paramfile);	// if paramfile == NULL use default values
+	Parameters params = cdvsconfig->getParameters(mode);
+	params.extractionThreads = 1;		// compare the serial versions of both detectors
+
+	bench_fixed_point(manager, nImages, params);
+
+	delete cdvsconfig;
+
+	return 0;
+}
+
+//  ----- main -------
+
+int main(int argc, char *argv[])
+{
+	try {
+		run_bench_fixed_point(argc, argv);		// run "benchFixedPoint" catching any exception
+	}
+	catch(exception & ex)				// catch any exception, including CdvsException
+	{
+		cerr << argv[0] << " exception: " << ex.what() << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,385 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as 
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy, 
+ * distribute, and make derivative works of this software module or modifications thereof 
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may 
+ * infringe existing patents. ISO/IEC have no liability for use of this software module 
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own 
+ * purposes, assign or donate the code to a third party and to inhibit third parties 
+ * from using the code for products that do not conform to MPEG-related 
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "FeatureList.h"
+#include "PointPairs.h"
+#include "HammingKernel.h"
+#include "CdvsException.h"
+#include "HiResTimer.h"
+
+using namespace std;
+using namespace mpeg7cdvs;
+
+int numRounds = 200;				// default number of random blocks of descriptors compared for each length
+int numFeatures = 300;				// default number of features of the matched lists
+unsigned int seed = 1;				// default seed of the random descriptors
+
+static const int modeLengths[] = {5, 10, 16, 20, 32};		// the descriptor lengths produced by the CDVS modes
+static const int numModeLengths = sizeof(modeLengths) / sizeof(modeLengths[0]);
+
+/**
+ * Reference distances: byte by byte, as the generic scalar kernel computes them.
+ */
+static void referenceDistances(const unsigned char * query, const unsigned char * refs, int stride, int nRefs, int nbytes, int * distances)
+{
+	for (int r = 0; r < nRefs; ++r)
+	{
+		int distance = 0;
+		for (int i = 0; i < nbytes; ++i)
+			distance += POPCNT8(query[i] ^ refs[(size_t) r * stride + i]);
+		distances[r] = distance;
+	}
+}
+
+/**
+ * Reference nearest and second nearest descriptors (the lowest index wins in case of equal distances).
+ */
+static int referenceNearest(const int * distances, int nRefs, int & minDistance, int & secondMinDistance)
+{
+	int minDistanceInd = 0;
+	minDistance = 65536;
+	secondMinDistance = 65536;
+	for (int i = 0; i < nRefs; ++i)
+	{
+		if (distances[i] < minDistance)
+		{
+			secondMinDistance = minDistance;
+			minDistance = distances[i];
+			minDistanceInd = i;
+		}
+		else if (distances[i] < secondMinDistance)
+		{
+			secondMinDistance = distances[i];
+		}
+	}
+	return minDistanceInd;
+}
+
+/**
+ * Fill a buffer with random bytes.
+ */
+static void randomBytes(unsigned char * data, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+		data[i] = (unsigned char) (rand() & 0xFF);
+}
+
+/**
+ * Compare the kernels of NBYTES bytes (fixed-length and generic, single and batched) with the reference on random blocks of descriptors.
+ * The block sizes cover the vector widths and their remainders, and the stride is random to catch any read past NBYTES.
+ * @return the number of mismatches
+ */
+template<int NBYTES>
+size_t check_kernels(double & fixedTime, double & referenceTime)
+{
+	const int maxRefs = 67;
+	const int maxStride = NBYTES + 8;
+	vector<unsigned char> query(NBYTES), refs(maxRefs * maxStride);
+	vector<int> expected(maxRefs), fixed(maxRefs), generic(maxRefs);
+	size_t mismatches = 0;
+	HiResTimer timer;
+
+	for (int round = 0; round < numRounds; ++round)
+	{
+		int nRefs = rand() % (maxRefs + 1);
+		int stride = NBYTES + rand() % (maxStride - NBYTES + 1);
+		randomBytes(&query[0], query.size());
+		randomBytes(&refs[0], refs.size());
+		if ((nRefs > 2) && (round % 2 == 0))
+			memcpy(&refs[(size_t) (nRefs / 2) * stride], &refs[0], NBYTES);		// force some equal distances
+
+		timer.start();
+		referenceDistances(&query[0], &refs[0], stride, nRefs, NBYTES, &expected[0]);
+		timer.stop();
+		referenceTime += timer.elapsed();
+		int expectedMin, expectedSecond;
+		int expectedInd = referenceNearest(&expected[0], nRefs, expectedMin, expectedSecond);
+
+		timer.start();
+		HammingKernel::distances<NBYTES>(&query[0], &refs[0], stride, nRefs, &fixed[0]);
+		timer.stop();
+		fixedTime += timer.elapsed();
+
+		HammingKernel::distances(&query[0], &refs[0], stride, nRefs, NBYTES, &generic[0]);
+		for (int r = 0; r < nRefs; ++r)
+		{
+			if (fixed[r] != expected[r])
+				++mismatches;
+			if (generic[r] != expected[r])
+				++mismatches;
+			if (HammingKernel::distance<NBYTES>(&query[0], &refs[(size_t) r * stride]) != expected[r])
+				++mismatches;
+			if (HammingKernel::distance(&query[0], &refs[(size_t) r * stride], NBYTES) != expected[r])
+				++mismatches;
+		}
+
+		int minDistance, secondMinDistance;
+		int ind = HammingKernel::nearest<NBYTES>(&query[0], &refs[0], stride, nRefs, &fixed[0], minDistance, secondMinDistance);
+		if ((ind != expectedInd) || (minDistance != expectedMin) || (secondMinDistance != expectedSecond))
+			++mismatches;
+
+		ind = HammingKernel::nearest(&query[0], &refs[0], stride, nRefs, NBYTES, &generic[0], minDistance, secondMinDistance);
+		if ((ind != expectedInd) || (minDistance != expectedMin) || (secondMinDistance != expectedSecond))
+			++mismatches;
+	}
+
+	return mismatches;
+}
+
+/**
+ * Create a list of random features; if other is not NULL, half of the features are noisy copies of the features of other.
+ */
+static void randomList(CompressedFeatureList & list, int nbytes, const CompressedFeatureList * other)
+{
+	list = CompressedFeatureList(numFeatures, nbytes);
+	randomBytes(list.features, (size_t) numFeatures * nbytes);
+	for (int f = 0; f < numFeatures; ++f)
+	{
+		list.Xcoord[f] = (unsigned short) (rand() % 640);
+		list.Ycoord[f] = (unsigned short) (rand() % 480);
+		if ((other != NULL) && (f % 2 == 0))
+		{
+			unsigned char * descr = list.features + (size_t) f * nbytes;
+			memcpy(descr, other->features + (size_t) (rand() % other->nFeatures()) * nbytes, nbytes);
+			for (int flip = 0; flip < 1 + nbytes / 4; ++flip)
+			{
+				int bit = rand() % (8 * nbytes);
+				descr[bit / 8] ^= (unsigned char) (1 << (bit % 8));
+			}
+		}
+	}
+}
+
+/**
+ * Copy a list adding one constant byte to each descriptor; the distances do not change, but the matcher uses the generic kernels.
+ */
+static void paddedList(const CompressedFeatureList & list, CompressedFeatureList & padded)
+{
+	int nbytes = list.descrBytes();
+	padded = CompressedFeatureList(list.nFeatures(), nbytes + 1);
+	for (int f = 0; f < list.nFeatures(); ++f)
+	{
+		memcpy(padded.features + (size_t) f * (nbytes + 1), list.features + (size_t) f * nbytes, nbytes);
+		padded.features[(size_t) f * (nbytes + 1) + nbytes] = 0x5A;
+		padded.Xcoord[f] = list.Xcoord[f];
+		padded.Ycoord[f] = list.Ycoord[f];
+	}
+}
+
+/**
+ * Compare two sets of matched pairs.
+ * @return the number of differences
+ */
+static size_t comparePairs(const PointPairs & a, const PointPairs & b, bool twoWay)
+{
+	if (a.nMatched != b.nMatched)
+		return 1 + (size_t) abs(a.nMatched - b.nMatched);
+
+	size_t differences = 0;
+	for (int i = 0; i < a.nMatched; ++i)
+	{
+		if ((a.x1[i] != b.x1[i]) || (a.y1[i] != b.y1[i]) || (a.x2[i] != b.x2[i]) || (a.y2[i] != b.y2[i]) || (a.weights[i] != b.weights[i]))
+			++differences;
+		else if (twoWay && (a.match_dirs[i] != b.match_dirs[i]))
+			++differences;
+	}
+	return differences;
+}
+
+/**
+ * Compare the one-way and two-way matching of lists of nbytes bytes, which use the fixed-length kernels,
+ * with the matching of the same lists padded to nbytes + 1 bytes, which use the generic kernels.
+ * @return the number of differences
+ */
+size_t check_matchers(int nbytes, float ratioThreshold)
+{
+	CompressedFeatureList a, b, paddedA, paddedB;
+	randomList(a, nbytes, NULL);
+	randomList(b, nbytes, &a);
+	paddedList(a, paddedA);
+	paddedList(b, paddedB);
+
+	PointPairs fixed(2 * numFeatures), generic(2 * numFeatures);
+	size_t differences = 0;
+
+	a.matchDescriptors_oneWay(fixed, b, ratioThreshold);
+	paddedA.matchDescriptors_oneWay(generic, paddedB, ratioThreshold);
+	differences += comparePairs(fixed, generic, false);
+
+	a.matchDescriptors_twoWay(fixed, b, ratioThreshold);
+	paddedA.matchDescriptors_twoWay(generic, paddedB, ratioThreshold);
+	differences += comparePairs(fixed, generic, true);
+
+	return differences;
+}
+
+/**
+ * Check all the Hamming kernels on random descriptors of every mode length, with every implementation supported by the CPU.
+ * @return the total number of mismatches
+ */
+size_t bench_hamming_kernel()
+{
+	static const char * names[] = {"scalar", "avx2", "avx512"};
+	const int best = HammingKernel::getImplementation();
+	size_t total = 0;
+
+	printf ("%-8s %6s %12s %12s %10s %10s\n", "kernel", "bytes", "fixed ns", "ref ns", "kernels", "matchers");
+	for (int level = HammingKernel::SCALAR; level <= HammingKernel::AVX512; ++level)
+	{
+		if (HammingKernel::setImplementation(level) != level)
+		{
+			printf ("%-8s not supported by this CPU\n", names[level]);
+			continue;
+		}
+
+		for (int l = 0; l < numModeLengths; ++l)
+		{
+			int nbytes = modeLengths[l];
+			double fixedTime = 0, referenceTime = 0;
+			size_t kernelMismatches = 0, matcherMismatches = 0;
+
+			srand(seed + nbytes);
+			switch (nbytes)
+			{
+				case 5:		kernelMismatches = check_kernels<5>(fixedTime, referenceTime); break;
+				case 10:	kernelMismatches = check_kernels<10>(fixedTime, referenceTime); break;
+				case 16:	kernelMismatches = check_kernels<16>(fixedTime, referenceTime); break;
+				case 20:	kernelMismatches = check_kernels<20>(fixedTime, referenceTime); break;
+				case 32:	kernelMismatches = check_kernels<32>(fixedTime, referenceTime); break;
+			}
+
+			// the padded lists of 33 bytes would exceed the max descriptor length
+			if (nbytes < 32)
+				matcherMismatches = check_matchers(nbytes, 0.85f);
+
+			double descriptors = numRounds * 67 / 2.0;		// average number of descriptors compared for each length
+			printf ("%-8s %6d %12.2f %12.2f %10zu %10zu\n", names[level], nbytes, 1e9 * fixedTime / descriptors, 1e9 * referenceTime / descriptors,
+					kernelMismatches, matcherMismatches);
+			total += kernelMismatches + matcherMismatches;
+		}
+	}
+
+	HammingKernel::setImplementation(best);
+	printf ("%s: %zu mismatches\n", (total == 0) ? "passed" : "FAILED", total);
+	return total;
+}
+
+void usage()
+{
+	fprintf (stdout,
+		"CDVS Hamming kernel check and benchmark module.\n"
+		"usage:\n"
+		"  benchHammingKernel [-rounds n] [-features n] [-seed n] [-h]\n"
+		"options:\n"
+		"  -rounds n: number of random blocks of descriptors compared for each length (default 200)\n"
+		"  -features n: number of features of the matched lists (default 300)\n"
+		"  -seed n: seed of the random descriptors (default 1)\n"
+		"  -help or -h: help\n");
+	exit (1);
+}
+
+/**
+ * @file
+ * benchHammingKernel: CDVS Hamming kernel check and benchmark module.
+ * Compares the fixed-length Hamming kernels used for the descriptor lengths of the CDVS modes (5, 10, 16, 20 and 32 bytes)
+ * and the generic batched kernels with a byte by byte reference, on random descriptors, for every implementation supported by the CPU;
+ * also compares the matching of lists of these lengths with the matching of the same lists padded by one byte, which uses the generic kernels.
+ * Exits with status 1 if any mismatch is found.
+ * @verbatim
+
+  CDVS Hamming kernel check and benchmark module.
+	usage:
+		benchHammingKernel [-rounds n] [-features n] [-seed n] [-h]
+	options:
+		-rounds n: number of random blocks of descriptors compared for each length (default 200)
+		-features n: number of features of the matched lists (default 300)
+		-seed n: seed of the random descriptors (default 1)
+		-help or -h: help
+
+ @endverbatim
+ */
+
+int run_bench_hamming_kernel(int argc, char *argv[])
+{
+	// argv 0
+	// benchHammingKernel [-rounds n] [-features n] [-seed n] [-h]
+
+	for (int i=1; i<argc; i++)
+	{
+		if (argv[i][0] != '-')
+		{
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+		/* check option names: */
+		if (!strcmp (argv[i]+1,"help") || !strcmp (argv[i]+1,"h") || !strcmp (argv[i]+1,"H")) {
+			usage();		/* display help: */
+		}
+		else if (!strcmp (argv[i]+1,"rounds") && (i+1 < argc)) {
+			numRounds = std::max(1, atoi(argv[++i]));
+		}
+		else if (!strcmp (argv[i]+1,"features") && (i+1 < argc)) {
+			numFeatures = std::min(std::max(2, atoi(argv[++i])), 8000);
+		}
+		else if (!strcmp (argv[i]+1,"seed") && (i+1 < argc)) {
+			seed = (unsigned int) atoi(argv[++i]);
+		}
+		else {
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+	}
+
+	return (bench_hamming_kernel() == 0) ? 0 : 1;
+}
+
+//  ----- main -------
+
+int main(int argc, char *argv[])
+{
+	try {
+		return run_bench_hamming_kernel(argc, argv);		// run "benchHammingKernel" catching any exception
+	}
+	catch(exception & ex)				// catch any exception, including CdvsException
+	{
+		cerr << argv[0] << " exception: " << ex.what() << endl;
+	}
+
+	return 1;
+}
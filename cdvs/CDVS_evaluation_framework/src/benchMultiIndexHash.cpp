@@ -0,0 +1,288 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as 
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy, 
+ * distribute, and make derivative works of this software module or modifications thereof 
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may 
+ * infringe existing patents. ISO/IEC have no liability for use of this software module 
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own 
+ * purposes, assign or donate the code to a third party and to inhibit third parties 
+ * from using the code for products that do not conform to MPEG-related 
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "Database.h"
+#include "MultiIndexHash.h"
+#include "HammingKernel.h"
+#include "CdvsException.h"
+#include "HiResTimer.h"
+
+using namespace std;
+using namespace mpeg7cdvs;
+
+unsigned int numQueries = 1000;		// default number of query features
+int numNeighbors = 10;				// default number of nearest neighbors
+float radius = 0.125f;				// default max distance, as a fraction of the descriptor bits
+int numFlips = 4;					// default number of bits changed in each query feature
+int numSteps = 4;					// default number of DB sizes (the full DB, half of it, a quarter, ...)
+int queryBytes = 0;					// default size of the query features (0 = same as the DB features)
+
+/**
+ * Exhaustive k nearest neighbors search, used as a reference; descriptors are compared on their first nbytes bytes.
+ */
+static void linearSearch(const unsigned char * query, int nbytes, const vector<CompressedFeatureList> & images, size_t nImages, int k, int maxDistance,
+		vector<int> & distances, vector< pair<int,unsigned int> > & found)
+{
+	found.clear();
+	unsigned int first = 0;
+	for (size_t i = 0; i < nImages; ++i)
+	{
+		const CompressedFeatureList & image = images[i];
+		distances.resize(std::max(image.nFeatures(), 1));
+		HammingKernel::distances(query, image.features, image.descrBytes(), image.nFeatures(), nbytes, &distances[0]);
+		for (int f = 0; f < image.nFeatures(); ++f)
+		{
+			if (distances[f] <= maxDistance)
+				found.push_back(make_pair(distances[f], first + f));
+		}
+		first += image.nFeatures();
+	}
+
+	size_t n = std::min(found.size(), (size_t) k);
+	partial_sort(found.begin(), found.begin() + n, found.end());
+	found.resize(n);
+}
+
+/**
+ * Multi-index hash benchmark function.
+ * @param index name of the index (without the .local extension) whose local descriptors are used
+ */
+void bench_multi_index_hash(const char *index)
+{
+	Database db;
+	db.readFromFile((string(index) + ".local").c_str());
+
+	// sample the query features evenly from the DB, then change some of their bits
+	vector<unsigned char> queries;
+	int nBytes = 0;
+	size_t nFeatures = 0;
+	for (size_t i = 0; i < db.size(); ++i)
+	{
+		nFeatures += db.images[i].nFeatures();
+		if (db.images[i].nFeatures() > 0)
+			nBytes = db.images[i].descrBytes();
+	}
+
+	if ((nFeatures == 0) || (numQueries == 0))
+		throw CdvsException("no features to benchmark");
+
+	// a query of a different size (as in a different mode) is truncated or padded with random bytes
+	int qBytes = (queryBytes > 0) ? queryBytes : nBytes;
+	int cBytes = std::min(qBytes, nBytes);		// size of the compared prefix
+
+	srand(1);
+	for (size_t q = 0, offset = 0, i = 0; (q < numQueries) && (i < db.size()); ++i)
+	{
+		const CompressedFeatureList & image = db.images[i];
+		size_t sample;
+		while ((q < numQueries) && ((sample = (q * nFeatures) / numQueries) < offset + image.nFeatures()))
+		{
+			const unsigned char * feature = image.features + (sample - offset) * nBytes;
+			queries.insert(queries.end(), feature, feature + cBytes);
+			for (int b = cBytes; b < qBytes; ++b)
+				queries.push_back((unsigned char) rand());
+			for (int b = 0; b < numFlips; ++b)
+			{
+				int bit = rand() % (8 * cBytes);
+				queries[q * qBytes + bit / 8] ^= (unsigned char) (1 << (bit % 8));
+			}
+			++q;
+		}
+		offset += image.nFeatures();
+	}
+
+	size_t nQueries = queries.size() / qBytes;
+	int maxDistance = (int) (radius * 8 * cBytes);
+	cout << nQueries << " queries, k = " << numNeighbors << ", max distance = " << maxDistance << " bits (" << 8 * nBytes << " bits per DB descriptor, "
+			<< 8 * qBytes << " bits per query descriptor)" << endl;
+	printf ("%10s %10s %12s %14s %14s %9s %10s\n", "images", "features", "build [s]", "MIH [us/q]", "linear [us/q]", "speedup", "mismatches");
+
+	for (int step = numSteps - 1; step >= 0; --step)
+	{
+		size_t nImages = std::max((size_t) 1, db.size() >> step);
+		vector<CompressedFeatureList> images(db.images.begin(), db.images.begin() + nImages);
+
+		HiResTimer timer;
+		MultiIndexHash mih;
+		timer.start();
+		mih.build(images);
+		timer.stop();
+		double buildTime = timer.elapsed();
+
+		vector< vector<MultiIndexHash::Neighbor> > results(nQueries);
+		timer.start();
+		for (size_t q = 0; q < nQueries; ++q)
+			mih.knnSearch(&queries[q * qBytes], numNeighbors, maxDistance, results[q], qBytes);
+		timer.stop();
+		double mihTime = timer.elapsed();
+
+		vector<int> distances;
+		vector< vector< pair<int,unsigned int> > > references(nQueries);
+		timer.start();
+		for (size_t q = 0; q < nQueries; ++q)
+			linearSearch(&queries[q * qBytes], cBytes, images, nImages, numNeighbors, maxDistance, distances, references[q]);
+		timer.stop();
+		double linearTime = timer.elapsed();
+
+		// both searches are exact, and break ties in the same way: the results must be identical
+		int mismatches = 0;
+		for (size_t q = 0; q < nQueries; ++q)
+		{
+			bool same = (results[q].size() == references[q].size());
+			for (size_t n = 0; same && (n < results[q].size()); ++n)
+				same = (results[q][n].distance == references[q][n].first);
+			if (!same)
+				++mismatches;
+		}
+
+		printf ("%10lu %10lu %12.4f %14.2f %14.2f %9.1f %10d\n", (unsigned long) nImages, (unsigned long) mih.numberFeatures(), buildTime,
+				1e6 * mihTime / nQueries, 1e6 * linearTime / nQueries, linearTime / std::max(mihTime, 1e-9), mismatches);
+	}
+}
+
+void usage()
+{
+	fprintf (stdout,
+		"CDVS multi-index hash benchmark module.\n"
+		"usage:\n"
+		"  benchMultiIndexHash <index> <datasetPath> [-queries n] [-k n] [-radius r] [-flips n] [-steps n] [-bytes n] [-h]\n"
+		"where:\n"
+		"  index - name of the index file (.local) providing the DB local descriptors\n"
+		"  dataset path - the root dir of the CDVS dataset of images\n"
+		"options:\n"
+		"  -queries n: number of query features, sampled from the DB (default 1000)\n"
+		"  -k n: number of nearest neighbors of each query feature (default 10)\n"
+		"  -radius r: max distance of the neighbors, as a fraction of the descriptor bits (default 0.125)\n"
+		"  -flips n: number of random bits changed in each query feature (default 4)\n"
+		"  -steps n: number of DB sizes, each one half of the next one (default 4)\n"
+		"  -bytes n: size of the query features, compared with the DB features on their common prefix (default: same as the DB)\n"
+		"  -help or -h: help\n");
+	exit (1);
+}
+
+/**
+ * @file
+ * benchMultiIndexHash: CDVS multi-index hash benchmark module.
+ * Compares the query time of the multi-index hash k nearest neighbors search with an exhaustive search, on growing subsets of the DB.
+ * @verbatim
+
+  CDVS multi-index hash benchmark module.
+	usage:
+		benchMultiIndexHash <index> <datasetPath> [-queries n] [-k n] [-radius r] [-flips n] [-steps n] [-bytes n] [-h]
+	where:
+		index - name of the index file (.local) providing the DB local descriptors
+		dataset path - the root dir of the CDVS dataset of images
+	options:
+		-queries n: number of query features, sampled from the DB (default 1000)
+		-k n: number of nearest neighbors of each query feature (default 10)
+		-radius r: max distance of the neighbors, as a fraction of the descriptor bits (default 0.125)
+		-flips n: number of random bits changed in each query feature (default 4)
+		-steps n: number of DB sizes, each one half of the next one (default 4)
+		-bytes n: size of the query features, compared with the DB features on their common prefix (default: same as the DB)
+		-help or -h: help
+
+ @endverbatim
+ */
+
+int run_bench_multi_index_hash(int argc, char *argv[])
+{
+	// argv 0                1        2
+	// benchMultiIndexHash <index> <datasetPath> [-queries n] [-k n] [-radius r] [-flips n] [-steps n] [-bytes n] [-h]
+
+	/* check if sufficient # of arguments were provided: */
+	if (argc < 3)
+		usage();
+
+	for (int i=3; i<argc; i++)
+	{
+		if (argv[i][0] != '-')
+		{
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+		/* check option names: */
+		if (!strcmp (argv[i]+1,"help") || !strcmp (argv[i]+1,"h") || !strcmp (argv[i]+1,"H")) {
+			usage();		/* display help: */
+		}
+		else if (!strcmp (argv[i]+1,"queries") && (i+1 < argc)) {
+			numQueries = atoi(argv[++i]);
+		}
+		else if (!strcmp (argv[i]+1,"k") && (i+1 < argc)) {
+			numNeighbors = atoi(argv[++i]);
+		}
+		else if (!strcmp (argv[i]+1,"radius") && (i+1 < argc)) {
+			radius = atof(argv[++i]);
+		}
+		else if (!strcmp (argv[i]+1,"flips") && (i+1 < argc)) {
+			numFlips = atoi(argv[++i]);
+		}
+		else if (!strcmp (argv[i]+1,"steps") && (i+1 < argc)) {
+			numSteps = std::max(1, atoi(argv[++i]));
+		}
+		else if (!strcmp (argv[i]+1,"bytes") && (i+1 < argc)) {
+			queryBytes = atoi(argv[++i]);
+		}
+		else {
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+	}
+
+	/* read the index name and set the correct path */
+	string indexpathname = string(argv[2]) + "/" + argv[1];
+
+	bench_multi_index_hash(indexpathname.c_str());
+
+	return 0;
+}
+
+//  ----- main -------
+
+int main(int argc, char *argv[])
+{
+	try {
+		run_bench_multi_index_hash(argc, argv);		// run "benchMultiIndexHash" catching any exception
+	}
+	catch(exception & ex)				// catch any exception, including CdvsException
+	{
+		cerr << argv[0] << " exception: " << ex.what() << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,262 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as 
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy, 
+ * distribute, and make derivative works of this software module or modifications thereof 
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may 
+ * infringe existing patents. ISO/IEC have no liability for use of this software module 
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own 
+ * purposes, assign or donate the code to a third party and to inhibit third parties 
+ * from using the code for products that do not conform to MPEG-related 
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "resampler.h"
+#include "Lanczos3Resampler.h"
+#include "FileManager.h"
+#include "CdvsException.h"
+#include "BenchJpeg.h"
+#include "HiResTimer.h"
+
+using namespace std;
+using namespace mpeg7cdvs;
+
+int numRounds = 3;				// default number of times each image is resampled by each implementation
+int maxSize = 640;				// default max size of the resampled images
+
+/**
+ * Resample a luminance image using the resampler library, as ImageBuffer::resampleImage() did before Lanczos3Resampler.
+ * @param src the source image
+ * @param srcWidth the width of the source image
+ * @param srcHeight the height of the source image
+ * @param dst the destination image
+ * @param dstWidth the width of the destination image
+ * @param dstHeight the height of the destination image
+ * @throws CdvsException in case of error
+ */
+void resampleLibrary(const unsigned char * src, int srcWidth, int srcHeight, unsigned char * dst, int dstWidth, int dstHeight)
+{
+	const int tableSize = 4096;
+	unsigned char linearTo8bit[tableSize];
+	for (int i = 0; i < tableSize; ++i)
+		linearTo8bit[i] = (unsigned char) std::min(255, std::max(0, (int) (255.0f * (i * (1.0f / tableSize)) + .5f)));
+
+	Resampler resampler(srcWidth, srcHeight, dstWidth, dstHeight, Resampler::BOUNDARY_CLAMP, 0.0f, 1.0f, "lanczos3", NULL, NULL, 1.0f, 1.0f);
+	vector<float> samples(srcWidth);
+	int y = 0;
+
+	for (int srcY = 0; srcY < srcHeight; ++srcY)
+	{
+		for (int x = 0; x < srcWidth; ++x)
+			samples[x] = src[(size_t) srcY * srcWidth + x] * 1.0f / 255.0f;
+
+		if (!resampler.put_line(samples.data()))
+			throw CdvsException("benchResampler: resampler error");
+
+		const float * line;
+		while ((line = resampler.get_line()) != NULL)
+		{
+			for (int x = 0; x < dstWidth; ++x)
+			{
+				int j = (int) (tableSize * line[x] + .5f);
+				dst[(size_t) y * dstWidth + x] = linearTo8bit[std::min(std::max(j, 0), tableSize - 1)];
+			}
+			++y;
+		}
+	}
+}
+
+/**
+ * Compare speed and output of the resampler library and of Lanczos3Resampler.
+ * @param manager the file manager, with the image annotation loaded
+ * @param nImages the number of images
+ */
+void bench_resampler(const FileManager & manager, size_t nImages)
+{
+	vector<unsigned char> pixels, reference, fast;
+	int width = 0, height = 0;
+	double libraryTime = 0, fastTime = 0;
+	size_t numResampled = 0, numPixels = 0, numDifferent = 0, numFallbacks = 0;
+	int maxDifference = 0;
+	HiResTimer timer;
+
+	for (size_t i = 0; i < nImages; ++i)
+	{
+		readGrayJpeg(manager.getAbsolutePathname(i).c_str(), pixels, width, height);
+
+		// the same resolution as ImageBuffer::resampleIfGreater()
+
+		double rfactor = (double) maxSize / std::max(width, height);
+		if (rfactor >= 1.0)
+			continue;
+
+		int dstWidth = (int) (width * rfactor + 0.5);
+		int dstHeight = (int) (height * rfactor + 0.5);
+		reference.resize((size_t) dstWidth * dstHeight);
+		fast.resize((size_t) dstWidth * dstHeight);
+
+		for (int round = 0; round < numRounds; ++round)
+		{
+			timer.start();
+			resampleLibrary(pixels.data(), width, height, reference.data(), dstWidth, dstHeight);
+			timer.stop();
+			libraryTime += timer.elapsed();
+
+			timer.start();
+			bool done = Lanczos3Resampler::resample(pixels.data(), width, height, fast.data(), dstWidth, dstHeight);
+			timer.stop();
+			fastTime += timer.elapsed();
+
+			if (!done)
+			{
+				++numFallbacks;
+				fast = reference;
+			}
+		}
+
+		++numResampled;
+		numPixels += reference.size();
+		for (size_t k = 0; k < reference.size(); ++k)
+		{
+			int difference = abs((int) reference[k] - (int) fast[k]);
+			if (difference > 0)
+			{
+				++numDifferent;
+				maxDifference = std::max(maxDifference, difference);
+			}
+		}
+	}
+
+	double runs = (double) std::max(numResampled * numRounds, (size_t) 1);
+	printf ("%-12s %12s %12s\n", "resampler", "ms/image", "images/s");
+	printf ("%-12s %12.2f %12.1f\n", "library", 1e3 * libraryTime / runs, runs / std::max(libraryTime, 1e-9));
+	printf ("%-12s %12.2f %12.1f\n", "lanczos3", 1e3 * fastTime / runs, runs / std::max(fastTime, 1e-9));
+	printf ("speedup: %.2f (%zu of %zu images resampled, %zu fallbacks)\n", libraryTime / std::max(fastTime, 1e-9), numResampled, nImages, numFallbacks);
+	printf ("max difference: %d grey levels, %zu of %zu pixels differ\n", maxDifference, numDifferent, numPixels);
+}
+
+void usage()
+{
+	fprintf (stdout,
+		"CDVS resampler benchmark module.\n"
+		"usage:\n"
+		"  benchResampler <images> <datasetPath> <annotationPath> [-size n] [-rounds n] [-h]\n"
+		"where:\n"
+		"  images - text file containing the images (the first image of each line is used)\n"
+		"  dataset path - the root dir of the CDVS dataset of images\n"
+		"  annotation path - the root dir of the CDVS annotation files\n"
+		"options:\n"
+		"  -size n: max size of the resampled images (default 640)\n"
+		"  -rounds n: number of times each image is resampled by each implementation (default 3)\n"
+		"  -help or -h: help\n");
+	exit (1);
+}
+
+/**
+ * @file
+ * benchResampler: CDVS resampler benchmark module.
+ * Compares the lanczos3 resampler of the library (Resampler) with Lanczos3Resampler, used by ImageBuffer for luminance images:
+ * resampling time, and number and size of the differences of the resampled pixels.
+ * @verbatim
+
+  CDVS resampler benchmark module.
+	usage:
+		benchResampler <images> <datasetPath> <annotationPath> [-size n] [-rounds n] [-h]
+	where:
+		images - text file containing the images (the first image of each line is used)
+		dataset path - the root dir of the CDVS dataset of images
+		annotation path - the root dir of the CDVS annotation files
+	options:
+		-size n: max size of the resampled images (default 640)
+		-rounds n: number of times each image is resampled by each implementation (default 3)
+		-help or -h: help
+
+ @endverbatim
+ */
+
+int run_bench_resampler(int argc, char *argv[])
+{
+	// argv 0            1         2             3
+	// benchResampler <images> <datasetPath> <annotationPath> [-size n] [-rounds n] [-h]
+
+	/* check if sufficient # of arguments were provided: */
+	if (argc < 4)
+		usage();
+
+	for (int i=4; i<argc; i++)
+	{
+		if (argv[i][0] != '-')
+		{
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+		/* check option names: */
+		if (!strcmp (argv[i]+1,"help") || !strcmp (argv[i]+1,"h") || !strcmp (argv[i]+1,"H")) {
+			usage();		/* display help: */
+		}
+		else if (!strcmp (argv[i]+1,"size") && (i+1 < argc)) {
+			maxSize = std::max(1, atoi(argv[++i]));
+		}
+		else if (!strcmp (argv[i]+1,"rounds") && (i+1 < argc)) {
+			numRounds = std::max(1, atoi(argv[++i]));
+		}
+		else {
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+	}
+
+	const char * imagesname = argv[1];
+	const char * datasetPath = argv[2];
+	const char * annotationPath = argv[3];
+
+	FileManager manager;
+	manager.setAnnotationPath(annotationPath);
+	size_t nImages = manager.readAnnotation(imagesname);
+	manager.setDatasetPath(datasetPath);
+
+	bench_resampler(manager, nImages);
+
+	return 0;
+}
+
+//  ----- main -------
+
+int main(int argc, char *argv[])
+{
+	try {
+		run_bench_resampler(argc, argv);		// run "benchResampler" catching any exception
+	}
+	catch(exception & ex)				// catch any exception, including CdvsException
+	{
+		cerr << argv[0] << " exception: " << ex.what() << endl;
+	}
+
+	return 0;
+}
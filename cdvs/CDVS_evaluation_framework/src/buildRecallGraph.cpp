@@ -0,0 +1,164 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as 
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy, 
+ * distribute, and make derivative works of this software module or modifications thereof 
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may 
+ * infringe existing patents. ISO/IEC have no liability for use of this software module 
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own 
+ * purposes, assign or donate the code to a third party and to inhibit third parties 
+ * from using the code for products that do not conform to MPEG-related 
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include "CdvsInterface.h"
+#include "CdvsException.h"
+
+using namespace std;
+using namespace mpeg7cdvs;
+
+unsigned int numNeighbors = 5;		// default max number of neighbors per image
+unsigned int numCandidates = 50;	// default number of candidates verified per image
+
+/**
+ * Recall graph generation function.
+ * @param index name of the index (without the .local/.global extension) to update
+ */
+void build_recall_graph(const char *index)
+{
+	string indexName = index;
+
+	/* create an instance of CdvsServer */
+	CdvsConfiguration * cdvsconfig = CdvsConfiguration::cdvsConfigurationFactory();	// use default values
+	CdvsServer * cdvsserver = CdvsServer::cdvsServerFactory(cdvsconfig);
+
+	cdvsserver->loadDB((indexName + ".local").c_str(), (indexName + ".global").c_str());
+	cout << "start processing " << cdvsserver->sizeofDB() << " images" << endl;		// print a message
+
+	cdvsserver->buildRecallGraph(numNeighbors, numCandidates);
+
+	cdvsserver->storeDB((indexName + ".local").c_str(), (indexName + ".global").c_str());	// store the Data Base
+	cout << "recall graph stored in index file " << index << endl;
+
+	delete cdvsserver;
+	delete cdvsconfig;		// destroy the CDVS configuration instance
+}
+
+void usage()
+{
+	fprintf (stdout,
+		"CDVS recall graph generation module.\n"
+		"usage:\n"
+		"  buildRecallGraph <index> <datasetPath> [-neighbors n] [-candidates n] [-h]\n"
+		"where:\n"
+		"  index - name of the index files (.local and .global) to be updated\n"
+		"  dataset path - the root dir of the CDVS dataset of images\n"
+		"options:\n"
+		"  -neighbors n: max number of neighbors of each image in the graph (default 5)\n"
+		"  -candidates n: number of global descriptor candidates verified for each image (default 50)\n"
+		"  -help or -h: help\n"
+		"note:\n"
+		"  the recall graph is used by retrieve only if queryExpansionLoops > 0 in the DB mode parameters\n");
+	exit (1);
+}
+
+/**
+ * @file
+ * buildRecallGraph: CDVS recall graph generation module.
+ * Computes the graph of the most similar images of an existing index, and stores it in the .local index file.
+ * @verbatim
+
+  CDVS recall graph generation module.
+	usage:
+		buildRecallGraph <index> <datasetPath> [-neighbors n] [-candidates n] [-h]
+	where:
+		index - name of the index files (.local and .global) to be updated
+		dataset path - the root dir of the CDVS dataset of images
+	options:
+		-neighbors n: max number of neighbors of each image in the graph (default 5)
+		-candidates n: number of global descriptor candidates verified for each image (default 50)
+		-help or -h: help
+	note:
+		the recall graph is used by retrieve only if queryExpansionLoops > 0 in the DB mode parameters
+
+ @endverbatim
+ */
+
+int run_build_recall_graph(int argc, char *argv[])
+{
+	// argv 0             1        2
+	// buildRecallGraph <index> <datasetPath> [-neighbors n] [-candidates n] [-h]
+
+	/* check if sufficient # of arguments were provided: */
+	if (argc < 3)
+		usage();
+
+	for (int i=3; i<argc; i++)
+	{
+		if (argv[i][0] != '-')
+		{
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+		/* check option names: */
+		if (!strcmp (argv[i]+1,"help") || !strcmp (argv[i]+1,"h") || !strcmp (argv[i]+1,"H")) {
+			usage();		/* display help: */
+		}
+		else if (!strcmp (argv[i]+1,"neighbors") && (i+1 < argc)) {
+			numNeighbors = atoi(argv[++i]);
+		}
+		else if (!strcmp (argv[i]+1,"candidates") && (i+1 < argc)) {
+			numCandidates = atoi(argv[++i]);
+		}
+		else {
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+	}
+
+	/* read the index name and set the correct path */
+	string indexpathname = string(argv[2]) + "/" + argv[1];
+
+	build_recall_graph(indexpathname.c_str());
+
+	return 0;
+}
+
+//  ----- main -------
+
+int main(int argc, char *argv[])
+{
+	try {
+		run_build_recall_graph(argc, argv);		// run "buildRecallGraph" catching any exception
+	}
+	catch(exception & ex)				// catch any exception, including CdvsException
+	{
+		cerr << argv[0] << " exception: " << ex.what() << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * This software module was originally developed by:
+ *
+ *   Telecom Italia
+ *
+ * in the course of development of ISO/IEC 15938-13 Compact Descriptors for Visual
+ * Search standard for reference purposes and its performance may not have been
+ * optimized. This software module includes implementation of one or more tools as 
+ * specified by the ISO/IEC 15938-13 standard.
+ *
+ * ISO/IEC gives you a royalty-free, worldwide, non-exclusive, copyright license to copy, 
+ * distribute, and make derivative works of this software module or modifications thereof 
+ * for use in implementations of the ISO/IEC 15938-13 standard in products that satisfy
+ * conformance criteria (if any).
+ *
+ * Those intending to use this software module in products are advised that its use may 
+ * infringe existing patents. ISO/IEC have no liability for use of this software module 
+ * or modifications thereof.
+ *
+ * Copyright is not released for products that do not conform to audiovisual and image-
+ * coding related ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * Telecom Italia retain full rights to modify and use the code for their own 
+ * purposes, assign or donate the code to a third party and to inhibit third parties 
+ * from using the code for products that do not conform to MPEG-related 
+ * ITU Recommendations and/or ISO/IEC International Standards.
+ *
+ * This copyright notice must be included in all copies or derivative works.
+ * Copyright (c) ISO/IEC 2014.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include "CdvsInterface.h"
+#include "CdvsException.h"
+
+using namespace std;
+using namespace mpeg7cdvs;
+
+unsigned int branching = 10;			// default number of children of each node
+unsigned int depth = 4;					// default number of levels of the tree
+unsigned int maxTrainingFeatures = 200000;	// default max number of features used for training
+
+/**
+ * Vocabulary tree index generation function.
+ * @param index name of the index (without the .local/.global extension) to be indexed
+ */
+void build_vocabulary_tree(const char *index)
+{
+	string indexName = index;
+
+	/* create an instance of CdvsServer */
+	CdvsConfiguration * cdvsconfig = CdvsConfiguration::cdvsConfigurationFactory();	// use default values
+	CdvsServer * cdvsserver = CdvsServer::cdvsServerFactory(cdvsconfig);
+
+	cdvsserver->loadDB((indexName + ".local").c_str(), (indexName + ".global").c_str());
+	cout << "start processing " << cdvsserver->sizeofDB() << " images" << endl;		// print a message
+
+	cdvsserver->buildVocabularyTree(branching, depth, maxTrainingFeatures);
+
+	cdvsserver->storeVocabularyTree((indexName + ".vtree").c_str());	// store the vocabulary tree index
+	cout << "vocabulary tree stored in index file " << indexName << ".vtree" << endl;
+
+	delete cdvsserver;
+	delete cdvsconfig;		// destroy the CDVS configuration instance
+}
+
+void usage()
+{
+	fprintf (stdout,
+		"CDVS vocabulary tree index generation module.\n"
+		"usage:\n"
+		"  buildVocabularyTree <index> <datasetPath> [-branching n] [-depth n] [-train n] [-h]\n"
+		"where:\n"
+		"  index - name of the index files (.local and .global) to be indexed; the .vtree index file is created\n"
+		"  dataset path - the root dir of the CDVS dataset of images\n"
+		"options:\n"
+		"  -branching n: number of children of each node of the vocabulary tree (default 10)\n"
+		"  -depth n: number of levels of the vocabulary tree (default 4)\n"
+		"  -train n: max number of DB features used to train the vocabulary tree (default 200000)\n"
+		"  -help or -h: help\n"
+		"note:\n"
+		"  the vocabulary tree index is used by retrieve only if vocabularyTreeCandidates > 0 in the query mode parameters\n");
+	exit (1);
+}
+
+/**
+ * @file
+ * buildVocabularyTree: CDVS vocabulary tree index generation module.
+ * Trains a vocabulary tree on the local descriptors of an existing index, and stores the resulting inverted index in the .vtree index file.
+ * @verbatim
+
+  CDVS vocabulary tree index generation module.
+	usage:
+		buildVocabularyTree <index> <datasetPath> [-branching n] [-depth n] [-train n] [-h]
+	where:
+		index - name of the index files (.local and .global) to be indexed; the .vtree index file is created
+		dataset path - the root dir of the CDVS dataset of images
+	options:
+		-branching n: number of children of each node of the vocabulary tree (default 10)
+		-depth n: number of levels of the vocabulary tree (default 4)
+		-train n: max number of DB features used to train the vocabulary tree (default 200000)
+		-help or -h: help
+	note:
+		the vocabulary tree index is used by retrieve only if vocabularyTreeCandidates > 0 in the query mode parameters
+
+ @endverbatim
+ */
+
+int run_build_vocabulary_tree(int argc, char *argv[])
+{
+	// argv 0                1        2
+	// buildVocabularyTree <index> <datasetPath> [-branching n] [-depth n] [-train n] [-h]
+
+	/* check if sufficient # of arguments were provided: */
+	if (argc < 3)
+		usage();
+
+	for (int i=3; i<argc; i++)
+	{
+		if (argv[i][0] != '-')
+		{
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+		/* check option names: */
+		if (!strcmp (argv[i]+1,"help") || !strcmp (argv[i]+1,"h") || !strcmp (argv[i]+1,"H")) {
+			usage();		/* display help: */
+		}
+		else if (!strcmp (argv[i]+1,"branching") && (i+1 < argc)) {
+			branching = atoi(argv[++i]);
+		}
+		else if (!strcmp (argv[i]+1,"depth") && (i+1 < argc)) {
+			depth = atoi(argv[++i]);
+		}
+		else if (!strcmp (argv[i]+1,"train") && (i+1 < argc)) {
+			maxTrainingFeatures = atoi(argv[++i]);
+		}
+		else {
+			fprintf (stderr, "Invalid option: %s\n", argv[i]);
+			exit (1);
+		}
+	}
+
+	/* read the index name and set the correct path */
+	string indexpathname = string(argv[2]) + "/" + argv[1];
+
+	build_vocabulary_tree(indexpathname.c_str());
+
+	return 0;
+}
+
+//  ----- main -------
+
+int main(int argc, char *argv[])
+{
+	try {
+		run_build_vocabulary_tree(argc, argv);		// run "buildVocabularyTree" catching any exception
+	}
+	catch(exception & ex)				// catch any exception, including CdvsException
+	{
+		cerr << argv[0] << " exception: " << ex.what() << endl;
+	}
+
+	return 0;
+}
@@ -35,6 +35,7 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <vector>
 #include <algorithm>
 #include "CdvsInterface.h"
 #include "FileManager.h"
@@ -99,8 +100,10 @@ private:
 
 	//
 	// -------  read a JPEG image ignoring the color components  ------------
+	// If minSize > 0, the image is scaled in the DCT domain by the smallest factor (1/2, 1/4 or 1/8)
+	// that keeps its larger side not smaller than minSize; width and height are the size of the decoded image.
 	//
-	static unsigned char * readJpeg(const char *fname, int & width, int & height)
+	static unsigned char * readJpeg(const char *fname, int & width, int & height, int & originalWidth, int & originalHeight, int minSize = 0)
 	{
 		FILE *file;
 		if ((file = fopen (fname, "rb")) == NULL)
@@ -122,8 +125,16 @@ private:
 
 		// copy image parameters
 
-		height = cinfo.image_height;
-		width = cinfo.image_width;
+		height = originalHeight = cinfo.image_height;
+		width = originalWidth = cinfo.image_width;
+
+		// select the scaling factor
+
+		int maxSide = (width > height) ? width : height;
+		cinfo.scale_num = 1;
+		cinfo.scale_denom = 1;
+		while ((minSize > 0) && (cinfo.scale_denom < 8) && ((maxSide + 2*cinfo.scale_denom - 1) / (2*cinfo.scale_denom) >= (unsigned int) minSize))
+			cinfo.scale_denom *= 2;
 
 		// check colorspace
 
@@ -134,6 +145,9 @@ private:
 		  // start decompressor
 		  jpeg_start_decompress(&cinfo);
 
+		  width = cinfo.output_width;
+		  height = cinfo.output_height;
+
 		  // check if provided buffer is large enough
 		  size_t row_stride = cinfo.output_width * cinfo.output_components;
 		  size_t image_size = row_stride * cinfo.output_height;
@@ -177,7 +191,7 @@ void usage()
     cout <<
       "CDVS descriptor extraction module.\n"
       "Usage:\n"
-	  "  extract <images> <mode> <dataset path> <annotation path>  [-p parameters] [-help]\n"
+	  "  extract <images> <mode> <dataset path> <annotation path>  [-p parameters] [-s] [-m modes] [-help]\n"
       "where:\n"
       "  images - image files to process (text file, one file name per line)\n"
 	  "  mode (0..6) - sets the encoding mode to use\n"
@@ -185,6 +199,8 @@ void usage()
       "  annotation path - the root dir of the CDVS annotation files\n"
       "options:\n"
       "  -p parameters: text file containing initialization parameters for all modes\n"
+      "  -s: decode the JPEG images at a reduced scale (1/2, 1/4 or 1/8) not below the resizeMaxSize parameter (faster, slightly different descriptors)\n"
+      "  -m modes: comma-separated list of other modes (e.g. 2,6) encoded in the same pass, sharing the key point detection (length stats refer to <mode>)\n"
 	  "  -help or -h: help\n";
     exit (EXIT_FAILURE);
 }
@@ -197,7 +213,7 @@ void usage()
  * @verbatim
 
     Usage:
-	    extract <images> <mode> <dataset path> <annotation path>  [-p parameters] [-help]
+	    extract <images> <mode> <dataset path> <annotation path>  [-p parameters] [-s] [-m modes] [-help]
     where:
         images - image files to process (text file, one file name per line)
         mode (0..n) - sets the encoding mode to use
@@ -205,6 +221,8 @@ void usage()
         annotation path - the root dir of the CDVS annotation files
     options:
     	-p parameters: text file containing initialization parameters for all modes
+    	-s: decode the JPEG images at a reduced scale (1/2, 1/4 or 1/8) not below the resizeMaxSize parameter (faster, slightly different descriptors)
+    	-m modes: comma-separated list of other modes (e.g. 2,6) encoded in the same pass, sharing the key point detection (length stats refer to <mode>)
 	    -help or -h: help
 
  @endverbatim
@@ -228,10 +246,13 @@ int run_extract(int argc, char *argv[])
 	if (mode > 6)
 		usage();
 
+	vector<int> modes(1, mode);		// the first mode is the one given as argument
+
 	// set default values
 
 	bool read_from_cache = false;
 	bool write_to_cache = false;
+	bool scaledDecoding = false;
 
 	argv += 4;	// skip the first 4 params
 	argc -= 4;	// skip the first 4 params
@@ -244,6 +265,22 @@ int run_extract(int argc, char *argv[])
 		{
 			case 'h': usage(); break;
 			case 'p': paramfile = argv[2]; n = 2; break;
+			case 's': scaledDecoding = true; break;
+			case 'm':
+			{
+				istringstream list(argv[2]);
+				string item;
+				while (getline(list, item, ','))
+				{
+					int other = atoi(item.c_str());
+					if ((other < 0) || (other > 6))
+						usage();
+					if (find(modes.begin(), modes.end(), other) == modes.end())
+						modes.push_back(other);
+				}
+				n = 2;
+				break;
+			}
 			default : cerr << "wrong argument: " << argv[1] << endl; usage(); break;
 		}
 		argv += n;
@@ -267,6 +304,10 @@ int run_extract(int argc, char *argv[])
 
 	CdvsConfiguration * cdvsconfig = CdvsConfiguration::cdvsConfigurationFactory(paramfile);	// if paramfile is NULL use default values
 	CdvsClient * cdvsclient = CdvsClient::cdvsClientFactory(cdvsconfig, mode);		// get a CDVS client instance
+	int minDecodedSize = 0;			// 0 = decode at full resolution
+	if (scaledDecoding)
+		for (size_t m = 0; m < modes.size(); ++m)		// the decoded image must be large enough for all modes
+			minDecodedSize = std::max(minDecodedSize, cdvsconfig->getParameters(modes[m]).resizeMaxSize);
 
 	// MAIN LOOP: scan all files in the list: //
 
@@ -281,19 +322,26 @@ int run_extract(int argc, char *argv[])
 		{
 			HiResTimer timer;
 			string image = manager.getAbsolutePathname(i);
-			string cdvs_descriptor = manager.replaceExt(image, cdvsconfig->getParameters(mode).modeExt);
 
 			try			// catch all errors locally
 			{
-				int width, height;
-				CdvsDescriptor output;
-				unsigned char * input = JpegReader::readJpeg(image.c_str(), width, height);	// read JPEG image
+				int width, height, originalWidth, originalHeight;
+				vector<CdvsDescriptor> outputs(1);
+				unsigned char * input = JpegReader::readJpeg(image.c_str(), width, height, originalWidth, originalHeight, minDecodedSize);	// read JPEG image
 
 				timer.start();							// start timer
-				size_t descriptor_length = cdvsclient->encode(output, width, height, input);
-				output.buffer.write(cdvs_descriptor.c_str());
+				if (modes.size() > 1)
+					cdvsclient->encodeMulti(outputs, modes, width, height, input, originalWidth, originalHeight);
+				else
+					cdvsclient->encode(outputs[0], width, height, input, originalWidth, originalHeight);
+
+				for (size_t m = 0; m < modes.size(); ++m)
+					outputs[m].buffer.write(manager.replaceExt(image, cdvsconfig->getParameters(modes[m]).modeExt).c_str());
 				timer.stop();							// stop timer
 
+				CdvsDescriptor & output = outputs[0];
+				size_t descriptor_length = output.buffer.size();
+
 				delete [] input;				// free memory
 
 				double duration = timer.elapsed();		// compute duration
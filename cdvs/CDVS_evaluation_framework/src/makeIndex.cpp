@@ -47,6 +47,8 @@ size_t n_images, n_descriptors;
 
 unsigned int modeId;
 const char * ext;
+const char * vocabularyTree = NULL;		// optional vocabulary tree used to index the images
+bool multiIndexHash = false;			// build the multi-index hash of the local descriptors
 
 
 /**                                                                                                                                
@@ -61,6 +63,9 @@ void mk_cdvs_index (const char *index,  CdvsServer * cdvsserver, const FileManag
 	cout << "start processing " << n_descriptors << " images" << endl;		// print a message
 	cdvsserver->createDB(modeId, n_descriptors);
 
+	if (vocabularyTree != NULL)
+		cdvsserver->loadVocabularyTree(vocabularyTree);		// the images will be indexed using this vocabulary
+
 	for (size_t i=0; i<n_descriptors; i++)
 	{
 		// read descriptor
@@ -85,6 +90,19 @@ void mk_cdvs_index (const char *index,  CdvsServer * cdvsserver, const FileManag
 	string indexName = index;
 	cdvsserver->storeDB((indexName + ".local").c_str(), (indexName + ".global").c_str());	// store the Data Base
 	cout << cdvsserver->sizeofDB() << " images stored in index file " << index << endl;
+
+	if (multiIndexHash)
+	{
+		cdvsserver->buildMultiIndexHash();
+		cdvsserver->storeMultiIndexHash((indexName + ".mih").c_str());	// store the multi-index hash
+		cout << "multi-index hash stored in index file " << indexName << ".mih" << endl;
+	}
+
+	if (vocabularyTree != NULL)
+	{
+		cdvsserver->storeVocabularyTree((indexName + ".vtree").c_str());	// store the vocabulary tree index
+		cout << "vocabulary tree index stored in index file " << indexName << ".vtree" << endl;
+	}
 }
 
 void usage()
@@ -92,13 +110,15 @@ void usage()
     fprintf (stdout,
 	  "CDVS database index generation module.\n"
 	  "usage:\n"
-	  "  makeIndex <images> <index> <mode> <datasetPath> <annotationPath> [-h]\n"
+	  "  makeIndex <images> <index> <mode> <datasetPath> <annotationPath> [-vtree file] [-mih] [-h]\n"
 	  "where:\n"
 	  "  images - database images (text file, 1 file name per line) to be indexed\n"
 	  "  index - name of index file (or multiple index files) to be generated\n"
 	  "  mode (0..n) - sets the encoding mode to use to build the database\n"
       "  dataset path - the root dir of the CDVS dataset of images\n"
       "  annotation path - the root dir of the CDVS annotation files\n"
+      "  -vtree file: index the images also with the vocabulary of the given vocabulary tree index file (the <index>.vtree file is created)\n"
+      "  -mih: build the multi-index hash of the local descriptors (the <index>.mih file is created)\n"
       "  -help or -h: help\n");
     exit (1);
 }
@@ -110,7 +130,7 @@ void usage()
 
   CDVS database index generation module.
 	usage:
-		makeIndex <images> <index> <mode> <datasetPath> <annotationPath> [-h]
+		makeIndex <images> <index> <mode> <datasetPath> <annotationPath> [-vtree file] [-mih] [-h]
 	where:
         images - database images (text file, 1 file name per line) to be indexed
         index - name of index file (or multiple index files) to be generated
@@ -118,6 +138,8 @@ void usage()
         dataset path - the root dir of the CDVS dataset of images
         annotation path - the root dir of the CDVS annotation files
    Options:
+        -vtree file: index the images also with the vocabulary of the given vocabulary tree index file (the <index>.vtree file is created)
+        -mih: build the multi-index hash of the local descriptors (the <index>.mih file is created)
         -help or -h: help
  
  @endverbatim
@@ -126,7 +148,7 @@ void usage()
 int run_make_index (int argc, char *argv[])
 {
   // argv 0      1        2        3		4			5
-  // makeIndex <images> <index> <mode> <datasetPath> <annotationPath> [-h]
+  // makeIndex <images> <index> <mode> <datasetPath> <annotationPath> [-vtree file] [-mih] [-h]
 
   /* check if sufficient # of arguments were provided: */
   if (argc < 6)
@@ -144,6 +166,12 @@ int run_make_index (int argc, char *argv[])
 		  /* display help: */
 		  usage();
 	  }
+	  else if (!strcmp (argv[i]+1,"vtree") && (i+1 < argc)) {
+		  vocabularyTree = argv[++i];
+	  }
+	  else if (!strcmp (argv[i]+1,"mih")) {
+		  multiIndexHash = true;
+	  }
 	  else {
 		  fprintf (stderr, "Invalid option: %s\n", argv[i]);
 		  exit (1);
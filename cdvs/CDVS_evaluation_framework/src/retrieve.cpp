@@ -225,6 +225,14 @@ int run_retrieve (int argc, char *argv[])
 	cdvsserver->loadDB(string(databasename).append(".local").c_str(), string(databasename).append(".global").c_str());
 	cout << cdvsserver->sizeofDB() << " images loaded." << endl;
 
+	/* load the vocabulary tree index, if used as a second source of candidates: */
+	if (cdvsconfig->getParameters(mode).vocabularyTreeCandidates > 0)
+		cdvsserver->loadVocabularyTree(string(databasename).append(".vtree").c_str());
+
+	/* load the multi-index hash, if used as a source of candidates: */
+	if (cdvsconfig->getParameters(mode).multiIndexHashCandidates > 0)
+		cdvsserver->loadMultiIndexHash(string(databasename).append(".mih").c_str());
+
 	/* zero counters: */
 	max_duration = average_duration = 0.;
 	max_descriptor_length = total_descriptor_length = 0;
@@ -253,12 +261,13 @@ int run_retrieve (int argc, char *argv[])
 
 		  CdvsDescriptor query;
 		  vector<RetrievalData> results;
+		  RetrievalStats stats;
 
 		  /* start timer: */
 		  timer.start();
 
 		  size_t qsize = cdvsserver->decode(query, dsc_fname.c_str());
-		  int n = cdvsserver->retrieve(results, query, MAX_MATCHES);
+		  int n = cdvsserver->retrieve(results, query, MAX_MATCHES, &stats);
 
 		  /* stop timer: */
 		  timer.stop();
@@ -285,7 +294,8 @@ int run_retrieve (int argc, char *argv[])
 		  total_descriptor_length += qsize;
 
 		  /* progress report: */
-		  fprintf (stdout, "[%4d/%4d]: %s -> %d matches found, %g [s]\n", i+1, nqueries, ground_truth[i]->query, n, duration);
+		  fprintf (stdout, "[%4d/%4d]: %s -> %d matches found, %g [s], %u/%u candidates verified (pruned: %u skipped, %u abandoned, %u without DISTRAT, %u prefiltered)\n",
+				  i+1, nqueries, ground_truth[i]->query, n, duration, stats.nVerified, stats.nCandidates, stats.nSkipped, stats.nAbandoned, stats.nDistratSkipped, stats.nPrefiltered);
 
 		  /* save query image and # of matches found */
 		  strcpy(retrieval_results[i]->query, ground_truth[i]->query);